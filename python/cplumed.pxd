@@ -27,11 +27,12 @@ from libcpp cimport bool
 
 # Some of these functions are noexcept.
 # We anyway use except + in case this changes later.
+# cmd is declared nogil so that Plumed.step can run a batch of frames with the GIL released.
 cdef extern from "Plumed.h" namespace "PLMD":
      cdef cppclass Plumed:
          Plumed() except +
-         void cmd(const char*key, const void*val) except +
-         void cmd(const char*key) except +
+         void cmd(const char*key, const void*val) except + nogil
+         void cmd(const char*key) except + nogil
          bool valid() except +
          @staticmethod
          Plumed dlopen(const char*path) except +
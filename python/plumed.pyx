@@ -37,9 +37,28 @@ except:
 
 cdef class Plumed:
      cdef cplumed.Plumed c_plumed
+     # encoded keys, so that repeated cmd calls do not encode the same string again
+     cdef dict keys
+     # arrays bound with register_buffers; references are kept so that they stay
+     # alive as long as PLUMED might access them
+     cdef dict buffers
+     cdef double* masses
+     cdef double* charges
+     cdef double* forces
+     cdef double* virial
+     cdef double* box
+     cdef Py_ssize_t natoms
      def __cinit__(self,kernel=None):
          cdef bytes py_kernel
          cdef char* ckernel
+         self.keys={}
+         self.buffers={}
+         self.masses=NULL
+         self.charges=NULL
+         self.forces=NULL
+         self.virial=NULL
+         self.box=NULL
+         self.natoms=-1
          if kernel is None:
             self.c_plumed=cplumed.Plumed.makeValid()
             if not self.c_plumed.valid():
@@ -62,8 +81,100 @@ cdef class Plumed:
          self.c_plumed.cmd( ckey, <void*>&val )
      cdef cmd_int(self, ckey, int val):
          self.c_plumed.cmd( ckey, <void*>&val)
+     cdef bytes encode_key(self, key):
+         cdef bytes py_bytes = self.keys.get(key)
+         if py_bytes is None:
+            py_bytes = key.encode()
+            self.keys[key] = py_bytes
+         return py_bytes
+     cdef double* bind_array(self, name, val, shape) except NULL:
+         if not HAS_NUMPY or not isinstance(val, np.ndarray):
+            raise ValueError(name + " should be a numpy ndarray")
+         if val.dtype!="float64" or not val.flags["C_CONTIGUOUS"]:
+            raise ValueError(name + " should be a C-contiguous float64 ndarray")
+         if shape[0]<0:
+            if self.natoms<0:
+               raise RuntimeError("setNatoms should be called before binding " + name)
+            shape=(self.natoms,)+shape[1:]
+         if val.shape!=shape:
+            raise ValueError(name + " should have shape " + str(shape) + ", found " + str(val.shape))
+         cdef double [::1] abuffer = val.reshape(-1)
+         self.buffers[name] = val
+         return &abuffer[0]
+     def register_buffers(self, masses=None, charges=None, forces=None, virial=None, box=None):
+         """Bind arrays that are passed to PLUMED at every call to step.
+
+         Arrays should be C-contiguous float64 ndarrays with shapes (natoms,) for masses
+         and charges, (natoms,3) for forces and (3,3) for virial and box. They are not
+         copied: PLUMED reads masses, charges and box from them and writes forces and
+         virial into them, so they can be inspected or modified in place between steps.
+         Arrays that are not passed keep their previous binding.
+         The number of atoms is the one passed to cmd("setNatoms"), which should be called first.
+         """
+         if masses is not None:
+            self.masses=self.bind_array("masses", masses, (-1,))
+         if charges is not None:
+            self.charges=self.bind_array("charges", charges, (-1,))
+         if forces is not None:
+            self.forces=self.bind_array("forces", forces, (-1,3))
+         if virial is not None:
+            self.virial=self.bind_array("virial", virial, (3,3))
+         if box is not None:
+            self.box=self.bind_array("box", box, (3,3))
+     def step(self, positions, boxes=None, long first_step=0):
+         """Run PLUMED on one frame or on a stack of frames and return the bias of each frame.
+
+         positions is a C-contiguous float64 ndarray with shape (natoms,3) or (nframes,natoms,3).
+         boxes, if present, has shape (nframes,3,3) and replaces the registered box.
+         Masses and forces should have been bound with register_buffers first.
+         For each frame the step number, box, masses, charges, positions, forces and virial
+         are set and calc is called, all without going back to the interpreter and with
+         the GIL released. Registered forces and virial are zeroed before each frame, as
+         the driver does, so that on return they hold the bias forces of the last frame.
+         """
+         if self.masses==NULL or self.forces==NULL:
+            raise RuntimeError("masses and forces should be registered with register_buffers before calling step")
+         if HAS_NUMPY and isinstance(positions, np.ndarray) and positions.ndim==2:
+            positions=positions.reshape((1,)+positions.shape)
+         cdef double [:,:,::1] pos = positions
+         cdef Py_ssize_t nframes = pos.shape[0]
+         if pos.shape[1]!=self.natoms or pos.shape[2]!=3:
+            raise ValueError("positions should have shape (nframes,{},3)".format(self.natoms))
+         cdef double [:,:,::1] bx
+         cdef bint has_boxes = boxes is not None
+         if has_boxes:
+            bx = boxes
+            if bx.shape[0]!=nframes or bx.shape[1]!=3 or bx.shape[2]!=3:
+               raise ValueError("boxes should have shape ({},3,3)".format(nframes))
+         bias = np.zeros(nframes)
+         cdef double [::1] pbias = bias
+         cdef Py_ssize_t i, j
+         cdef long istep
+         with nogil:
+            for i in range(nframes):
+               istep = first_step + i
+               for j in range(3*self.natoms):
+                  self.forces[j]=0.0
+               if self.virial!=NULL:
+                  for j in range(9):
+                     self.virial[j]=0.0
+               self.c_plumed.cmd( "setStepLong", &istep )
+               if has_boxes:
+                  self.c_plumed.cmd( "setBox", &bx[i,0,0] )
+               elif self.box!=NULL:
+                  self.c_plumed.cmd( "setBox", self.box )
+               self.c_plumed.cmd( "setMasses", self.masses )
+               if self.charges!=NULL:
+                  self.c_plumed.cmd( "setCharges", self.charges )
+               self.c_plumed.cmd( "setPositions", &pos[i,0,0] )
+               self.c_plumed.cmd( "setForces", self.forces )
+               if self.virial!=NULL:
+                  self.c_plumed.cmd( "setVirial", self.virial )
+               self.c_plumed.cmd( "calc" )
+               self.c_plumed.cmd( "getBias", &pbias[i] )
+         return bias
      def cmd( self, key, val=None ):
-         cdef bytes py_bytes = key.encode()
+         cdef bytes py_bytes = self.encode_key(key)
          cdef char* ckey = py_bytes
          cdef char* cval 
          cdef array.array ar
@@ -73,6 +184,9 @@ cdef class Plumed:
             if key=="getDataRank" :
                raise ValueError("when using cmd with getDataRank option value must a size one ndarray")
             self.cmd_int(ckey, val)
+            # used to check the shape of the arrays bound with register_buffers
+            if key=="setNatoms" :
+               self.natoms=val
          elif isinstance(val, float ) :
             if key=="getBias" :
                raise ValueError("when using cmd with getBias option value must be a size one ndarray")
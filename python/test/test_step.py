@@ -0,0 +1,62 @@
+# test of the persistent buffers and of the batched step call
+import numpy as np
+import plumed
+import os
+
+def test():
+
+    p = plumed.Plumed()
+    p.cmd("setNatoms",2)
+    p.cmd("setLogFile","test.log")
+    p.cmd("init")
+    p.cmd("readInputLine","d: DISTANCE ATOMS=1,2")
+    p.cmd("readInputLine","RESTRAINT ARG=d AT=0 KAPPA=1")
+
+    box=np.diag(10.0*np.ones(3))
+    virial=np.zeros((3,3))
+    masses=np.ones(2)
+    forces=np.zeros((2,3))
+    p.register_buffers(masses=masses, forces=forces, virial=virial, box=box)
+
+    traj=np.zeros((3,2,3))
+    traj[:,1,:]=np.array([[1,2,3],[1,0,0],[0,0,2]])
+
+    bias=p.step(traj)
+
+    assert (bias[0] - 7.0)**2<1e-8
+    assert (bias[1] - 0.5)**2<1e-8
+    assert (bias[2] - 2.0)**2<1e-8
+# forces refer to the last frame
+    assert (forces[0,2] - 2.0)**2<1e-8
+    assert (forces[1,2] + 2.0)**2<1e-8
+    assert (forces[0,0])**2<1e-8
+
+# a single frame with the registered box
+    bias=p.step(traj[0],first_step=3)
+    assert (bias[0] - 7.0)**2<1e-8
+    assert (forces[1,1] + 2.0)**2<1e-8
+
+# arrays should match the number of atoms passed to setNatoms and be contiguous
+    for bad in (np.zeros((3,3)), np.zeros((4,3))[::2], np.zeros((2,3),dtype=np.float32)):
+        try:
+            p.register_buffers(forces=bad)
+            assert False
+        except ValueError:
+            pass
+    for bad in (np.zeros((1,3,3)), np.zeros((1,4,3))[:,::2,:]):
+        try:
+            p.step(bad)
+            assert False
+        except ValueError:
+            pass
+
+# buffers cannot be bound before setNatoms
+    q = plumed.Plumed()
+    try:
+        q.register_buffers(masses=masses)
+        assert False
+    except RuntimeError:
+        pass
+
+if __name__ == "__main__":
+    test()
@@ -0,0 +1,57 @@
+#include "plumed/wrapper/Plumed.h"
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace PLMD;
+
+// Run a short simulation signaling a checkpoint at step 5.
+// The grid file is copied as soon as plumed returns from the checkpoint step,
+// so it should contain the bias at step 5 also when it is written in the background.
+void run(const std::string & name){
+  Plumed p;
+  int natoms=2;
+  p.cmd("setNatoms",&natoms);
+  p.cmd("setLogFile",("test."+name+".log").c_str());
+  p.cmd("setPlumedDat","plumed.dat");
+  p.cmd("init");
+
+  std::vector<double> positions(3*natoms,0.0);
+  std::vector<double> masses(natoms,1.0);
+  std::vector<double> forces(3*natoms,0.0);
+  std::vector<double> box(9,0.0);
+  std::vector<double> virial(9,0.0);
+
+  for(int step=0;step<12;step++){
+    positions[3]=1.0+0.2*step;
+    int cpt=(step==5);
+    p.cmd("setStep",&step);
+    p.cmd("setPositions",&positions[0]);
+    p.cmd("setBox",&box[0]);
+    p.cmd("setForces",&forces[0]);
+    p.cmd("setVirial",&virial[0]);
+    p.cmd("setMasses",&masses[0]);
+    p.cmd("doCheckPoint",&cpt);
+    p.cmd("calc");
+    if(cpt){
+      std::ifstream in("grid.dat");
+      std::ofstream out(("grid."+name+".cpt").c_str());
+      out<<in.rdbuf();
+    }
+  }
+}
+
+int main(){
+  run("async");
+// pending files are written when plumed is finalized
+  std::rename("grid.dat","grid.async.dat");
+
+// the environment variable is read when plumed is created
+  setenv("PLUMED_ASYNC_CHECKPOINT","no",1);
+  run("sync");
+  std::rename("grid.dat","grid.sync.dat");
+
+  return 0;
+}
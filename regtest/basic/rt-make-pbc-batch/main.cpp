@@ -0,0 +1,52 @@
+#include "plumed/tools/Pbc.h"
+#include "plumed/tools/Random.h"
+#include "plumed/tools/OFile.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace PLMD;
+
+// Compare the batched minimal image (both layouts) with the one computed
+// by Pbc::distance one vector at a time
+double maxDeviation(const Pbc&pbc,Random&random) {
+  const unsigned n=1000;
+  std::vector<Vector> d(n);
+  std::vector<double> dx(n), dy(n), dz(n);
+  for(unsigned k=0; k<n; k++) {
+    for(unsigned i=0; i<3; i++) d[k][i]=20.0*(random.RandU01()-0.5);
+    dx[k]=d[k][0]; dy[k]=d[k][1]; dz[k]=d[k][2];
+  }
+  std::vector<Vector> aos(d);
+  pbc.apply(aos);
+  pbc.apply(&dx[0],&dy[0],&dz[0],n);
+  double maxdev=0.0;
+  for(unsigned k=0; k<n; k++) {
+    Vector ref=pbc.distance(Vector(0.0,0.0,0.0),d[k]);
+    maxdev=std::max(maxdev,delta(ref,aos[k]).modulo());
+    maxdev=std::max(maxdev,delta(ref,Vector(dx[k],dy[k],dz[k])).modulo());
+  }
+  return maxdev;
+}
+
+int main() {
+  OFile out; out.open("output");
+  Random random; random.setSeed(-20190102);
+
+  Pbc pbc;
+  Tensor box;
+  out<<"no pbc agree "<<(maxDeviation(pbc,random)<1e-12)<<"\n";
+
+  box=Tensor(3.0,0.0,0.0,0.0,4.0,0.0,0.0,0.0,5.0);
+  pbc.setBox(box);
+  out<<"orthorombic agree "<<(maxDeviation(pbc,random)<1e-12)<<"\n";
+
+  box=Tensor(3.0,0.0,0.0,1.2,4.0,0.0,-0.7,1.5,5.0);
+  pbc.setBox(box);
+  out<<"triclinic agree "<<(maxDeviation(pbc,random)<1e-12)<<"\n";
+
+  box=Tensor(4.0,0.0,0.0,3.5,2.0,0.0,2.5,1.5,3.0);
+  pbc.setBox(box);
+  out<<"skewed triclinic agree "<<(maxDeviation(pbc,random)<1e-12)<<"\n";
+
+  return 0;
+}
@@ -0,0 +1,75 @@
+#include "plumed/tools/RMSD.h"
+#include "plumed/tools/Random.h"
+#include "plumed/tools/OFile.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace PLMD;
+
+// Compare the fixed-size Jacobi solver for the quaternion matrix with the LAPACK one,
+// both directly and through the RMSD workhorses that use it
+int main() {
+  OFile out; out.open("output");
+  Random random; random.setSeed(-20190101);
+
+  double maxevals=0.0, maxevecs=0.0;
+  for(unsigned itest=0; itest<1000; itest++) {
+    Tensor4d m;
+    for(unsigned i=0; i<4; i++) for(unsigned j=0; j<=i; j++) m[i][j]=m[j][i]=2.0*random.RandU01()-1.0;
+    Vector4d eval1, eval2; Tensor4d evec1, evec2;
+    // dsyevr overwrites its input, so each solver gets its own copy
+    Tensor4d m1(m), m2(m);
+    diagMatSym(m1,eval1,evec1);
+    diagMatSymJacobi(m2,eval2,evec2);
+    for(unsigned i=0; i<4; i++) {
+      maxevals=std::max(maxevals,std::fabs(eval1[i]-eval2[i]));
+      for(unsigned j=0; j<4; j++) maxevecs=std::max(maxevecs,std::fabs(evec1[i][j]-evec2[i][j]));
+    }
+    VectorGeneric<1> low1, low2; TensorGeneric<1,4> lvec1, lvec2;
+    m1=m; m2=m;
+    diagMatSym(m1,low1,lvec1);
+    diagMatSymJacobi(m2,low2,lvec2);
+    maxevals=std::max(maxevals,std::fabs(low1[0]-low2[0]));
+    for(unsigned j=0; j<4; j++) maxevecs=std::max(maxevecs,std::fabs(lvec1[0][j]-lvec2[0][j]));
+  }
+  out<<"eigenvalues agree "<<(maxevals<1e-10)<<"\n";
+  out<<"eigenvectors agree "<<(maxevecs<1e-8)<<"\n";
+
+  const unsigned natoms=50;
+  std::vector<Vector> reference(natoms), positions(natoms);
+  std::vector<double> align(natoms), displace(natoms);
+  for(unsigned i=0; i<natoms; i++) {
+    for(unsigned k=0; k<3; k++) reference[i][k]=random.RandU01();
+    for(unsigned k=0; k<3; k++) positions[i][k]=reference[i][k]+0.2*random.RandU01();
+    align[i]=random.RandU01(); displace[i]=random.RandU01();
+  }
+
+  double maxdist=0.0, maxderiv=0.0, maxrot=0.0;
+  for(unsigned itype=0; itype<2; itype++) {
+    RMSD rmsd;
+    // equal and different alignment/displacement weights use different code paths
+    rmsd.set(align,(itype==0?align:displace),reference,"OPTIMAL");
+    std::vector<Vector> der1, der2, dref, pos1, pos2, cpos, cref;
+    Tensor rot1, rot2;
+    Matrix<std::vector<Vector> > drot1(3,3), drot2(3,3);
+
+    RMSD::setUseLapack(true);
+    double d1=rmsd.calculate(positions,der1);
+    double p1=rmsd.calc_PCAelements(positions,dref,rot1,drot1,pos1,cpos,cref);
+    RMSD::setUseLapack(false);
+    double d2=rmsd.calculate(positions,der2);
+    double p2=rmsd.calc_PCAelements(positions,dref,rot2,drot2,pos2,cpos,cref);
+
+    maxdist=std::max(maxdist,std::max(std::fabs(d1-d2),std::fabs(p1-p2)));
+    for(unsigned i=0; i<natoms; i++) maxderiv=std::max(maxderiv,delta(der1[i],der2[i]).modulo());
+    for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) {
+        maxrot=std::max(maxrot,std::fabs(rot1[i][j]-rot2[i][j]));
+        for(unsigned k=0; k<natoms; k++) maxrot=std::max(maxrot,delta(drot1[i][j][k],drot2[i][j][k]).modulo());
+      }
+  }
+  out<<"rmsd agrees "<<(maxdist<1e-10)<<"\n";
+  out<<"derivatives agree "<<(maxderiv<1e-8)<<"\n";
+  out<<"rotation and its derivatives agree "<<(maxrot<1e-8)<<"\n";
+  out.close();
+  return 0;
+}
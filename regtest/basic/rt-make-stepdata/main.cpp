@@ -0,0 +1,88 @@
+#include "plumed/wrapper/Plumed.h"
+#include <vector>
+#include <fstream>
+#include <memory>
+
+using namespace PLMD;
+
+// the same simulation is run with the traditional interface (mode 0),
+// with setStepData (mode 1), and with setStepData with NULL pointers for masses and charges,
+// which are then set separately (mode 2)
+void run(int mode,std::ofstream & ofs) {
+  std::unique_ptr<Plumed> plumed(new Plumed);
+
+  int natoms=10;
+
+  std::vector<double> positions(3*natoms,0.0);
+  for(int i=0; i<3*natoms; i++) positions[i]=0.1*i*i;
+  std::vector<double> masses(natoms,1.0);
+  std::vector<double> charges(natoms,0.0);
+  std::vector<double> forces(3*natoms,0.0);
+  std::vector<double> box(9,0.0);
+  box[0]=box[4]=box[8]=5.0;
+  std::vector<double> virial(9,0.0);
+
+  plumed->cmd("setNatoms",&natoms);
+  plumed->cmd("setLogFile","test.log");
+  plumed->cmd("init");
+  plumed->cmd("readInputLine","d: DISTANCE ATOMS=1,2");
+  plumed->cmd("readInputLine","g: GYRATION ATOMS=1-10");
+  plumed->cmd("readInputLine","RESTRAINT ARG=d,g AT=0,0 KAPPA=1,2");
+
+  for(long int step=0; step<5; step++) {
+    for(auto & f:forces) f=0.0;
+    for(auto & v:virial) v=0.0;
+    positions[0]=0.1*step;
+    double bias=0.0;
+    if(mode==0) {
+      plumed->cmd("setStepLong",&step);
+      plumed->cmd("setBox",&box[0]);
+      plumed->cmd("setPositions",&positions[0]);
+      plumed->cmd("setMasses",&masses[0]);
+      plumed->cmd("setCharges",&charges[0]);
+      plumed->cmd("setForces",&forces[0]);
+      plumed->cmd("setVirial",&virial[0]);
+      plumed->cmd("calc");
+      plumed->cmd("getBias",&bias);
+    } else {
+      plumed_step_data data;
+      data.step=step;
+      data.box=&box[0];
+      data.positions=&positions[0];
+      data.masses=(mode==1 ? &masses[0] : NULL);
+      data.charges=(mode==1 ? &charges[0] : NULL);
+      data.forces=&forces[0];
+      data.virial=&virial[0];
+      data.energy=NULL;
+      plumed->cmd("setStepData",&data);
+      if(mode==2) {
+        plumed->cmd("setMasses",&masses[0]);
+        plumed->cmd("setCharges",&charges[0]);
+      }
+      plumed->cmd("calc");
+      plumed->cmd("getBias",&bias);
+    }
+    ofs<<"bias: "<<bias<<"\n";
+    ofs<<"f:";
+    for(auto & f:forces) ofs<<" "<<f;
+    ofs<<"\n";
+    ofs<<"v:";
+    for(auto & v:virial) ofs<<" "<<v;
+    ofs<<"\n";
+  }
+}
+
+int main() {
+  std::ofstream ofs("output");
+  int api=0;
+  {
+    Plumed plumed;
+    plumed.cmd("getApiVersion",&api);
+  }
+  ofs<<"api>=7: "<<(api>=7)<<"\n";
+  for(int mode=0; mode<3; mode++) {
+    ofs<<"mode "<<mode<<"\n";
+    run(mode,ofs);
+  }
+  return 0;
+}
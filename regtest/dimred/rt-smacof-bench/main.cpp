@@ -0,0 +1,53 @@
+#include "plumed/dimred/SMACOF.h"
+#include "plumed/tools/Random.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+using namespace PLMD;
+
+// Generate points on a noisy two dimensional surface embedded in five dimensions and a random initial projection
+void setup( const unsigned& M, Matrix<double>& weights, Matrix<double>& distances, Matrix<double>& projections ) {
+  Random random; random.setSeed(-1234);
+  Matrix<double> high( M, 5 );
+  for(unsigned i=0; i<M; ++i) {
+    double x=10*random.RandU01(), y=10*random.RandU01();
+    high(i,0)=x; high(i,1)=y; high(i,2)=sin(x); high(i,3)=cos(y); high(i,4)=0.1*random.RandU01();
+  }
+  weights.resize( M, M ); distances.resize( M, M ); projections.resize( M, 2 ); weights=1.0; distances=0.0;
+  for(unsigned i=0; i<M; ++i) {
+    weights(i,i)=0.0;
+    for(unsigned j=0; j<i; ++j) {
+      double d2=0; for(unsigned k=0; k<5; ++k) { double tmp=high(i,k)-high(j,k); d2+=tmp*tmp; }
+      distances(i,j)=distances(j,i)=sqrt(d2);
+    }
+    projections(i,0)=10*random.RandU01(); projections(i,1)=10*random.RandU01();
+  }
+}
+
+int main() {
+  std::ofstream ofs("output");
+  const unsigned M=300;
+  Matrix<double> weights, distances, projections, dists( M, M );
+
+  setup( M, weights, distances, projections );
+  double stress0=dimred::SMACOF::calculateSigma( weights, distances, projections, dists );
+  auto t0=std::chrono::high_resolution_clock::now();
+  unsigned niter=dimred::SMACOF::run( weights, distances, 1E-6, 1000, projections );
+  std::chrono::duration<double> dt=std::chrono::high_resolution_clock::now()-t0;
+  double stress1=dimred::SMACOF::calculateSigma( weights, distances, projections, dists );
+  std::cout<<"full smacof: "<<niter<<" iterations stress "<<stress0<<" -> "<<stress1<<" "<<niter/dt.count()<<" iterations per second\n";
+  ofs<<"full smacof reduces stress "<<( stress1<0.1*stress0 )<<"\n";
+
+  setup( M, weights, distances, projections ); Random random; random.setSeed(-4321);
+  t0=std::chrono::high_resolution_clock::now();
+  niter=dimred::SMACOF::runStochastic( weights, distances, 1E-6, 1000, 30, random, projections );
+  dt=std::chrono::high_resolution_clock::now()-t0;
+  double stress2=dimred::SMACOF::calculateSigma( weights, distances, projections, dists );
+  std::cout<<"stochastic smacof: "<<niter<<" iterations stress "<<stress2<<" "<<niter/dt.count()<<" iterations per second\n";
+  ofs<<"stochastic smacof reduces stress "<<( stress2<0.1*stress0 )<<"\n";
+  ofs<<"stochastic and full stress agree "<<( std::fabs(stress2-stress1)<0.05*stress1 )<<"\n";
+  return 0;
+}
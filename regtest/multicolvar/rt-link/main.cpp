@@ -1,5 +1,4 @@
 #include "mpi.h"
-#include "plumed/tools/Communicator.h"
 #include "plumed/tools/Tools.h"
 #include "plumed/tools/Vector.h"
 #include "plumed/tools/LinkCells.h"
@@ -25,8 +24,8 @@ int main(){
 
   std::ofstream ofs; ofs.open("logfile");
 
-  PLMD::Communicator comm; PLMD::Pbc mypbc; 
-  PLMD::LinkCells linkcells( comm ); 
+  PLMD::Pbc mypbc; 
+  PLMD::LinkCells linkcells; 
   linkcells.setCutoff( 4.0 );
   for(unsigned nx=1;nx<6;++nx){
       for(unsigned ny=1;ny<6;++ny){
@@ -78,8 +78,10 @@ AtomNumber ActionWithInputMatrix::getAbsoluteIndexOfCentralAtom(const unsigned&
 
 double ActionWithInputMatrix::retrieveConnectionValue( const unsigned& i, const unsigned& j, std::vector<double>& vals ) const {
   if( !mymatrix->matrixElementIsActive( i, j ) ) return 0;
-  unsigned myelem = mymatrix->getStoreIndexFromMatrixIndices( i, j );
+  return retrieveElementValue( mymatrix->getStoreIndexFromMatrixIndices( i, j ), vals );
+}
 
+double ActionWithInputMatrix::retrieveElementValue( const unsigned& myelem, std::vector<double>& vals ) const {
   // unsigned vi; double df;
   mymatrix->retrieveValueWithIndex( myelem, false, vals );
   return vals[0]*vals[1];       // (mymatrix->function)->transformStoredValues( vals, vi, df );
@@ -88,9 +90,11 @@ double ActionWithInputMatrix::retrieveConnectionValue( const unsigned& i, const
 void ActionWithInputMatrix::getInputData( const unsigned& ind, const bool& normed, const multicolvar::AtomValuePack& myatoms, std::vector<double>& orient0 ) const {
   if( (mymatrix->function)->mybasemulticolvars.size()==0  ) {
     std::vector<double> tvals( mymatrix->getNumberOfComponents() ); orient0.assign(orient0.size(),0);
-    for(unsigned i=0; i<mymatrix->getNumberOfColumns(); ++i) {
-      if( mymatrix->undirectedGraph() && ind==i ) continue;
-      orient0[1]+=retrieveConnectionValue( ind, i, tvals );
+    // Only the nonzero elements in the row are visited (there are no diagonal elements for undirected graphs)
+    unsigned jcol, myelem;
+    for(unsigned k=0; k<mymatrix->getNumberOfElementsInRow( ind ); ++k) {
+      mymatrix->getRowElement( ind, k, jcol, myelem );
+      orient0[1]+=retrieveElementValue( myelem, tvals );
     }
     orient0[0]=1.0; return;
   }
@@ -99,7 +103,10 @@ void ActionWithInputMatrix::getInputData( const unsigned& ind, const bool& norme
 
 void ActionWithInputMatrix::addConnectionDerivatives( const unsigned& i, const unsigned& j, MultiValue& myvals, MultiValue& myvout ) const {
   if( !mymatrix->matrixElementIsActive( i, j ) ) return;
-  unsigned myelem = mymatrix->getStoreIndexFromMatrixIndices( i, j );
+  addElementDerivatives( mymatrix->getStoreIndexFromMatrixIndices( i, j ), myvals, myvout );
+}
+
+void ActionWithInputMatrix::addElementDerivatives( const unsigned& myelem, MultiValue& myvals, MultiValue& myvout ) const {
   // Get derivatives and add
   mymatrix->retrieveDerivatives( myelem, false, myvals );
   for(unsigned jd=0; jd<myvals.getNumberActive(); ++jd) {
@@ -116,9 +123,10 @@ MultiValue& ActionWithInputMatrix::getInputDerivatives( const unsigned& ind, con
     }
     myder.clearAll();
     MultiValue myvals( (mymatrix->function)->getNumberOfQuantities(), (mymatrix->function)->getNumberOfDerivatives() );
-    for(unsigned i=0; i<mymatrix->getNumberOfColumns(); ++i) {
-      if( mymatrix->undirectedGraph() && ind==i ) continue;
-      addConnectionDerivatives( ind, i, myvals, myder );
+    unsigned jcol, myelem;
+    for(unsigned k=0; k<mymatrix->getNumberOfElementsInRow( ind ); ++k) {
+      mymatrix->getRowElement( ind, k, jcol, myelem );
+      addElementDerivatives( myelem, myvals, myder );
     }
     myder.updateDynamicList(); return myder;
   }
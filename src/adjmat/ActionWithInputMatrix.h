@@ -48,10 +48,14 @@ public:
   AdjacencyMatrixVessel* getAdjacencyVessel() const ;
 /// Retrieve the value of the connection
   double retrieveConnectionValue( const unsigned& i, const unsigned& j, std::vector<double>& vals ) const ;
+/// Retrieve the value of the connection from the index of the element of the matrix
+  double retrieveElementValue( const unsigned& myelem, std::vector<double>& vals ) const ;
 /// Get the vector for task ind
   virtual void getInputData( const unsigned& ind, const bool& normed, const multicolvar::AtomValuePack& myatoms, std::vector<double>& orient0 ) const ;
 /// Add the derivatives on a connection
   void addConnectionDerivatives( const unsigned& i, const unsigned& j, MultiValue& myvals, MultiValue& myvout ) const ;
+/// Add the derivatives on a connection from the index of the element of the matrix
+  void addElementDerivatives( const unsigned& myelem, MultiValue& myvals, MultiValue& myvout ) const ;
 /// Get vector derivatives
   virtual MultiValue& getInputDerivatives( const unsigned& ind, const bool& normed, const multicolvar::AtomValuePack& myatoms ) const ;
   virtual unsigned getNumberOfDerivatives();
@@ -22,6 +22,7 @@
 #include "AdjacencyMatrixVessel.h"
 #include "AdjacencyMatrixBase.h"
 #include "vesselbase/ActionWithVessel.h"
+#include <algorithm>
 
 namespace PLMD {
 namespace adjmat {
@@ -99,28 +100,6 @@ void AdjacencyMatrixVessel::retrieveMatrix( DynamicList<unsigned>& myactive_elem
   myactive_elements.updateActiveMembers();
 }
 
-void AdjacencyMatrixVessel::retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list ) {
-  plumed_dbg_assert( undirectedGraph() );
-  // Currently everything has zero neighbors
-  for(unsigned i=0; i<nneigh.size(); ++i) nneigh[i]=0;
-
-  // And set up the adjacency list
-  std::vector<double> myvals( getNumberOfComponents() );
-  for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
-    // Check if atoms are connected
-    retrieveSequentialValue( i, false, myvals );
-    if( myvals[0]<epsilon || myvals[1]<epsilon ) continue ;
-
-    unsigned j, k; getMatrixIndices( function->getPositionInFullTaskList(i), k, j );
-
-    if( nneigh[j]>=adj_list.ncols() || nneigh[k]>=adj_list.ncols() ) error("adjacency lists are not large enough, increase maxconnections");
-    // Store if atoms are connected
-    // unsigned j, k; getMatrixIndices( i, k, j );
-    adj_list(k,nneigh[k])=j; nneigh[k]++;
-    adj_list(j,nneigh[j])=k; nneigh[j]++;
-  }
-}
-
 void AdjacencyMatrixVessel::retrieveEdgeList( unsigned& nedge, std::vector<std::pair<unsigned,unsigned> >& edge_list ) {
   plumed_dbg_assert( undirectedGraph() ); nedge=0;
   std::vector<double> myvals( getNumberOfComponents() );
@@ -145,6 +124,45 @@ bool AdjacencyMatrixVessel::nodesAreConnected( const unsigned& iatom, const unsi
   return ( myvals[0]>epsilon && myvals[1]>epsilon );
 }
 
+void AdjacencyMatrixVessel::finish( const std::vector<double>& buffer ) {
+  StoreDataVessel::finish( buffer );
+
+  // Only the elements that survived the link cells are stored so this loop scales with the number of contacts
+  std::vector<unsigned> rows, cols, elems; std::vector<double> myvals( getNumberOfComponents() );
+  for(unsigned i=0; i<getNumberOfStoredValues(); ++i) {
+    retrieveSequentialValue( i, false, myvals );
+    if( myvals[0]<=epsilon ) continue ;
+
+    unsigned myelem=function->getPositionInFullTaskList(i), j, k; getMatrixIndices( myelem, k, j );
+    rows.push_back(k); cols.push_back(j); elems.push_back(myelem);
+    // Symmetric matrices only store one of the two equivalent elements
+    if( symmetric && j!=k ) { rows.push_back(j); cols.push_back(k); elems.push_back(myelem); }
+  }
+  buildCompressedStorage( getNumberOfRows(), rows, cols, elems, row_start, row_cols, row_elems );
+  buildCompressedStorage( getNumberOfColumns(), cols, rows, elems, col_start, col_rows, col_elems );
+}
+
+void AdjacencyMatrixVessel::buildCompressedStorage( const unsigned& nouter, const std::vector<unsigned>& outer, const std::vector<unsigned>& inner,
+    const std::vector<unsigned>& elems, std::vector<unsigned>& start,
+    std::vector<unsigned>& inner_out, std::vector<unsigned>& elems_out ) {
+  // Count the elements in each row (or column)
+  start.assign( nouter+1, 0 );
+  for(unsigned i=0; i<outer.size(); ++i) start[outer[i]+1]++;
+  for(unsigned i=0; i<nouter; ++i) start[i+1]+=start[i];
+
+  // Put the elements in place
+  std::vector<std::pair<unsigned,unsigned> > sorted( outer.size() );
+  std::vector<unsigned> next( start.begin(), start.end()-1 );
+  for(unsigned i=0; i<outer.size(); ++i) {
+    sorted[next[outer[i]]]=std::pair<unsigned,unsigned>( inner[i], elems[i] ); next[outer[i]]++;
+  }
+  // And order each row by column index so sums are done in the same order as with the full matrix
+  for(unsigned i=0; i<nouter; ++i) std::sort( sorted.begin()+start[i], sorted.begin()+start[i+1] );
+
+  inner_out.resize( sorted.size() ); elems_out.resize( sorted.size() );
+  for(unsigned i=0; i<sorted.size(); ++i) { inner_out[i]=sorted[i].first; elems_out[i]=sorted[i].second; }
+}
+
 double AdjacencyMatrixVessel::getCutoffForConnection() const {
   return function->getLinkCellCutoff();
 }
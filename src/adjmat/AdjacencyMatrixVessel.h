@@ -44,6 +44,16 @@ private:
   AdjacencyMatrixBase* function;
 /// Is the matrix symmetric and are we calculating hbonds
   bool symmetric, hbonds;
+/// Compressed sparse row storage for the nonzero elements of the matrix.
+/// The elements of row i are between row_start[i] and row_start[i+1] in
+/// row_cols (the column index) and row_elems (the index of the element)
+  std::vector<unsigned> row_start, row_cols, row_elems;
+/// The same as above but for the nonzero elements in each column
+  std::vector<unsigned> col_start, col_rows, col_elems;
+/// Sort a list of nonzero elements into compressed storage
+  static void buildCompressedStorage( const unsigned& nouter, const std::vector<unsigned>& outer, const std::vector<unsigned>& inner,
+                                      const std::vector<unsigned>& elems, std::vector<unsigned>& start,
+                                      std::vector<unsigned>& inner_out, std::vector<unsigned>& elems_out );
 public:
   static void registerKeywords( Keywords& keys );
 /// Constructor
@@ -56,8 +66,14 @@ public:
   unsigned getStoreIndexFromMatrixIndices( const unsigned& ielem, const unsigned& jelem ) const ;
 /// Get the adjacency matrix
   void retrieveMatrix( DynamicList<unsigned>& myactive_elements, Matrix<double>& mymatrix );
-/// Get the neighbour list based on the adjacency matrix
-  void retrieveAdjacencyLists( std::vector<unsigned>& nneigh, Matrix<unsigned>& adj_list );
+/// Get the number of nonzero elements in a row of the matrix
+  unsigned getNumberOfElementsInRow( const unsigned& irow ) const ;
+/// Get the column index and the index of the element for the k-th nonzero element in a row
+  void getRowElement( const unsigned& irow, const unsigned& k, unsigned& jcol, unsigned& myelem ) const ;
+/// Get the number of nonzero elements in a column of the matrix
+  unsigned getNumberOfElementsInColumn( const unsigned& jcol ) const ;
+/// Get the row index and the index of the element for the k-th nonzero element in a column
+  void getColumnElement( const unsigned& jcol, const unsigned& k, unsigned& irow, unsigned& myelem ) const ;
 /// Retrieve the list of edges in the adjacency matrix/graph
   void retrieveEdgeList( unsigned& nedge, std::vector<std::pair<unsigned,unsigned> >& edge_list );
 ///
@@ -76,8 +92,34 @@ public:
   double getCutoffForConnection() const ;
 ///
   Vector getNodePosition( const unsigned& taskIndex ) const ;
+/// Store the data and build the lists of nonzero elements in each row and column
+  void finish( const std::vector<double>& buffer );
 };
 
+inline
+unsigned AdjacencyMatrixVessel::getNumberOfElementsInRow( const unsigned& irow ) const {
+  plumed_dbg_assert( irow+1<row_start.size() );
+  return row_start[irow+1] - row_start[irow];
+}
+
+inline
+void AdjacencyMatrixVessel::getRowElement( const unsigned& irow, const unsigned& k, unsigned& jcol, unsigned& myelem ) const {
+  plumed_dbg_assert( k<getNumberOfElementsInRow( irow ) );
+  jcol=row_cols[row_start[irow]+k]; myelem=row_elems[row_start[irow]+k];
+}
+
+inline
+unsigned AdjacencyMatrixVessel::getNumberOfElementsInColumn( const unsigned& jcol ) const {
+  plumed_dbg_assert( jcol+1<col_start.size() );
+  return col_start[jcol+1] - col_start[jcol];
+}
+
+inline
+void AdjacencyMatrixVessel::getColumnElement( const unsigned& jcol, const unsigned& k, unsigned& irow, unsigned& myelem ) const {
+  plumed_dbg_assert( k<getNumberOfElementsInColumn( jcol ) );
+  irow=col_rows[col_start[jcol]+k]; myelem=col_elems[col_start[jcol]+k];
+}
+
 }
 }
 #endif
@@ -62,13 +62,23 @@ void ClusteringBase::calculate() {
   performClustering();
   // Order the clusters in the system by size (this returns ascending order )
   std::sort( cluster_sizes.begin(), cluster_sizes.end() );
+  // And store the atoms in each cluster so they can be retrieved without searching all the nodes
+  std::vector<unsigned> position( cluster_sizes.size() );
+  cluster_start.resize( cluster_sizes.size()+1 ); cluster_start[0]=0;
+  for(unsigned i=0; i<cluster_sizes.size(); ++i) {
+    position[cluster_sizes[i].second]=i;
+    cluster_start[i+1]=cluster_start[i]+cluster_sizes[i].first;
+  }
+  std::vector<unsigned> next( cluster_start.begin(), cluster_start.end()-1 );
+  cluster_atoms.resize( which_cluster.size() );
+  for(unsigned i=0; i<which_cluster.size(); ++i) {
+    unsigned k=position[which_cluster[i]]; cluster_atoms[next[k]]=i; next[k]++;
+  }
 }
 
 void ClusteringBase::retrieveAtomsInCluster( const unsigned& clust, std::vector<unsigned>& myatoms ) const {
-  unsigned n=0; myatoms.resize( cluster_sizes[cluster_sizes.size() - clust].first );
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( which_cluster[i]==cluster_sizes[cluster_sizes.size() - clust].second ) { myatoms[n]=i; n++; }
-  }
+  unsigned k=cluster_sizes.size() - clust;
+  myatoms.assign( cluster_atoms.begin()+cluster_start[k], cluster_atoms.begin()+cluster_start[k+1] );
 }
 
 bool ClusteringBase::areConnected( const unsigned& iatom, const unsigned& jatom ) const {
@@ -36,6 +36,11 @@ protected:
   int number_of_cluster;
 /// Vector that identifies the cluster each atom belongs to
   std::vector<unsigned> which_cluster;
+private:
+/// The atoms in each cluster (ordered as in cluster_sizes)
+  std::vector<unsigned> cluster_atoms;
+/// Where the list of atoms for each cluster starts in cluster_atoms
+  std::vector<unsigned> cluster_start;
 public:
 /// Create manual
   static void registerKeywords( Keywords& keys );
@@ -22,12 +22,9 @@
 #include "ClusteringBase.h"
 #include "AdjacencyMatrixVessel.h"
 #include "core/ActionRegister.h"
-
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-#include <boost/graph/adjacency_list.hpp>
-#include <boost/graph/connected_components.hpp>
-#include <boost/graph/graph_utility.hpp>
-#endif
+#include "tools/OpenMP.h"
+#include <algorithm>
+#include <atomic>
 
 //+PLUMEDOC MATRIXF DFSCLUSTERING
 /*
@@ -41,6 +38,12 @@ a depth first search clustering to find the connected components of this graph.
 
 https://en.wikipedia.org/wiki/Depth-first_search
 
+The connected components are actually found with a union-find (disjoint set) algorithm that works directly on the list of
+edges in the graph.  Edges are merged in parallel when PLUMED is running with multiple OpenMP threads.  Furthermore, the
+list of edges is compared with the one from the previous step and only the clusters that lost an edge are rebuilt.  When
+only a few connections change from one step to the next the clustering is thus much cheaper than a full search.  The
+clusters found are identical to those that would be obtained with a depth first search.
+
 This action is useful if you are looking at a phenomenon such as nucleation where the aim is to detect the sizes of the crystalline nuclei that have formed
 in your simulation cell.
 
@@ -69,19 +72,27 @@ namespace adjmat {
 
 class DFSClustering : public ClusteringBase {
 private:
-#ifdef __PLUMED_HAS_BOOST_GRAPH
+/// The maximum number of edges that can be stored (zero means no limit)
+  unsigned maxedges;
 /// The list of edges in the graph
   std::vector<std::pair<unsigned,unsigned> > edge_list;
-#else
-/// The number of neighbors each atom has
-  std::vector<unsigned> nneigh;
-/// The adjacency list
-  Matrix<unsigned> adj_list;
-/// The color that tells us whether a node has been visited
-  std::vector<unsigned> color;
-/// The recursive function at the heart of this method
-  int explore( const unsigned& index );
-#endif
+/// The sorted list of edges that was used on the previous step
+  std::vector<std::pair<unsigned,unsigned> > old_edges;
+/// The edges that have been added since the previous step
+  std::vector<std::pair<unsigned,unsigned> > new_edges;
+/// The parent of each node in the union-find forest.  The root of each
+/// tree is always the node with the lowest index in the cluster.
+  std::vector<std::atomic<unsigned> > parent;
+/// The nodes whose clusters have to be rebuilt
+  std::vector<bool> reset;
+/// Has the forest been built at least once
+  bool firststep;
+/// Find the root of the tree that contains a node (with path halving)
+  unsigned findRoot( unsigned index );
+/// Merge the trees containing two nodes
+  void linkNodes( unsigned i, unsigned j );
+/// Merge the trees for a list of edges, possibly in parallel
+  void linkEdges( const std::vector<std::pair<unsigned,unsigned> >& edges, const unsigned& n, const bool& onlyreset );
 public:
 /// Create manual
   static void registerKeywords( Keywords& keys );
@@ -103,59 +114,100 @@ void DFSClustering::registerKeywords( Keywords& keys ) {
 
 DFSClustering::DFSClustering(const ActionOptions&ao):
   Action(ao),
-  ClusteringBase(ao)
+  ClusteringBase(ao),
+  firststep(true)
 {
   unsigned maxconnections; parse("MAXCONNECT",maxconnections);
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-  if( maxconnections>0 ) edge_list.resize( getNumberOfNodes()*maxconnections );
-  else edge_list.resize(0.5*getNumberOfNodes()*(getNumberOfNodes()-1));
-#else
-  nneigh.resize( getNumberOfNodes() ); color.resize(getNumberOfNodes());
-  if( maxconnections>0 ) adj_list.resize(getNumberOfNodes(),maxconnections);
-  else adj_list.resize(getNumberOfNodes(),getNumberOfNodes());
-#endif
+  maxedges=getNumberOfNodes()*maxconnections;
+  std::vector<std::atomic<unsigned> >( getNumberOfNodes() ).swap( parent );
+  reset.resize( getNumberOfNodes() );
 }
 
-void DFSClustering::performClustering() {
-#ifdef __PLUMED_HAS_BOOST_GRAPH
-  // Get the list of edges
-  unsigned nedges=0; getAdjacencyVessel()->retrieveEdgeList( nedges, edge_list );
-
-  // Build the graph using boost
-  boost::adjacency_list<boost::vecS,boost::vecS,boost::undirectedS> sg(&edge_list[0],&edge_list[nedges],getNumberOfNodes());
-
-  // Find the connected components using boost (-1 here for compatibility with non-boost version)
-  number_of_cluster=boost::connected_components(sg,&which_cluster[0]) - 1;
-
-  // And work out the size of each cluster
-  for(unsigned i=0; i<which_cluster.size(); ++i) cluster_sizes[which_cluster[i]].first++;
-#else
-  // Get the adjacency matrix
-  getAdjacencyVessel()->retrieveAdjacencyLists( nneigh, adj_list );
-
-  // Perform clustering
-  number_of_cluster=-1; color.assign(color.size(),0);
-  for(unsigned i=0; i<getNumberOfNodes(); ++i) {
-    if( color[i]==0 ) { number_of_cluster++; color[i]=explore(i); }
+unsigned DFSClustering::findRoot( unsigned index ) {
+  unsigned p=parent[index].load(std::memory_order_relaxed);
+  while( p!=index ) {
+    // Path halving.  Parents only ever decrease so a failed exchange is harmless
+    unsigned gp=parent[p].load(std::memory_order_relaxed);
+    if( gp!=p ) { unsigned expected=p; parent[index].compare_exchange_weak( expected, gp, std::memory_order_relaxed ); }
+    index=p; p=gp;
   }
-#endif
+  return index;
 }
 
-#ifndef __PLUMED_HAS_BOOST_GRAPH
-int DFSClustering::explore( const unsigned& index ) {
+void DFSClustering::linkNodes( unsigned i, unsigned j ) {
+  while( true ) {
+    i=findRoot(i); j=findRoot(j);
+    if( i==j ) return;
+    // Always attach the root with the larger index so no cycles can form
+    if( i<j ) std::swap(i,j);
+    unsigned expected=i;
+    if( parent[i].compare_exchange_strong( expected, j ) ) return;
+  }
+}
 
-  color[index]=1;
-  for(unsigned i=0; i<nneigh[index]; ++i) {
-    unsigned j=adj_list(index,i);
-    if( color[j]==0 ) color[j]=explore(j);
+void DFSClustering::linkEdges( const std::vector<std::pair<unsigned,unsigned> >& edges, const unsigned& n, const bool& onlyreset ) {
+  unsigned nt=OpenMP::getNumThreads();
+  if( nt*100>n ) nt=1;
+  #pragma omp parallel for num_threads(nt)
+  for(unsigned i=0; i<n; ++i) {
+    if( onlyreset && !reset[edges[i].first] && !reset[edges[i].second] ) continue;
+    linkNodes( edges[i].first, edges[i].second );
   }
+}
 
-  // Count the size of the cluster
-  cluster_sizes[number_of_cluster].first++;
-  which_cluster[index] = number_of_cluster;
-  return color[index];
+void DFSClustering::performClustering() {
+  // Get the list of edges
+  unsigned needed=getAdjacencyVessel()->getNumberOfStoredValues();
+  if( maxedges>0 && needed>maxedges ) needed=maxedges;
+  if( edge_list.size()<needed ) edge_list.resize( needed );
+  unsigned nedges=0; getAdjacencyVessel()->retrieveEdgeList( nedges, edge_list );
+  for(unsigned i=0; i<nedges; ++i) {
+    if( edge_list[i].first>edge_list[i].second ) std::swap( edge_list[i].first, edge_list[i].second );
+  }
+  std::sort( edge_list.begin(), edge_list.begin()+nedges );
+
+  if( firststep ) {
+    // Build the whole forest from scratch
+    for(unsigned i=0; i<parent.size(); ++i) parent[i].store(i);
+    linkEdges( edge_list, nedges, false );
+    firststep=false;
+  } else {
+    // Find the edges that were added and those that were removed
+    new_edges.resize(0); reset.assign( reset.size(), false );
+    std::vector<std::pair<unsigned,unsigned> >::const_iterator iold=old_edges.begin(), inew=edge_list.begin(), enew=edge_list.begin()+nedges;
+    bool removed=false;
+    while( iold!=old_edges.end() || inew!=enew ) {
+      if( inew==enew || ( iold!=old_edges.end() && *iold<*inew ) ) {
+        // The parents are fully compressed after the previous step so this marks the roots of the broken clusters
+        reset[parent[iold->first].load()]=true; removed=true; ++iold;
+      } else if( iold==old_edges.end() || *inew<*iold ) {
+        new_edges.push_back( *inew ); ++inew;
+      } else { ++iold; ++inew; }
+    }
+    // Any cluster that lost an edge is broken into isolated nodes and rebuilt from the current edges
+    if( removed ) {
+      for(unsigned i=0; i<parent.size(); ++i) {
+        if( reset[parent[i].load()] ) reset[i]=true;
+      }
+      for(unsigned i=0; i<parent.size(); ++i) {
+        if( reset[i] ) parent[i].store(i);
+      }
+      linkEdges( edge_list, nedges, true );
+    }
+    // And merge the clusters that are connected by the new edges
+    linkEdges( new_edges, new_edges.size(), false );
+  }
+  old_edges.assign( edge_list.begin(), edge_list.begin()+nedges );
+
+  // Compress all the paths and number the clusters in order of their lowest index node
+  number_of_cluster=-1;
+  for(unsigned i=0; i<parent.size(); ++i) {
+    unsigned p=parent[parent[i].load()].load(); parent[i].store(p);
+    if( p==i ) { number_of_cluster++; which_cluster[i]=number_of_cluster; }
+    else which_cluster[i]=which_cluster[p];
+    cluster_sizes[which_cluster[i]].first++;
+  }
 }
-#endif
 
 }
 }
@@ -101,18 +101,19 @@ MatrixColumnSums::MatrixColumnSums(const ActionOptions& ao):
 
 double MatrixColumnSums::compute( const unsigned& tinded, multicolvar::AtomValuePack& myatoms ) const {
   double sum=0.0; std::vector<double> tvals( mymatrix->getNumberOfComponents() );
-  unsigned nrows = mymatrix->getNumberOfRows();
-  for(unsigned i=0; i<nrows; ++i) {
-    if( mymatrix->undirectedGraph() && tinded==i ) continue;
-    sum+=retrieveConnectionValue( i, tinded, tvals );
+  // Only the nonzero elements in the column are visited (there are no diagonal elements for undirected graphs)
+  unsigned irow, myelem;
+  for(unsigned k=0; k<mymatrix->getNumberOfElementsInColumn( tinded ); ++k) {
+    mymatrix->getColumnElement( tinded, k, irow, myelem );
+    sum+=retrieveElementValue( myelem, tvals );
   }
 
   if( !doNotCalculateDerivatives() ) {
     MultiValue myvals( mymatrix->getNumberOfComponents(), myatoms.getNumberOfDerivatives() );
     MultiValue& myvout=myatoms.getUnderlyingMultiValue();
-    for(unsigned i=0; i<nrows; ++i) {
-      if( mymatrix->isSymmetric() && tinded==i ) continue ;
-      addConnectionDerivatives( i, tinded, myvals, myvout );
+    for(unsigned k=0; k<mymatrix->getNumberOfElementsInColumn( tinded ); ++k) {
+      mymatrix->getColumnElement( tinded, k, irow, myelem );
+      addElementDerivatives( myelem, myvals, myvout );
     }
   }
   return sum;
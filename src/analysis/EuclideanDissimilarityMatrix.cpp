@@ -21,6 +21,8 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "AnalysisBase.h"
 #include "tools/PDB.h"
+#include "tools/OpenMP.h"
+#include "tools/PackedSymmetricMatrix.h"
 #include "core/ActionRegister.h"
 #include "reference/MetricRegister.h"
 #include "reference/ReferenceConfiguration.h"
@@ -29,6 +31,13 @@
 /*
 Calculate the matrix of dissimilarities between a trajectory of atomic configurations.
 
+Unless LOWMEM is used the full matrix of dissimilarities is computed the first time
+any of its elements is required.  The calculation is split into square tiles of frames
+that are distributed over the MPI processes and the OpenMP threads, and only
+the upper triangle of the (symmetric) matrix is stored.  If the SINGLE_PRECISION
+flag is used this triangle is stored in single precision, which halves the memory
+needed for large numbers of frames.
+
 \par Examples
 
 */
@@ -41,7 +50,17 @@ class EuclideanDissimilarityMatrix : public AnalysisBase {
 private:
   PDB mypdb;
   std::string mtype;
-  Matrix<double> dissimilarities;
+/// The number of frames in each of the tiles that are computed together
+  unsigned blocksize;
+/// Are we storing the dissimilarities in single precision
+  bool single_precision;
+/// Have the dissimilarities been computed
+  bool computed;
+/// The upper triangle of the dissimilarity matrix
+  PackedSymmetricMatrix<double> dissimilarities;
+  PackedSymmetricMatrix<float> fdissimilarities;
+/// Compute all the elements of the dissimilarity matrix
+  void computeAllDissimilarities();
 public:
   static void registerKeywords( Keywords& keys );
   EuclideanDissimilarityMatrix( const ActionOptions& ao );
@@ -63,11 +82,16 @@ void EuclideanDissimilarityMatrix::registerKeywords( Keywords& keys ) {
   AnalysisBase::registerKeywords( keys ); keys.use("ARG"); keys.reset_style("ARG","optional");
   keys.add("compulsory","METRIC","EUCLIDEAN","the method that you are going to use to measure the distances between points");
   keys.add("atoms","ATOMS","the list of atoms that you are going to use in the measure of distance that you are using");
+  keys.add("compulsory","BLOCK_SIZE","64","the number of frames in each of the square tiles that the matrix of dissimilarities is computed in");
+  keys.addFlag("SINGLE_PRECISION",false,"store the matrix of dissimilarities in single precision");
 }
 
 EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions& ao ):
   Action(ao),
-  AnalysisBase(ao)
+  AnalysisBase(ao),
+  blocksize(64),
+  single_precision(false),
+  computed(false)
 {
   parse("METRIC",mtype); std::vector<AtomNumber> atoms;
   if( my_input_data->getNumberOfAtoms()>0 ) {
@@ -92,6 +116,12 @@ EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions&
     }
   }
   log.printf("  measuring distances using %s metric \n",mtype.c_str() );
+  parse("BLOCK_SIZE",blocksize); parseFlag("SINGLE_PRECISION",single_precision);
+  if( blocksize==0 ) error("BLOCK_SIZE should be greater than zero");
+  if( !usingLowMem() ) {
+    log.printf("  computing dissimilarities in tiles of %u frames \n",blocksize);
+    if( single_precision ) log.printf("  storing dissimilarities in single precision \n");
+  }
   if( my_input_data->getArgumentNames().size()>0 ) {
     if( getNumberOfArguments()==0 && atoms.size()==0 ) {
       std::vector<std::string> argnames( my_input_data->getArgumentNames() );
@@ -114,10 +144,50 @@ EuclideanDissimilarityMatrix::EuclideanDissimilarityMatrix( const ActionOptions&
 }
 
 void EuclideanDissimilarityMatrix::performAnalysis() {
-  // Resize dissimilarities matrix and set all elements to zero
+  // Resize dissimilarities matrix.  The elements are only computed when they are first required
+  computed=false;
   if( !usingLowMem() ) {
-    dissimilarities.resize( getNumberOfDataPoints(), getNumberOfDataPoints() ); dissimilarities=0;
+    if( single_precision ) { fdissimilarities.resize( getNumberOfDataPoints() ); fdissimilarities=0; }
+    else { dissimilarities.resize( getNumberOfDataPoints() ); dissimilarities=0; }
+  }
+}
+
+void EuclideanDissimilarityMatrix::computeAllDissimilarities() {
+  unsigned N=getNumberOfDataPoints();
+  // Create all the reference configurations once.  This must be done serially as the pdb is shared.
+  std::vector<std::unique_ptr<ReferenceConfiguration> > myrefs( N );
+  for(unsigned i=0; i<N; ++i) {
+    getStoredData( i, true ).transferDataToPDB( mypdb );
+    myrefs[i]=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
+  }
+
+  // Get the list of tiles in the upper triangle that this rank is responsible for
+  unsigned nblocks=( N + blocksize - 1 ) / blocksize;
+  std::vector<std::pair<unsigned,unsigned> > mytiles;
+  unsigned stride=comm.Get_size(), rank=comm.Get_rank(), k=0;
+  for(unsigned ib=0; ib<nblocks; ++ib) {
+    for(unsigned jb=ib; jb<nblocks; ++jb) {
+      if( (k++)%stride==rank ) mytiles.push_back( std::pair<unsigned,unsigned>( ib, jb ) );
+    }
+  }
+
+  const std::vector<Value*>& myargs( getArguments() ); const Pbc& mypbc( getPbc() );
+  #pragma omp parallel for schedule(dynamic) num_threads(OpenMP::getNumThreads())
+  for(unsigned t=0; t<mytiles.size(); ++t) {
+    unsigned istart=mytiles[t].first*blocksize, iend=std::min( N, istart + blocksize );
+    unsigned jstart=mytiles[t].second*blocksize, jend=std::min( N, jstart + blocksize );
+    for(unsigned i=istart; i<iend; ++i) {
+      for(unsigned j=std::max(jstart,i+1); j<jend; ++j) {
+        double dd=distance( mypbc, myargs, myrefs[i].get(), myrefs[j].get(), true );
+        if( single_precision ) fdissimilarities(i,j)=dd;
+        else dissimilarities(i,j)=dd;
+      }
+    }
   }
+  // And merge the tiles computed on the various ranks
+  if( single_precision ) comm.Sum( fdissimilarities.getVector() );
+  else comm.Sum( dissimilarities.getVector() );
+  computed=true;
 }
 
 std::string EuclideanDissimilarityMatrix::getDissimilarityInstruction() const {
@@ -127,17 +197,16 @@ std::string EuclideanDissimilarityMatrix::getDissimilarityInstruction() const {
 double EuclideanDissimilarityMatrix::getDissimilarity( const unsigned& iframe, const unsigned& jframe ) {
   plumed_dbg_assert( iframe<getNumberOfDataPoints() && jframe<getNumberOfDataPoints() );
   if( !usingLowMem() ) {
-    if( dissimilarities(iframe,jframe)>0. ) { return dissimilarities(iframe,jframe); }
+    if( !computed ) computeAllDissimilarities();
+    if( single_precision ) return fdissimilarities(iframe,jframe);
+    return dissimilarities(iframe,jframe);
   }
   if( iframe!=jframe ) {
-    double dd;
     getStoredData( iframe, true ).transferDataToPDB( mypdb );
     auto myref1=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
     getStoredData( jframe, true ).transferDataToPDB( mypdb );
     auto myref2=metricRegister().create<ReferenceConfiguration>(mtype, mypdb);
-    if( !usingLowMem() ) dd=dissimilarities(iframe,jframe) = dissimilarities(jframe,iframe) = distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    else dd=distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
-    return dd;
+    return distance( getPbc(), getArguments(), myref1.get(), myref2.get(), true );
   }
   return 0.0;
 }
@@ -482,14 +482,12 @@ void Histogram::compute( const unsigned& current, MultiValue& myvals ) const {
     if( in_apply ) myvals.updateDynamicList();
   } else {
     plumed_assert( !in_apply );
-    std::vector<std::unique_ptr<Value>> vv( myhist->getVectorOfValues() );
     std::vector<double> val( getNumberOfArguments() ), der( getNumberOfArguments() );
     // Retrieve the location of the grid point at which we are evaluating the kernel
     mygrid->getGridPointCoordinates( current, val );
     if( kernel ) {
-      for(unsigned i=0; i<getNumberOfArguments(); ++i) vv[i]->set( val[i] );
       // Evaluate the histogram at the relevant grid point and set the values
-      double vvh = kernel->evaluate( Tools::unique2raw(vv), der,true); myvals.setValue( 1, vvh );
+      double vvh = kernel->evaluate( val.data(), myhist->getPeriods().data(), der.data(), true ); myvals.setValue( 1, vvh );
     } else {
       plumed_merror("normalisation of vectors does not work with arguments and spherical grids");
       // Evalulate dot product
@@ -499,7 +497,7 @@ void Histogram::compute( const unsigned& current, MultiValue& myvals ) const {
       // And final derivatives
       for(unsigned j=0; j<getNumberOfArguments(); ++j) der[j] *= (myhist->von_misses_concentration)*newval;
     }
-    // Set the derivatives and delete the vector of values
+    // Set the derivatives
     for(unsigned i=0; i<getNumberOfArguments(); ++i) { myvals.setDerivative( 1, i, der[i] ); }
   }
 }
@@ -0,0 +1,115 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_bench_Bench_h
+#define __PLUMED_bench_Bench_h
+
+#include <string>
+#include <vector>
+
+namespace PLMD {
+namespace bench {
+
+/**
+\ingroup TOOLBOX
+State of a running micro-benchmark.
+
+The body of a benchmark prepares its input and then runs the timed loop as
+\verbatim
+while(state.keepRunning()) {
+  ... code to be timed ...
+}
+\endverbatim
+The driver decides how many iterations are needed to obtain a meaningful timing.
+Only the time spent inside the loop is measured.
+*/
+class State {
+  friend class Runner;
+/// Number of iterations requested by the driver
+  unsigned long iterations;
+/// Number of iterations already performed
+  unsigned long done;
+/// Number of items processed in a single iteration
+  double items;
+/// Free text reported together with the result
+  std::string label;
+/// Start and stop times, in ns
+  double start,stop;
+  explicit State(unsigned long iterations);
+public:
+/// Returns true as long as the timed loop should continue.
+/// Starts the timer at the first call and stops it at the last one
+  bool keepRunning();
+/// Number of iterations that will be performed
+  unsigned long getIterations() const {
+    return iterations;
+  }
+/// Set the number of items (e.g. distances, kernels) processed in one iteration.
+/// It is used to report a throughput
+  void setItemsPerIteration(double n) {
+    items=n;
+  }
+/// Attach a short description to the result (e.g. "asmjit")
+  void setLabel(const std::string&l) {
+    label=l;
+  }
+};
+
+/// Signature of a benchmark body
+typedef void (*Function)(State&);
+
+/// Register a benchmark with a given name. Use it through PLUMED_BENCHMARK
+class Register {
+public:
+  Register(const std::string&name,Function f);
+};
+
+/// A registered benchmark
+struct Entry {
+  std::string name;
+  Function f;
+};
+
+/// List of all the registered benchmarks, in registration order
+std::vector<Entry> & registered();
+
+/// Prevent the compiler from optimizing away the calculation of a value
+template<class T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T* sink;
+  sink=&value;
+#endif
+}
+
+}
+}
+
+/// Define and register a benchmark called name. It should be followed by the
+/// body of the benchmark, which receives a PLMD::bench::State& called state
+#define PLUMED_BENCHMARK(name) \
+  static void plumed_bench_##name(PLMD::bench::State&); \
+  static PLMD::bench::Register plumed_bench_register_##name(#name,plumed_bench_##name); \
+  static void plumed_bench_##name(PLMD::bench::State& state)
+
+#endif
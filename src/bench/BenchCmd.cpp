@@ -0,0 +1,102 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "core/PlumedMain.h"
+#include "wrapper/Plumed.h"
+
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const int natoms=64;
+
+/// A small system with a cheap bias, so that the time is dominated
+/// by the interface between the MD code and plumed
+class System {
+public:
+  PlumedMain p;
+  std::vector<double> positions,masses,charges,forces;
+  double box[9];
+  double virial[9];
+  double bias;
+  System():
+    positions(3*natoms),
+    masses(natoms,1.0),
+    charges(natoms,0.0),
+    forces(3*natoms,0.0),
+    box{4.0,0.0,0.0,0.0,4.0,0.0,0.0,0.0,4.0},
+    virial{0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0,0.0},
+    bias(0.0)
+  {
+    for(int i=0; i<3*natoms; i++) positions[i]=0.01*i;
+    int n=natoms;
+    int precision=sizeof(double);
+    p.cmd("setRealPrecision",&precision);
+    p.cmd("setNatoms",&n);
+    p.cmd("setLogFile","/dev/null");
+    p.cmd("init");
+    p.cmd("readInputLine","d: DISTANCE ATOMS=1,2");
+    p.cmd("readInputLine","RESTRAINT ARG=d AT=0 KAPPA=1");
+  }
+};
+
+}
+
+PLUMED_BENCHMARK(Cmd_step_strings) {
+  System s;
+  long int step=0;
+  while(state.keepRunning()) {
+    s.p.cmd("setStepLong",&step);
+    s.p.cmd("setBox",s.box);
+    s.p.cmd("setPositions",&s.positions[0]);
+    s.p.cmd("setMasses",&s.masses[0]);
+    s.p.cmd("setCharges",&s.charges[0]);
+    s.p.cmd("setForces",&s.forces[0]);
+    s.p.cmd("setVirial",s.virial);
+    s.p.cmd("calc");
+    s.p.cmd("getBias",&s.bias);
+    step++;
+  }
+  state.setItemsPerIteration(1);
+}
+
+PLUMED_BENCHMARK(Cmd_step_setStepData) {
+  System s;
+  plumed_step_data data;
+  data.box=s.box;
+  data.positions=&s.positions[0];
+  data.masses=&s.masses[0];
+  data.charges=&s.charges[0];
+  data.forces=&s.forces[0];
+  data.virial=s.virial;
+  data.energy=NULL;
+  data.step=0;
+  while(state.keepRunning()) {
+    s.p.cmd("setStepData",&data);
+    s.p.cmd("calc");
+    s.p.cmd("getBias",&s.bias);
+    data.step++;
+  }
+  state.setItemsPerIteration(1);
+}
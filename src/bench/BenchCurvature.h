@@ -0,0 +1,73 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_bench_BenchCurvature_h
+#define __PLUMED_bench_BenchCurvature_h
+
+#include "Bench.h"
+
+#include <cmath>
+#include <vector>
+
+namespace PLMD {
+namespace bench {
+
+/// Number of triplets evaluated in one iteration of the curvature benchmarks
+const unsigned ncurvature=1024;
+
+/// Triplets of consecutive points on circles of different radii,
+/// stored as ncurvature blocks of nine coordinates
+inline std::vector<double> curvatureTriplets() {
+  std::vector<double> x(9*ncurvature);
+  const double dt=2*M_PI/30;
+  for(unsigned i=0; i<ncurvature; i++) {
+    double r=1.0+0.01*i;
+    double t0=i*0.1;
+    for(unsigned k=0; k<3; k++) {
+      x[9*i+3*k+0]=r*std::cos(t0+k*dt);
+      x[9*i+3*k+1]=r*std::sin(t0+k*dt);
+      x[9*i+3*k+2]=0.1*k;
+    }
+  }
+  return x;
+}
+
+/// Time radius and gradient of a sympy-generated curvature kernel taking the three positions
+template<class R,class G>
+void curvaturePositions(State&state,R radius,G grad) {
+  std::vector<double> x=curvatureTriplets();
+  double g1[3],g2[3],g3[3];
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<ncurvature; i++) {
+      const double* p=&x[9*i];
+      double r=radius(p[0],p[1],p[2],p[3],p[4],p[5],p[6],p[7],p[8]);
+      grad(p[0],p[1],p[2],p[3],p[4],p[5],p[6],p[7],p[8],g1,g2,g3);
+      doNotOptimize(r);
+      doNotOptimize(g1[0]);
+    }
+  }
+  state.setItemsPerIteration(ncurvature);
+}
+
+}
+}
+
+#endif
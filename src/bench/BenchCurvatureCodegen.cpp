@@ -0,0 +1,65 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "BenchCurvature.h"
+
+namespace PLMD {
+namespace bench {
+
+// sympy-generated kernels, as used by the curvature_codegen module
+namespace curvature_plain {
+#include "curvature_codegen/sympy_codegen/curvature_codegen.c"
+}
+
+namespace curvature_dist {
+#include "curvature_codegen/sympy_codegen/curvature_codegen_dist.c"
+}
+
+}
+}
+
+using namespace PLMD;
+
+PLUMED_BENCHMARK(Curvature_codegen_plain) {
+  bench::curvaturePositions(state,bench::curvature_plain::curvature_radius,bench::curvature_plain::curvature_radius_grad);
+}
+
+PLUMED_BENCHMARK(Curvature_codegen_dist) {
+  std::vector<double> x=bench::curvatureTriplets();
+  std::vector<double> d(9*bench::ncurvature);
+// the distance-based kernel takes r_12, r_13 and r_23
+  for(unsigned i=0; i<bench::ncurvature; i++) for(unsigned j=0; j<3; j++) {
+      d[9*i+j]=x[9*i+3+j]-x[9*i+j];
+      d[9*i+3+j]=x[9*i+6+j]-x[9*i+j];
+      d[9*i+6+j]=x[9*i+6+j]-x[9*i+3+j];
+    }
+  double g[9];
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<bench::ncurvature; i++) {
+      const double* p=&d[9*i];
+      double r=bench::curvature_dist::curvature_radius_dist(p[0],p[1],p[2],p[3],p[4],p[5],p[6],p[7],p[8]);
+      bench::curvature_dist::curvature_radius_grad_dist(p[0],p[1],p[2],p[3],p[4],p[5],p[6],p[7],p[8],g);
+      bench::doNotOptimize(r);
+      bench::doNotOptimize(g[0]);
+    }
+  }
+  state.setItemsPerIteration(bench::ncurvature);
+}
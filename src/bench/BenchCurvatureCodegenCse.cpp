@@ -0,0 +1,40 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "BenchCurvature.h"
+
+namespace PLMD {
+namespace bench {
+
+// sympy-generated kernels with common subexpression elimination.
+// They have the same names as the plain ones, so they are kept in a separate file
+namespace curvature_cse {
+#include "curvature_codegen/sympy_codegen/curvature_codegen_cse.c"
+}
+
+}
+}
+
+using namespace PLMD;
+
+PLUMED_BENCHMARK(Curvature_codegen_cse) {
+  bench::curvaturePositions(state,bench::curvature_cse::curvature_radius,bench::curvature_cse::curvature_radius_grad);
+}
@@ -0,0 +1,80 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "tools/Grid.h"
+#include "tools/Random.h"
+#include "tools/Tools.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const unsigned npoints=1024;
+
+/// Spline interpolation on a dim-dimensional grid filled with a smooth periodic function
+void spline(bench::State&state,unsigned dim,unsigned nbin) {
+  std::vector<std::string> names(dim),gmin(dim,"-pi"),gmax(dim,"pi"),pmin(dim,"-pi"),pmax(dim,"pi");
+  for(unsigned i=0; i<dim; i++) names[i]="x"+std::to_string(i);
+  std::vector<unsigned> nbins(dim,nbin);
+  std::vector<bool> isperiodic(dim,true);
+  Grid grid("bench",names,gmin,gmax,nbins,true,true,true,isperiodic,pmin,pmax);
+  std::vector<double> x(dim),der(dim);
+  for(Grid::index_t i=0; i<grid.getSize(); i++) {
+    grid.getPoint(i,x);
+    double f=1.0;
+    for(unsigned j=0; j<dim; j++) {
+      f*=std::cos(x[j]);
+      der[j]=-std::sin(x[j]);
+    }
+    for(unsigned j=0; j<dim; j++) der[j]*=f/std::cos(x[j]);
+    grid.setValueAndDerivatives(i,f,der);
+  }
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<std::vector<double> > points(npoints,std::vector<double>(dim));
+  for(auto & p : points) for(auto & c : p) c=(2.0*rnd.RandU01()-1.0)*pi;
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<npoints; i++) {
+      double f=grid.getValueAndDerivatives(points[i],der);
+      bench::doNotOptimize(f);
+      bench::doNotOptimize(der[0]);
+    }
+  }
+  state.setItemsPerIteration(npoints);
+}
+
+}
+
+PLUMED_BENCHMARK(Grid_getValueAndDerivatives_spline_1d) {
+  spline(state,1,200);
+}
+
+PLUMED_BENCHMARK(Grid_getValueAndDerivatives_spline_2d) {
+  spline(state,2,100);
+}
+
+PLUMED_BENCHMARK(Grid_getValueAndDerivatives_spline_3d) {
+  spline(state,3,30);
+}
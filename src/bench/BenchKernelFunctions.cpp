@@ -0,0 +1,70 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "tools/KernelFunctions.h"
+#include "tools/Random.h"
+#include "tools/Tools.h"
+
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const unsigned npoints=1024;
+
+void evaluate(bench::State&state,unsigned dim,const std::string&type,bool periodic) {
+  std::vector<double> center(dim,0.0),sigma(dim,0.3);
+  KernelFunctions kernel(center,sigma,type,"DIAGONAL",1.0);
+  std::vector<double> period(dim,periodic?2.0*pi:0.0);
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<double> points(npoints*dim);
+  for(auto & p : points) p=(2.0*rnd.RandU01()-1.0)*pi;
+  std::vector<double> der(dim);
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<npoints; i++) {
+      double f=kernel.evaluate(&points[i*dim],period.data(),der.data());
+      bench::doNotOptimize(f);
+      bench::doNotOptimize(der[0]);
+    }
+  }
+  state.setItemsPerIteration(npoints);
+}
+
+}
+
+PLUMED_BENCHMARK(KernelFunctions_evaluate_gaussian_1d) {
+  evaluate(state,1,"GAUSSIAN",false);
+}
+
+PLUMED_BENCHMARK(KernelFunctions_evaluate_gaussian_2d_periodic) {
+  evaluate(state,2,"GAUSSIAN",true);
+}
+
+PLUMED_BENCHMARK(KernelFunctions_evaluate_gaussian_3d) {
+  evaluate(state,3,"GAUSSIAN",false);
+}
+
+PLUMED_BENCHMARK(KernelFunctions_evaluate_triangular_2d) {
+  evaluate(state,2,"TRIANGULAR",false);
+}
@@ -0,0 +1,105 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "lepton/Lepton.h"
+#include "tools/Random.h"
+
+#include <map>
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const unsigned npoints=1024;
+
+/// Evaluate a compiled one-variable expression and its derivative.
+/// Whether asmjit is used is decided when plumed is configured, so
+/// the two variants are obtained by running the suite on two builds
+void compiled(bench::State&state,const std::string&func) {
+  lepton::ParsedExpression pe=lepton::Parser::parse(func).optimize(lepton::Constants());
+  lepton::CompiledExpression expression=pe.createCompiledExpression();
+  lepton::CompiledExpression derivative=pe.differentiate("x").optimize(lepton::Constants()).createCompiledExpression();
+  double* xe=&expression.getVariableReference("x");
+  double* xd=&derivative.getVariableReference("x");
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<double> x(npoints);
+  for(auto & v : x) v=2.0*rnd.RandU01();
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<npoints; i++) {
+      *xe=x[i];
+      *xd=x[i];
+      double f=expression.evaluate();
+      double df=derivative.evaluate();
+      bench::doNotOptimize(f);
+      bench::doNotOptimize(df);
+    }
+  }
+  state.setItemsPerIteration(npoints);
+#ifdef __PLUMED_HAS_ASMJIT
+  state.setLabel("asmjit");
+#else
+  state.setLabel("no-asmjit");
+#endif
+}
+
+/// Evaluate the same expression walking the parsed tree, for reference
+void parsed(bench::State&state,const std::string&func) {
+  lepton::ParsedExpression pe=lepton::Parser::parse(func).optimize(lepton::Constants());
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<double> x(npoints);
+  for(auto & v : x) v=2.0*rnd.RandU01();
+  std::map<std::string,double> vars;
+  vars["x"]=0.0;
+  double & xv(vars["x"]);
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<npoints; i++) {
+      xv=x[i];
+      double f=pe.evaluate(vars);
+      bench::doNotOptimize(f);
+    }
+  }
+  state.setItemsPerIteration(npoints);
+}
+
+const std::string rational="(1-x^6)/(1-x^12)";
+const std::string mixed="exp(-x^2)*cos(3*x)+log(1+x)/(1+x^4)";
+
+}
+
+PLUMED_BENCHMARK(Lepton_CompiledExpression_evaluate_rational) {
+  compiled(state,rational);
+}
+
+PLUMED_BENCHMARK(Lepton_CompiledExpression_evaluate_mixed) {
+  compiled(state,mixed);
+}
+
+PLUMED_BENCHMARK(Lepton_ParsedExpression_evaluate_rational) {
+  parsed(state,rational);
+}
+
+PLUMED_BENCHMARK(Lepton_ParsedExpression_evaluate_mixed) {
+  parsed(state,mixed);
+}
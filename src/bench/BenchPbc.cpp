@@ -0,0 +1,102 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "tools/Pbc.h"
+#include "tools/Random.h"
+#include "tools/Tensor.h"
+
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const unsigned npairs=1024;
+
+/// Random pairs of positions spread over a few periodic images of the box
+void randomPairs(std::vector<Vector>&a,std::vector<Vector>&b) {
+  Random rnd;
+  rnd.setSeed(-1);
+  a.resize(npairs);
+  b.resize(npairs);
+  for(unsigned i=0; i<npairs; i++) for(unsigned j=0; j<3; j++) {
+      a[i][j]=6.0*rnd.RandU01()-1.0;
+      b[i][j]=6.0*rnd.RandU01()-1.0;
+    }
+}
+
+void distances(bench::State&state,const Tensor&box) {
+  Pbc pbc;
+  pbc.setBox(box);
+  std::vector<Vector> a,b;
+  randomPairs(a,b);
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<npairs; i++) {
+      Vector d=pbc.distance(a[i],b[i]);
+      bench::doNotOptimize(d);
+    }
+  }
+  state.setItemsPerIteration(npairs);
+}
+
+}
+
+PLUMED_BENCHMARK(Pbc_distance_orthorhombic) {
+  distances(state,Tensor(2.0,0.0,0.0,0.0,2.5,0.0,0.0,0.0,3.0));
+}
+
+PLUMED_BENCHMARK(Pbc_distance_generic) {
+  distances(state,Tensor(2.0,0.0,0.0,0.6,2.5,0.0,0.4,-0.7,3.0));
+}
+
+namespace {
+
+/// Minimal image of a batch of distances stored as separate components
+template<typename T>
+void batch(bench::State&state,const Tensor&box) {
+  Pbc pbc;
+  pbc.setBox(box);
+  std::vector<Vector> a,b;
+  randomPairs(a,b);
+  std::vector<T> x0(npairs),y0(npairs),z0(npairs);
+  for(unsigned i=0; i<npairs; i++) {
+    Vector d=b[i]-a[i];
+    x0[i]=d[0]; y0[i]=d[1]; z0[i]=d[2];
+  }
+  std::vector<T> x(npairs),y(npairs),z(npairs);
+  while(state.keepRunning()) {
+    x=x0; y=y0; z=z0;
+    pbc.apply(&x[0],&y[0],&z[0],npairs);
+    bench::doNotOptimize(x[0]);
+  }
+  state.setItemsPerIteration(npairs);
+}
+
+}
+
+PLUMED_BENCHMARK(Pbc_apply_orthorhombic_double) {
+  batch<double>(state,Tensor(2.0,0.0,0.0,0.0,2.5,0.0,0.0,0.0,3.0));
+}
+
+PLUMED_BENCHMARK(Pbc_apply_orthorhombic_float) {
+  batch<float>(state,Tensor(2.0,0.0,0.0,0.0,2.5,0.0,0.0,0.0,3.0));
+}
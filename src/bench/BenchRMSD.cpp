@@ -0,0 +1,59 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "tools/RMSD.h"
+#include "tools/Random.h"
+
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+void optimal(bench::State&state,unsigned natoms) {
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<Vector> reference(natoms),positions(natoms),derivatives(natoms);
+  for(unsigned i=0; i<natoms; i++) {
+    for(unsigned j=0; j<3; j++) reference[i][j]=2.0*rnd.RandU01();
+    positions[i]=reference[i]+0.1*Vector(rnd.Gaussian(),rnd.Gaussian(),rnd.Gaussian());
+  }
+  std::vector<double> weights(natoms,1.0/natoms);
+  RMSD rmsd;
+  rmsd.set(weights,weights,reference,"OPTIMAL");
+  while(state.keepRunning()) {
+    double r=rmsd.calculate(positions,derivatives);
+    bench::doNotOptimize(r);
+    bench::doNotOptimize(derivatives[0]);
+  }
+  state.setItemsPerIteration(natoms);
+}
+
+}
+
+PLUMED_BENCHMARK(RMSD_optimalAlignment_22) {
+  optimal(state,22);
+}
+
+PLUMED_BENCHMARK(RMSD_optimalAlignment_1000) {
+  optimal(state,1000);
+}
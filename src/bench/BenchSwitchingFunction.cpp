@@ -0,0 +1,79 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "tools/Exception.h"
+#include "tools/Random.h"
+#include "tools/SwitchingFunction.h"
+
+#include <vector>
+
+using namespace PLMD;
+
+namespace {
+
+const unsigned ndist=1024;
+
+void calculateSqr(bench::State&state,const std::string&definition) {
+  SwitchingFunction sf;
+  std::string errors;
+  sf.set(definition,errors);
+  plumed_massert(errors.length()==0,"problem reading switching function: "+errors);
+  Random rnd;
+  rnd.setSeed(-1);
+  std::vector<double> d2(ndist);
+  for(auto & d : d2) {
+    double d1=1.2*rnd.RandU01();
+    d=d1*d1;
+  }
+  while(state.keepRunning()) {
+    for(unsigned i=0; i<ndist; i++) {
+      double dfunc;
+      double f=sf.calculateSqr(d2[i],dfunc);
+      bench::doNotOptimize(f);
+      bench::doNotOptimize(dfunc);
+    }
+  }
+  state.setItemsPerIteration(ndist);
+  state.setLabel(definition);
+}
+
+}
+
+PLUMED_BENCHMARK(SwitchingFunction_calculateSqr_rational) {
+  calculateSqr(state,"RATIONAL R_0=0.3 D_MAX=1.0");
+}
+
+PLUMED_BENCHMARK(SwitchingFunction_calculateSqr_rational_odd) {
+  calculateSqr(state,"RATIONAL R_0=0.3 NN=7 MM=13 D_MAX=1.0");
+}
+
+PLUMED_BENCHMARK(SwitchingFunction_calculateSqr_exp) {
+  calculateSqr(state,"EXP R_0=0.3 D_MAX=1.0");
+}
+
+PLUMED_BENCHMARK(SwitchingFunction_calculateSqr_custom) {
+  calculateSqr(state,"CUSTOM FUNC=1/(1+x2^3) R_0=0.3 D_MAX=1.0");
+}
+
+PLUMED_BENCHMARK(SwitchingFunction_calculateSqr_custom_table) {
+  calculateSqr(state,"CUSTOM FUNC=1/(1+x2^3) R_0=0.3 D_MAX=1.0 TABLE=2000");
+}
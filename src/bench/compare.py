@@ -0,0 +1,70 @@
+#! /usr/bin/env python3
+
+"""Compare two result files written by plumed-bench --json.
+
+For every benchmark present in both files the ratio between the new and the
+baseline median time is reported. A benchmark is flagged as a regression when
+it is slower than the baseline by more than the threshold and the difference
+is larger than the spread of the two measurements. The exit status is 1 if
+at least one regression is found, so that the script can be used in scripts.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(filename):
+    with open(filename) as f:
+        data = json.load(f)
+    return data["context"], {b["name"]: b for b in data["benchmarks"]}
+
+
+def spread(b):
+    # standard deviation of the repetitions, 0 if only one was performed
+    return b.get("stddev", 0.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("baseline", help="json file with the reference results")
+    parser.add_argument("current", help="json file with the new results")
+    parser.add_argument("--threshold", type=float, default=0.1,
+                        help="relative slowdown that is considered a regression (default 0.1)")
+    args = parser.parse_args()
+
+    ctx0, base = load(args.baseline)
+    ctx1, curr = load(args.current)
+
+    for key in ("plumed_version", "compiler", "asmjit"):
+        if ctx0.get(key) != ctx1.get(key):
+            print("note: %s differs: %s -> %s" % (key, ctx0.get(key), ctx1.get(key)))
+
+    print("%-48s %14s %14s %9s" % ("benchmark", "baseline(ns)", "current(ns)", "ratio"))
+    regressions = []
+    for name in sorted(set(base) | set(curr)):
+        if name not in curr:
+            print("%-48s %14.3f %14s %9s" % (name, base[name]["median"], "-", "missing"))
+            continue
+        if name not in base:
+            print("%-48s %14s %14.3f %9s" % (name, "-", curr[name]["median"], "new"))
+            continue
+        b = base[name]
+        c = curr[name]
+        ratio = c["median"] / b["median"]
+        flag = ""
+        if ratio > 1.0 + args.threshold and c["median"] - b["median"] > spread(b) + spread(c):
+            flag = "REGRESSION"
+            regressions.append(name)
+        elif ratio < 1.0 - args.threshold and b["median"] - c["median"] > spread(b) + spread(c):
+            flag = "improved"
+        print("%-48s %14.3f %14.3f %9.3f %s" % (name, b["median"], c["median"], ratio, flag))
+
+    if regressions:
+        print("%d regression(s) above %g%%" % (len(regressions), 100 * args.threshold))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,241 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Bench.h"
+#include "config/Config.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+using namespace std;
+
+namespace PLMD {
+namespace bench {
+
+static double now() {
+  return std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+State::State(unsigned long iterations):
+  iterations(iterations),
+  done(0),
+  items(0.0),
+  start(0.0),
+  stop(0.0)
+{
+}
+
+bool State::keepRunning() {
+  if(done==0) start=now();
+  if(done<iterations) {
+    done++;
+    return true;
+  }
+  stop=now();
+  return false;
+}
+
+std::vector<Entry> & registered() {
+  static std::vector<Entry> list;
+  return list;
+}
+
+Register::Register(const std::string&name,Function f) {
+  Entry e;
+  e.name=name;
+  e.f=f;
+  registered().push_back(e);
+}
+
+/// Result of a single benchmark
+struct Result {
+  std::string name;
+  std::string label;
+  unsigned long iterations;
+/// Time per iteration for each repetition, in ns
+  std::vector<double> times;
+  double items;
+  double mean,median,stddev,min;
+};
+
+/// Drives the registered benchmarks
+class Runner {
+  double minTime;
+  unsigned repetitions;
+public:
+  Runner(double minTime,unsigned repetitions):
+    minTime(minTime),
+    repetitions(repetitions)
+  {}
+/// Run f once with a given number of iterations and return the state
+  State runOnce(Function f,unsigned long n) {
+    State state(n);
+    f(state);
+    if(state.done!=n) {
+      std::fprintf(stderr,"benchmark did not run its loop to completion\n");
+      std::exit(1);
+    }
+    return state;
+  }
+  Result run(const Entry&e) {
+    Result r;
+    r.name=e.name;
+// find a number of iterations such that a repetition lasts at least minTime
+    unsigned long n=1;
+    while(true) {
+      State s=runOnce(e.f,n);
+      double t=s.stop-s.start;
+      if(t>=minTime*1e9 || n>=1000000000UL) break;
+      double factor=(t>0.0?1.4*minTime*1e9/t:100.0);
+      if(factor>100.0) factor=100.0;
+      if(factor<2.0) factor=2.0;
+      n=static_cast<unsigned long>(n*factor);
+    }
+    r.iterations=n;
+    r.items=0.0;
+    for(unsigned i=0; i<repetitions; i++) {
+      State s=runOnce(e.f,n);
+      r.times.push_back((s.stop-s.start)/n);
+      r.items=s.items;
+      r.label=s.label;
+    }
+    std::vector<double> sorted(r.times);
+    std::sort(sorted.begin(),sorted.end());
+    unsigned m=sorted.size();
+    r.median=(m%2==1?sorted[m/2]:0.5*(sorted[m/2-1]+sorted[m/2]));
+    r.min=sorted[0];
+    r.mean=0.0;
+    for(const auto & t : sorted) r.mean+=t;
+    r.mean/=m;
+    r.stddev=0.0;
+    for(const auto & t : sorted) r.stddev+=(t-r.mean)*(t-r.mean);
+    r.stddev=(m>1?std::sqrt(r.stddev/(m-1)):0.0);
+    return r;
+  }
+};
+
+static void writeJson(const std::string&file,const std::vector<Result>&results,double minTime,unsigned repetitions) {
+  std::ofstream ofs(file.c_str());
+  if(!ofs) {
+    std::fprintf(stderr,"cannot open %s\n",file.c_str());
+    std::exit(1);
+  }
+  char date[64];
+  std::time_t t=std::time(nullptr);
+  std::strftime(date,sizeof(date),"%Y-%m-%dT%H:%M:%S",std::localtime(&t));
+  ofs.precision(10);
+  ofs<<"{\n";
+  ofs<<"  \"context\": {\n";
+  ofs<<"    \"date\": \""<<date<<"\",\n";
+  ofs<<"    \"plumed_version\": \""<<config::getVersionLong()<<"\",\n";
+#ifdef __VERSION__
+  ofs<<"    \"compiler\": \""<<__VERSION__<<"\",\n";
+#endif
+#ifdef __PLUMED_HAS_ASMJIT
+  ofs<<"    \"asmjit\": true,\n";
+#else
+  ofs<<"    \"asmjit\": false,\n";
+#endif
+  ofs<<"    \"min_time\": "<<minTime<<",\n";
+  ofs<<"    \"repetitions\": "<<repetitions<<"\n";
+  ofs<<"  },\n";
+  ofs<<"  \"benchmarks\": [\n";
+  for(unsigned i=0; i<results.size(); i++) {
+    const Result & r(results[i]);
+    ofs<<"    {\n";
+    ofs<<"      \"name\": \""<<r.name<<"\",\n";
+    ofs<<"      \"label\": \""<<r.label<<"\",\n";
+    ofs<<"      \"iterations\": "<<r.iterations<<",\n";
+    ofs<<"      \"time_unit\": \"ns\",\n";
+    ofs<<"      \"median\": "<<r.median<<",\n";
+    ofs<<"      \"mean\": "<<r.mean<<",\n";
+    ofs<<"      \"stddev\": "<<r.stddev<<",\n";
+    ofs<<"      \"min\": "<<r.min<<",\n";
+    ofs<<"      \"items_per_second\": "<<(r.items>0.0?r.items*1e9/r.median:0.0)<<",\n";
+    ofs<<"      \"times\": [";
+    for(unsigned j=0; j<r.times.size(); j++) ofs<<(j>0?", ":"")<<r.times[j];
+    ofs<<"]\n";
+    ofs<<"    }"<<(i+1<results.size()?",":"")<<"\n";
+  }
+  ofs<<"  ]\n";
+  ofs<<"}\n";
+}
+
+static void usage(const char* name) {
+  std::fprintf(stderr,"Usage: %s [--list] [--filter substring] [--min-time seconds] [--repetitions n] [--json file]\n",name);
+}
+
+}
+}
+
+using namespace PLMD::bench;
+
+int main(int argc,char**argv) {
+  std::string filter;
+  std::string json;
+  double minTime=0.1;
+  unsigned repetitions=5;
+  bool list=false;
+  for(int i=1; i<argc; i++) {
+    std::string a(argv[i]);
+    if(a=="--list") list=true;
+    else if(a=="--filter" && i+1<argc) filter=argv[++i];
+    else if(a=="--min-time" && i+1<argc) minTime=std::atof(argv[++i]);
+    else if(a=="--repetitions" && i+1<argc) repetitions=std::atoi(argv[++i]);
+    else if(a=="--json" && i+1<argc) json=argv[++i];
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if(repetitions<1) repetitions=1;
+
+  std::vector<Entry> entries;
+  for(const auto & e : registered()) if(e.name.find(filter)!=std::string::npos) entries.push_back(e);
+  std::sort(entries.begin(),entries.end(),[](const Entry&a,const Entry&b) {
+    return a.name<b.name;
+  });
+
+  if(list) {
+    for(const auto & e : entries) std::printf("%s\n",e.name.c_str());
+    return 0;
+  }
+
+  Runner runner(minTime,repetitions);
+  std::vector<Result> results;
+  std::printf("%-48s %12s %14s %10s %14s\n","benchmark","iterations","median(ns)","cv(%)","items/s");
+  for(const auto & e : entries) {
+    results.push_back(runner.run(e));
+    const Result & r(results.back());
+    std::printf("%-48s %12lu %14.3f %10.2f %14.4g %s\n",r.name.c_str(),r.iterations,r.median,
+                (r.mean>0.0?100.0*r.stddev/r.mean:0.0),(r.items>0.0?r.items*1e9/r.median:0.0),r.label.c_str());
+    std::fflush(stdout);
+  }
+  if(json.length()>0) writeJson(json,results,minTime,repetitions);
+  return 0;
+}
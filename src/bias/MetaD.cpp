@@ -25,6 +25,7 @@
 #include "tools/Grid.h"
 #include "core/PlumedMain.h"
 #include "core/Atoms.h"
+#include "core/Checkpoint.h"
 #include "tools/Exception.h"
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
@@ -464,10 +465,13 @@ private:
   void   computeReweightingFactor();
   double getTransitionBarrierBias();
   void updateFrequencyAdaptiveStride();
+/// Write a copy of the grid in the background, replacing the previous one
+  void submitGrid();
   string fmt;
 
 public:
   explicit MetaD(const ActionOptions&);
+  ~MetaD();
   void calculate();
   void update();
   static void registerKeywords(Keywords& keys);
@@ -1227,6 +1231,9 @@ MetaD::MetaD(const ActionOptions& ao):
     }
     if(mw_n_>1) gridfile_.enforceSuffix("");
     gridfile_.open(gridfilename_);
+    // the latest grid is written with the checkpoint writer,
+    // here the file is only opened to take a backup and to set its path
+    if(!storeOldGrids_) gridfile_.close();
   }
 
   // open hills file for writing
@@ -1293,6 +1300,10 @@ MetaD::MetaD(const ActionOptions& ao):
     log<<plumed.cite("Wang, Valsson, Tiwary, Parrinello, and Lindorff-Larsen, J. Chem. Phys. 149, 072309 (2018)");
   }
   log<<"\n";
+
+  // the latest grid is also written when the MD code signals a checkpoint
+  // (added last, so that the function is not kept if the constructor fails)
+  if(wgridstride_>0 && !storeOldGrids_) plumed.getCheckpoint().add(this,[this]() {submitGrid();});
 }
 
 void MetaD::readTemperingSpecs(TemperingSpecs &t_specs) {
@@ -1654,6 +1665,27 @@ void MetaD::temperHeight(double &height, const TemperingSpecs &t_specs, const do
   }
 }
 
+MetaD::~MetaD() {
+  plumed.getCheckpoint().remove(this);
+}
+
+void MetaD::submitGrid() {
+  int r = 0;
+  if(walkers_mpi) {
+    if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
+    comm.Bcast(r,0);
+  }
+  // a copy of the grid is written in the background, so that MD does not wait for I/O
+  if(r==0 && comm.Get_rank()==0) {
+    std::shared_ptr<Grid> grid=BiasGrid_->clone();
+    plumed.getCheckpoint().submit(gridfile_.getPath(),[grid](const std::string& path) {
+      OFile ofile;
+      ofile.open(path);
+      grid->writeToFile(ofile);
+    },"bck.last");
+  }
+}
+
 void MetaD::calculate()
 {
   // this is because presently there is no way to properly pass information
@@ -1792,26 +1824,15 @@ void MetaD::update() {
   // dump grid on file
   if(wgridstride_>0&&(getStep()%wgridstride_==0||getCPT())) {
     // in case old grids are stored, a sequence of grids should appear
-    // this call results in a repetition of the header:
-    if(storeOldGrids_) gridfile_.clearFields();
-    // in case only latest grid is stored, file should be rewound
-    // this will overwrite previously written grids
-    else {
-      int r = 0;
-      if(walkers_mpi) {
-        if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
-        comm.Bcast(r,0);
-      }
-      if(r==0) gridfile_.rewind();
+    if(storeOldGrids_) {
+      // this call results in a repetition of the header:
+      gridfile_.clearFields();
+      BiasGrid_->writeToFile(gridfile_);
     }
-    BiasGrid_->writeToFile(gridfile_);
-    // if a single grid is stored, it is necessary to flush it, otherwise
-    // the file might stay empty forever (when a single grid is not large enough to
-    // trigger flushing from the operating system).
-    // on the other hand, if grids are stored one after the other this is
-    // no necessary, and we leave the flushing control to the user as usual
-    // (with FLUSH keyword)
-    if(!storeOldGrids_) gridfile_.flush();
+    // in case only latest grid is stored, file should be replaced
+    // this will overwrite previously written grids
+    // at checkpoints this is done by the function added in the constructor
+    else if(getStep()%wgridstride_==0) submitGrid();
   }
 
   // if multiple walkers and time to read Gaussians
@@ -25,6 +25,7 @@
 #include "tools/Grid.h"
 #include "core/PlumedMain.h"
 #include "core/Atoms.h"
+#include "core/Checkpoint.h"
 #include "tools/Exception.h"
 #include "core/FlexibleBin.h"
 #include "tools/Matrix.h"
@@ -274,10 +275,13 @@ private:
   double evaluateGaussian(unsigned iarg, const vector<double>&, const Gaussian&,double* der=NULL);
   vector<unsigned> getGaussianSupport(unsigned iarg, const Gaussian&);
   bool   scanOneHill(unsigned iarg, IFile *ifile,  vector<Value> &v, vector<double> &center, vector<double>  &sigma, double &height, bool &multivariate);
+/// Write copies of the grids in the background, replacing the previous ones
+  void   submitGrids();
   std::string fmt;
 
 public:
   explicit PBMetaD(const ActionOptions&);
+  ~PBMetaD();
   void calculate();
   void update();
   static void registerKeywords(Keywords& keys);
@@ -759,7 +763,9 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
       }
       if(mw_n_>1) ofile->enforceSuffix("");
       ofile->open(gridfname_tmp);
-      ofile->setHeavyFlush();
+      // grids are written with the checkpoint writer,
+      // here the file is only opened to take a backup and to set its path
+      ofile->close();
       gridfiles_.emplace_back(std::move(ofile));
     }
   }
@@ -772,6 +778,10 @@ PBMetaD::PBMetaD(const ActionOptions& ao):
   if(adaptive_!=FlexibleBin::none) log<<plumed.cite(
                                           "Branduardi, Bussi, and Parrinello, J. Chem. Theory Comput. 8, 2247 (2012)");
   log<<"\n";
+
+  // grids are also written when the MD code signals a checkpoint
+  // (added last, so that the function is not kept if the constructor fails)
+  if(wgridstride_>0) plumed.getCheckpoint().add(this,[this]() {submitGrids();});
 }
 
 void PBMetaD::readGaussians(unsigned iarg, IFile *ifile)
@@ -943,6 +953,29 @@ double PBMetaD::evaluateGaussian(unsigned iarg, const vector<double>& cv, const
   return bias;
 }
 
+PBMetaD::~PBMetaD() {
+  plumed.getCheckpoint().remove(this);
+}
+
+void PBMetaD::submitGrids() {
+  int r = 0;
+  if(walkers_mpi) {
+    if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
+    comm.Bcast(r,0);
+  }
+  // copies of the grids are written in the background, so that MD does not wait for I/O
+  if(r==0 && comm.Get_rank()==0) {
+    for(unsigned i=0; i<gridfiles_.size(); ++i) {
+      std::shared_ptr<Grid> grid=BiasGrids_[i]->clone();
+      plumed.getCheckpoint().submit(gridfiles_[i]->getPath(),[grid](const std::string& path) {
+        OFile ofile;
+        ofile.open(path);
+        grid->writeToFile(ofile);
+      },"bck.last");
+    }
+  }
+}
+
 void PBMetaD::calculate()
 {
   // this is because presently there is no way to properly pass information
@@ -1084,20 +1117,8 @@ void PBMetaD::update()
   }
 
   // write grid files
-  if(wgridstride_>0 && (getStep()%wgridstride_==0 || getCPT())) {
-    int r = 0;
-    if(walkers_mpi) {
-      if(comm.Get_rank()==0) r=multi_sim_comm.Get_rank();
-      comm.Bcast(r,0);
-    }
-    if(r==0) {
-      for(unsigned i=0; i<gridfiles_.size(); ++i) {
-        gridfiles_[i]->rewind();
-        BiasGrids_[i]->writeToFile(*gridfiles_[i]);
-        gridfiles_[i]->flush();
-      }
-    }
-  }
+  // at checkpoints this is done by the function added in the constructor
+  if(wgridstride_>0 && getStep()%wgridstride_==0) submitGrids();
 
   // if multiple walkers and time to read Gaussians
   if(mw_n_>1 && getStep()%mw_rstride_==0) {
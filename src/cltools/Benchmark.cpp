@@ -0,0 +1,412 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "CLTool.h"
+#include "CLToolRegister.h"
+#include "tools/Tools.h"
+#include "tools/Vector.h"
+#include "tools/Tensor.h"
+#include "tools/Random.h"
+#include "tools/PlumedHandle.h"
+#include "core/PlumedMain.h"
+#include <cstdio>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+using namespace std;
+
+namespace PLMD {
+namespace cltools {
+
+//+PLUMEDOC TOOLS benchmark
+/*
+benchmark is a tool that allows you to measure the performance of a PLUMED input.
+
+The input file is read by one or more PLUMED kernels that are then called, as an MD code would do,
+on a trajectory. The trajectory can either be read from an xyz file (frames are reused cyclically
+if the file contains fewer frames than the requested number of steps) or be made of randomly
+displaced atoms in a cubic box. A number of warm-up steps is run first and is not included in the
+statistics. For the measured steps the tool reports the average wall time of a step with its
+95% confidence interval, the throughput in steps and atoms per second, the growth of the heap
+and the page faults during the measured steps, and the time spent by each action in the forward
+(calculate) and backward (apply) loops, as reported by the detailed timers of PLUMED.
+Notice that the per-action timers are accumulated over all the steps, warm-up included.
+
+Results are written to the standard output and, in a machine readable form, to a JSON file.
+The log of each kernel is written to a file named benchmark.N.log, where N is the
+index of the kernel in the list.
+
+Several kernels can be compared by passing a colon separated list of paths to --kernel.
+The special name `this` refers to the kernel the tool belongs to. The first kernel in the
+list is used as a reference, and for the other ones the speedup and the 95% confidence interval
+of the difference of their average step time from the reference are reported.
+
+\par Examples
+
+The following command measures the performance of the input plumed.dat on 500 steps
+of a system of 10000 atoms with randomly displaced coordinates:
+
+\verbatim
+plumed benchmark --plumed plumed.dat --natoms 10000 --nsteps 500
+\endverbatim
+
+The following command compares the present kernel with another one on a real trajectory:
+
+\verbatim
+plumed benchmark --plumed plumed.dat --ixyz traj.xyz --kernel this:/path/to/lib/libplumedKernel.so
+\endverbatim
+
+*/
+//+ENDPLUMEDOC
+
+class Benchmark:
+  public CLTool
+{
+/// Timers of a single action, as read from the log
+  struct ActionTimers {
+    std::string label;
+/// Index 0 is for the forward loop, index 1 for the backward loop
+    unsigned cycles[2];
+    double total[2], average[2], minimum[2], maximum[2];
+    ActionTimers(): cycles{0,0}, total{0,0}, average{0,0}, minimum{0,0}, maximum{0,0} {}
+  };
+/// Everything that is measured on a single kernel
+  struct KernelResults {
+    std::string kernel;
+    std::vector<double> steps;
+    double mean=0, stddev=0, ci=0, minimum=0, maximum=0;
+    long heapGrowth=-1, maxRSS=0, minorFaults=0, majorFaults=0;
+    std::vector<ActionTimers> actions;
+  };
+  std::string plumedFile;
+  unsigned nwarmup, nsteps;
+  int natoms;
+  double timestep;
+/// Trajectory frames, reused cyclically
+  std::vector<std::vector<Vector> > frames;
+  std::vector<Tensor> boxes;
+/// Half width of the 95% confidence interval of the Student t distribution
+  static double studentT975( unsigned dof );
+/// Bytes currently allocated on the heap, -1 if not available
+  static long heapInUse();
+/// Read one frame from an xyz file
+  static bool readXYZ( FILE* fp, std::vector<Vector>& pos, Tensor& box );
+/// Read the per-action timers from the log of a kernel
+  static void readTimers( const std::string& logfile, std::vector<ActionTimers>& actions );
+/// Compute mean, standard deviation and confidence interval of the step times
+  static void computeStatistics( KernelResults& r );
+/// Generate the synthetic trajectory
+  void generateFrames( unsigned seed, double side );
+/// Run the benchmark on a kernel
+  KernelResults run( const std::string& kernel, const std::string& logfile );
+public:
+  static void registerKeywords( Keywords& keys );
+  explicit Benchmark(const CLToolOptions& co );
+  int main(FILE* in, FILE*out,Communicator& pc);
+  string description()const {
+    return "run a plumed input on a trajectory and measure its performance";
+  }
+};
+
+PLUMED_REGISTER_CLTOOL(Benchmark,"benchmark")
+
+void Benchmark::registerKeywords( Keywords& keys ) {
+  CLTool::registerKeywords( keys );
+  keys.add("compulsory","--plumed","plumed.dat","the name of the plumed input file");
+  keys.add("compulsory","--kernel","this","colon separated list of the kernels to be compared. this means the kernel the tool belongs to");
+  keys.add("compulsory","--nsteps","100","the number of measured steps");
+  keys.add("compulsory","--nwarmup","10","the number of warm-up steps that are run before the measured ones");
+  keys.add("compulsory","--natoms","1000","the number of atoms of the synthetic trajectory");
+  keys.add("compulsory","--density","100","the number density of the synthetic trajectory, in atoms per cubic nm");
+  keys.add("compulsory","--seed","1","the seed of the random numbers used to build the synthetic trajectory");
+  keys.add("compulsory","--timestep","0.002","the timestep passed to plumed, in ps");
+  keys.add("compulsory","--json","benchmark.json","the file where the results are written in json format");
+  keys.add("optional","--ixyz","a trajectory in xyz format to be used instead of the synthetic one");
+}
+
+Benchmark::Benchmark(const CLToolOptions& co ):
+  CLTool(co),
+  nwarmup(0),
+  nsteps(0),
+  natoms(0),
+  timestep(0)
+{
+  inputdata=commandline;
+}
+
+double Benchmark::studentT975( unsigned dof ) {
+  const double z=1.959963984540054;
+  if(dof==0) return 0.0;
+// Cornish-Fisher expansion around the normal distribution
+  const double v=dof, z3=z*z*z, z5=z3*z*z, z7=z5*z*z;
+  return z + (z3+z)/(4*v) + (5*z5+16*z3+3*z)/(96*v*v) + (3*z7+19*z5+17*z3-15*z)/(384*v*v*v);
+}
+
+long Benchmark::heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__>2 || (__GLIBC__==2 && __GLIBC_MINOR__>=33))
+  return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+  return mallinfo().uordblks;
+#else
+  return -1;
+#endif
+}
+
+bool Benchmark::readXYZ( FILE* fp, std::vector<Vector>& pos, Tensor& box ) {
+  std::string line;
+  if(!Tools::getline(fp,line)) return false;
+  std::vector<std::string> words=Tools::getWords(line);
+  if(words.size()==0) return false;
+  int n; plumed_massert(Tools::convert(words[0],n),"cannot read number of atoms in xyz file");
+  plumed_massert(Tools::getline(fp,line),"premature end of xyz file");
+// the comment line may contain the box, either as three sides or as a full matrix
+  words=Tools::getWords(line); box.zero();
+  std::vector<double> cell;
+  for(const auto & w : words) {
+    double d; if(!Tools::convert(w,d)) break;
+    cell.push_back(d);
+  }
+  if(cell.size()==3) {
+    box(0,0)=cell[0]; box(1,1)=cell[1]; box(2,2)=cell[2];
+  } else if(cell.size()==9) {
+    for(unsigned i=0; i<3; i++) for(unsigned j=0; j<3; j++) box(i,j)=cell[3*i+j];
+  }
+  pos.resize(n);
+  for(int i=0; i<n; i++) {
+    plumed_massert(Tools::getline(fp,line),"premature end of xyz file");
+    words=Tools::getWords(line);
+    plumed_massert(words.size()>=4,"wrong line in xyz file: "+line);
+    for(unsigned j=0; j<3; j++) plumed_massert(Tools::convert(words[j+1],pos[i][j]),"wrong line in xyz file: "+line);
+  }
+  return true;
+}
+
+void Benchmark::generateFrames( unsigned seed, double side ) {
+  Random random; random.setSeed(-static_cast<int>(seed));
+  Tensor box; box(0,0)=box(1,1)=box(2,2)=side;
+  std::vector<Vector> pos(natoms);
+  for(auto & p : pos) for(unsigned j=0; j<3; j++) p[j]=side*random.RandU01();
+// atoms move by small random displacements, so that neighbor lists remain meaningful
+  const double delta=0.01*std::cbrt(side*side*side/natoms);
+  for(unsigned i=0; i<nwarmup+nsteps; i++) {
+    for(auto & p : pos) for(unsigned j=0; j<3; j++) p[j]+=delta*random.Gaussian();
+    frames.push_back(pos); boxes.push_back(box);
+  }
+}
+
+void Benchmark::readTimers( const std::string& logfile, std::vector<ActionTimers>& actions ) {
+  FILE* fp=std::fopen(logfile.c_str(),"r");
+  plumed_massert(fp,"cannot open log file "+logfile);
+  std::string line;
+  while(Tools::getline(fp,line)) {
+    std::vector<std::string> words=Tools::getWords(line);
+    if(words.size()>0 && words[0]=="PLUMED:") words.erase(words.begin());
+// lines look like "4A  1 label cycles total average minimum maximum"
+    if(words.size()<8 || (words[0]!="4A" && words[0]!="5A")) continue;
+    unsigned loop=( words[0]=="4A" ? 0 : 1 );
+    std::string label=words[2];
+    for(unsigned i=3; i<words.size()-5; i++) label+=" "+words[i];
+    auto it=std::find_if(actions.begin(),actions.end(),[&](const ActionTimers&a) {return a.label==label;});
+    if(it==actions.end()) { actions.emplace_back(); actions.back().label=label; it=actions.end()-1; }
+    unsigned k=words.size()-5;
+    Tools::convert(words[k],it->cycles[loop]);
+    Tools::convert(words[k+1],it->total[loop]);
+    Tools::convert(words[k+2],it->average[loop]);
+    Tools::convert(words[k+3],it->minimum[loop]);
+    Tools::convert(words[k+4],it->maximum[loop]);
+  }
+  std::fclose(fp);
+}
+
+void Benchmark::computeStatistics( KernelResults& r ) {
+  const unsigned n=r.steps.size();
+  if(n==0) return;
+  double sum=0; for(const auto & t : r.steps) sum+=t;
+  r.mean=sum/n;
+  double var=0; for(const auto & t : r.steps) var+=(t-r.mean)*(t-r.mean);
+  r.stddev=( n>1 ? std::sqrt(var/(n-1)) : 0.0 );
+  r.ci=studentT975(n-1)*r.stddev/std::sqrt(static_cast<double>(n));
+  r.minimum=*std::min_element(r.steps.begin(),r.steps.end());
+  r.maximum=*std::max_element(r.steps.begin(),r.steps.end());
+}
+
+Benchmark::KernelResults Benchmark::run( const std::string& kernel, const std::string& logfile ) {
+  KernelResults r; r.kernel=kernel;
+  std::vector<Vector> pos(natoms), forces(natoms);
+  std::vector<double> masses(natoms,1.0), charges(natoms,0.0);
+  Tensor box, virial;
+  rusage ru0, ru1; long heap0=0;
+  {
+    std::unique_ptr<PlumedHandle> p;
+    if(kernel=="this") p.reset(new PlumedHandle);
+    else p.reset(new PlumedHandle(PlumedHandle::dlopen(kernel.c_str())));
+    int s=sizeof(double);
+    p->cmd("setRealPrecision",&s);
+    p->cmd("setMDEngine","benchmark");
+    p->cmd("setNatoms",&natoms);
+    p->cmd("setTimestep",&timestep);
+    p->cmd("setPlumedDat",plumedFile.c_str());
+    p->cmd("setLogFile",logfile.c_str());
+    p->cmd("init");
+    p->cmd("readInputLine","DEBUG DETAILED_TIMERS");
+    for(unsigned istep=0; istep<nwarmup+nsteps; istep++) {
+      if(istep==nwarmup) {
+        heap0=heapInUse();
+        getrusage(RUSAGE_SELF,&ru0);
+      }
+      const unsigned iframe=istep%frames.size();
+      pos=frames[iframe]; box=boxes[iframe];
+      for(auto & f : forces) f.zero();
+      virial.zero();
+      int step=istep;
+      auto t0=std::chrono::steady_clock::now();
+      p->cmd("setStep",&step);
+      p->cmd("setBox",&box[0][0]);
+      p->cmd("setMasses",&masses[0]);
+      p->cmd("setCharges",&charges[0]);
+      p->cmd("setPositions",&pos[0][0]);
+      p->cmd("setForces",&forces[0][0]);
+      p->cmd("setVirial",&virial[0][0]);
+      p->cmd("calc");
+      auto t1=std::chrono::steady_clock::now();
+      if(istep>=nwarmup) r.steps.push_back(std::chrono::duration<double>(t1-t0).count());
+    }
+    getrusage(RUSAGE_SELF,&ru1);
+    long heap1=heapInUse();
+    if(heap0>=0 && heap1>=0) r.heapGrowth=heap1-heap0;
+// the log, including the timers, is completed when the plumed object is destroyed
+  }
+  r.maxRSS=ru1.ru_maxrss;
+  r.minorFaults=ru1.ru_minflt-ru0.ru_minflt;
+  r.majorFaults=ru1.ru_majflt-ru0.ru_majflt;
+  computeStatistics(r);
+  readTimers(logfile,r.actions);
+  return r;
+}
+
+int Benchmark::main(FILE* in, FILE*out,Communicator& pc) {
+  parse("--plumed",plumedFile);
+  std::string kernels; parse("--kernel",kernels);
+  parse("--nsteps",nsteps);
+  parse("--nwarmup",nwarmup);
+  parse("--timestep",timestep);
+  std::string jsonfile; parse("--json",jsonfile);
+  std::string xyzfile; parse("--ixyz",xyzfile);
+  if(nsteps==0) error("--nsteps should be larger than zero");
+
+  if(xyzfile.length()>0) {
+    FILE* fp=std::fopen(xyzfile.c_str(),"r");
+    if(!fp) error("cannot open file "+xyzfile);
+    std::vector<Vector> pos; Tensor box;
+    while(frames.size()<nwarmup+nsteps && readXYZ(fp,pos,box)) {
+      if(frames.size()>0 && pos.size()!=frames[0].size()) error("the number of atoms changes along the trajectory");
+      frames.push_back(pos); boxes.push_back(box);
+    }
+    std::fclose(fp);
+    if(frames.size()==0) error("no frames found in "+xyzfile);
+    natoms=frames[0].size();
+  } else {
+    parse("--natoms",natoms);
+    if(natoms<=0) error("--natoms should be larger than zero");
+    double density; parse("--density",density);
+    unsigned seed; parse("--seed",seed);
+    generateFrames(seed,std::cbrt(natoms/density));
+  }
+
+  std::vector<std::string> kernelList=Tools::getWords(kernels,":");
+  std::vector<KernelResults> results;
+  for(unsigned i=0; i<kernelList.size(); i++) {
+    std::string logfile="benchmark."+std::to_string(i)+".log";
+    std::fprintf(out,"BENCHMARK: running kernel %s, log in %s\n",kernelList[i].c_str(),logfile.c_str());
+    results.push_back(run(kernelList[i],logfile));
+  }
+
+  for(unsigned i=0; i<results.size(); i++) {
+    const KernelResults& r(results[i]);
+    std::fprintf(out,"BENCHMARK: kernel %s\n",r.kernel.c_str());
+    std::fprintf(out,"BENCHMARK:   step time %e s +/- %e s (95%% confidence), min %e s, max %e s\n",r.mean,r.ci,r.minimum,r.maximum);
+    std::fprintf(out,"BENCHMARK:   throughput %e steps/s, %e atoms/s\n",1.0/r.mean,natoms/r.mean);
+    std::fprintf(out,"BENCHMARK:   heap growth %ld bytes, max RSS %ld kB, page faults %ld minor %ld major\n",r.heapGrowth,r.maxRSS,r.minorFaults,r.majorFaults);
+    if(i>0) {
+      const KernelResults& r0(results[0]);
+      std::fprintf(out,"BENCHMARK:   speedup with respect to %s: %f, difference %e s +/- %e s (95%% confidence)\n",
+                   r0.kernel.c_str(),r0.mean/r.mean,r.mean-r0.mean,std::sqrt(r.ci*r.ci+r0.ci*r0.ci));
+    }
+    std::fprintf(out,"BENCHMARK:   %-30s %14s %14s\n","action","forward (s)","backward (s)");
+    for(const auto & a : r.actions) std::fprintf(out,"BENCHMARK:   %-30s %14.6e %14.6e\n",a.label.c_str(),a.average[0],a.average[1]);
+  }
+
+  FILE* fp=std::fopen(jsonfile.c_str(),"w");
+  if(!fp) error("cannot open file "+jsonfile);
+  std::fprintf(fp,"{\n");
+  std::fprintf(fp,"  \"plumed\": \"%s\",\n",plumedFile.c_str());
+  std::fprintf(fp,"  \"natoms\": %d,\n",natoms);
+  std::fprintf(fp,"  \"nwarmup\": %u,\n",nwarmup);
+  std::fprintf(fp,"  \"nsteps\": %u,\n",nsteps);
+  std::fprintf(fp,"  \"kernels\": [\n");
+  for(unsigned i=0; i<results.size(); i++) {
+    const KernelResults& r(results[i]);
+    std::fprintf(fp,"    {\n");
+    std::fprintf(fp,"      \"kernel\": \"%s\",\n",r.kernel.c_str());
+    std::fprintf(fp,"      \"step_time\": {\"mean\": %.9e, \"stddev\": %.9e, \"ci95\": [%.9e, %.9e], \"min\": %.9e, \"max\": %.9e},\n",
+                 r.mean,r.stddev,r.mean-r.ci,r.mean+r.ci,r.minimum,r.maximum);
+    std::fprintf(fp,"      \"steps_per_second\": %.9e,\n",1.0/r.mean);
+    std::fprintf(fp,"      \"atoms_per_second\": %.9e,\n",natoms/r.mean);
+    std::fprintf(fp,"      \"heap_growth_bytes\": %ld,\n",r.heapGrowth);
+    std::fprintf(fp,"      \"max_rss_kb\": %ld,\n",r.maxRSS);
+    std::fprintf(fp,"      \"minor_page_faults\": %ld,\n",r.minorFaults);
+    std::fprintf(fp,"      \"major_page_faults\": %ld,\n",r.majorFaults);
+    if(i>0) {
+      const KernelResults& r0(results[0]);
+      const double d=r.mean-r0.mean, ci=std::sqrt(r.ci*r.ci+r0.ci*r0.ci);
+      std::fprintf(fp,"      \"comparison\": {\"reference\": \"%s\", \"speedup\": %.9e, \"difference_ci95\": [%.9e, %.9e]},\n",
+                   r0.kernel.c_str(),r0.mean/r.mean,d-ci,d+ci);
+    }
+    std::fprintf(fp,"      \"actions\": [");
+    for(unsigned j=0; j<r.actions.size(); j++) {
+      const ActionTimers& a(r.actions[j]);
+      std::fprintf(fp,"%s\n        {\"label\": \"%s\"",(j>0?",":""),a.label.c_str());
+      const char* loops[2]= {"forward","backward"};
+      for(unsigned k=0; k<2; k++) {
+        std::fprintf(fp,", \"%s\": {\"cycles\": %u, \"total\": %.9e, \"average\": %.9e, \"min\": %.9e, \"max\": %.9e}",
+                     loops[k],a.cycles[k],a.total[k],a.average[k],a.minimum[k],a.maximum[k]);
+      }
+      std::fprintf(fp,"}");
+    }
+    std::fprintf(fp,"\n      ]\n");
+    std::fprintf(fp,"    }%s\n",(i+1<results.size()?",":""));
+  }
+  std::fprintf(fp,"  ]\n");
+  std::fprintf(fp,"}\n");
+  std::fclose(fp);
+  return 0;
+}
+
+} // End of namespace
+}
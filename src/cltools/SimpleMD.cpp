@@ -22,6 +22,8 @@
 #include "CLTool.h"
 #include "CLToolRegister.h"
 #include "core/PlumedMain.h"
+#include "tools/Communicator.h"
+#include "tools/OpenMP.h"
 #include "tools/Vector.h"
 #include "tools/Random.h"
 #include <string>
@@ -29,6 +31,8 @@
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <algorithm>
+#include <chrono>
 
 using namespace std;
 
@@ -71,6 +75,24 @@ input file will be output.
 plumed simplemd --help
 \endverbatim
 
+simplemd can also be used to generate load on PLUMED without a production MD code.
+Neighbour lists are built with cell lists, so that the cost of a step grows linearly
+with the number of atoms, and forces are computed with the number of OpenMP threads
+set by PLUMED_NUM_THREADS. When the directive `domaindecomposition true` is used,
+atoms are passed to PLUMED as an MD code using domain decomposition would do:
+each MPI process only passes the atoms in its own slab of the box (along x),
+with `setAtomsNlocal` and `setAtomsGatindex`, and the slabs are updated every time
+the neighbour list is recomputed. The dynamics itself is replicated on all the processes.
+Output files are only written by the first process.
+This allows the domain decomposition code of PLUMED to be tested on a single machine
+(notice that with MPI the input file should be given as an argument):
+\verbatim
+export PLUMED_NUM_THREADS=4
+mpirun -np 2 plumed simplemd in
+\endverbatim
+At the end of the run the number of steps per second is reported, together with the time
+spent computing forces, building neighbour lists and in PLUMED.
+
 */
 //+ENDPLUMEDOC
 
@@ -86,6 +108,12 @@ class SimpleMD:
   int write_statistics_last_time_reopened;
   FILE* write_statistics_fp;
 
+// work arrays, kept here so that they are only allocated once
+  vector<int>    cell_head;    // first atom in each cell
+  vector<int>    cell_next;    // next atom in the same cell
+  vector<int>    neighbours;   // neighbours of a single atom, before sorting
+  vector<Vector> omp_forces;   // forces accumulated by each thread
+
 
 public:
   static void registerKeywords( Keywords& keys ) {
@@ -103,6 +131,7 @@ public:
     keys.add("compulsory","idum","0","The random number seed");
     keys.add("compulsory","ndim","3","The dimensionality of the system (some interesting LJ clusters are two dimensional)");
     keys.add("compulsory","wrapatoms","false","If true, atomic coordinates are written wrapped in minimal cell");
+    keys.add("compulsory","domaindecomposition","false","If true, atoms are passed to PLUMED with an emulated domain decomposition (one slab along x per MPI process)");
   }
 
   explicit SimpleMD( const CLToolOptions& co ) :
@@ -127,6 +156,7 @@ private:
              int&    nconfig,
              int&    nstat,
              bool&   wrapatoms,
+             bool&   domaindecomposition,
              string& inputfile,
              string& outputfile,
              string& trajfile,
@@ -186,6 +216,9 @@ private:
     parse("wrapatoms",w);
     wrapatoms=false;
     if(w.length()>0 && (w[0]=='T' || w[0]=='t')) wrapatoms=true;
+    parse("domaindecomposition",w);
+    domaindecomposition=false;
+    if(w.length()>0 && (w[0]=='T' || w[0]=='t')) domaindecomposition=true;
   }
 
   void read_natoms(const string & inputfile,int & natoms) {
@@ -256,6 +289,13 @@ private:
     Vector distance_pbc; // minimum-image distance of the two atoms
     double listcutoff2;  // squared list cutoff
     listcutoff2=listcutoff*listcutoff;
+    int ncell[3];        // number of cells along each direction
+    for(int k=0; k<3; k++) ncell[k]=int(cell[k]/listcutoff);
+// cell lists need at least three cells per direction, otherwise all pairs are checked
+    if(ncell[0]>=3 && ncell[1]>=3 && ncell[2]>=3) {
+      compute_list_cells(natoms,listsize,positions,cell,listcutoff,ncell,point,list);
+      return;
+    }
     point[0]=0;
     for(int iatom=0; iatom<natoms-1; iatom++) {
       point[iatom+1]=point[iatom];
@@ -277,6 +317,61 @@ private:
     }
   }
 
+  int cell_index(const Vector & position,const double cell[3],const int ncell[3],int c[3]) {
+// index of the cell containing an atom, taking into account periodicity
+    for(int k=0; k<3; k++) {
+      double s=position[k]/cell[k];
+      c[k]=int((s-floor(s))*ncell[k]);
+      if(c[k]>=ncell[k]) c[k]=ncell[k]-1;
+    }
+    return (c[0]*ncell[1]+c[1])*ncell[2]+c[2];
+  }
+
+  void compute_list_cells(const int natoms,const int listsize,const vector<Vector>& positions,const double cell[3],const double listcutoff,
+                          const int ncell[3],vector<int>& point,vector<int>& list) {
+// same list as compute_list, built in linear time: only atoms in neighbouring cells are checked
+// neighbours of each atom are sorted so that the list (and thus the order of the sums) is unchanged
+    Vector distance;     // distance of the two atoms
+    Vector distance_pbc; // minimum-image distance of the two atoms
+    const double listcutoff2=listcutoff*listcutoff;
+    int c[3];
+    cell_head.assign(ncell[0]*ncell[1]*ncell[2],-1);
+    cell_next.resize(natoms);
+    for(int iatom=natoms-1; iatom>=0; iatom--) {
+      int icell=cell_index(positions[iatom],cell,ncell,c);
+      cell_next[iatom]=cell_head[icell];
+      cell_head[icell]=iatom;
+    }
+    point[0]=0;
+    for(int iatom=0; iatom<natoms-1; iatom++) {
+      point[iatom+1]=point[iatom];
+      neighbours.clear();
+      cell_index(positions[iatom],cell,ncell,c);
+      for(int dx=-1; dx<=1; dx++) for(int dy=-1; dy<=1; dy++) for(int dz=-1; dz<=1; dz++) {
+            int jcell=(((c[0]+dx+ncell[0])%ncell[0])*ncell[1]+(c[1]+dy+ncell[1])%ncell[1])*ncell[2]+(c[2]+dz+ncell[2])%ncell[2];
+            for(int jatom=cell_head[jcell]; jatom>=0; jatom=cell_next[jatom]) {
+              if(jatom<=iatom) continue;
+              for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
+              pbc(cell,distance,distance_pbc);
+              double d2=0; for(int k=0; k<3; k++) d2+=distance_pbc[k]*distance_pbc[k];
+              if(d2>listcutoff2)continue;
+              neighbours.push_back(jatom);
+            }
+          }
+      std::sort(neighbours.begin(),neighbours.end());
+      for(const auto & jatom : neighbours) {
+        if(point[iatom+1]>listsize) {
+// too many neighbours
+          fprintf(stderr,"%s","Verlet list size exceeded\n");
+          fprintf(stderr,"%s","Increase maxneighbours\n");
+          exit(1);
+        }
+        list[point[iatom+1]]=jatom;
+        point[iatom+1]++;
+      }
+    }
+  }
+
   void compute_forces(const int natoms,const int listsize,const vector<Vector>& positions,const double cell[3],
                       double forcecutoff,const vector<int>& point,const vector<int>& list,vector<Vector>& forces,double & engconf)
   {
@@ -289,25 +384,44 @@ private:
 
     forcecutoff2=forcecutoff*forcecutoff;
     engconf=0.0;
-    for(int i=0; i<natoms; i++)for(int k=0; k<3; k++) forces[i][k]=0.0;
     engcorrection=4.0*(1.0/pow(forcecutoff2,6.0)-1.0/pow(forcecutoff2,3));
-    for(int iatom=0; iatom<natoms-1; iatom++) {
-      for(int jlist=point[iatom]; jlist<point[iatom+1]; jlist++) {
-        int jatom=list[jlist];
-        for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
-        pbc(cell,distance,distance_pbc);
-        distance_pbc2=0.0; for(int k=0; k<3; k++) distance_pbc2+=distance_pbc[k]*distance_pbc[k];
+// with more than one thread, each thread accumulates forces on its own copy,
+// with a single thread forces are accumulated directly (same order as a serial loop)
+    unsigned nt=OpenMP::getNumThreads();
+    if(nt*64>unsigned(natoms)) nt=1;
+    if(nt>1 && omp_forces.size()<nt*natoms) omp_forces.resize(nt*natoms);
+    #pragma omp parallel num_threads(nt) private(distance,distance_pbc,distance_pbc2,f) reduction(+:engconf)
+    {
+      Vector* myforces=(nt>1 ? &omp_forces[OpenMP::getThreadNum()*natoms] : &forces[0]);
+      for(int i=0; i<natoms; i++)for(int k=0; k<3; k++) myforces[i][k]=0.0;
+      #pragma omp for schedule(static)
+      for(int iatom=0; iatom<natoms-1; iatom++) {
+        for(int jlist=point[iatom]; jlist<point[iatom+1]; jlist++) {
+          int jatom=list[jlist];
+          for(int k=0; k<3; k++) distance[k]=positions[iatom][k]-positions[jatom][k];
+          pbc(cell,distance,distance_pbc);
+          distance_pbc2=0.0; for(int k=0; k<3; k++) distance_pbc2+=distance_pbc[k]*distance_pbc[k];
 // if the interparticle distance is larger than the cutoff, skip
-        if(distance_pbc2>forcecutoff2) continue;
-        double distance_pbc6=distance_pbc2*distance_pbc2*distance_pbc2;
-        double distance_pbc8=distance_pbc6*distance_pbc2;
-        double distance_pbc12=distance_pbc6*distance_pbc6;
-        double distance_pbc14=distance_pbc12*distance_pbc2;
-        engconf+=4.0*(1.0/distance_pbc12 - 1.0/distance_pbc6) - engcorrection;
-        for(int k=0; k<3; k++) f[k]=2.0*distance_pbc[k]*4.0*(6.0/distance_pbc14-3.0/distance_pbc8);
+          if(distance_pbc2>forcecutoff2) continue;
+          double distance_pbc6=distance_pbc2*distance_pbc2*distance_pbc2;
+          double distance_pbc8=distance_pbc6*distance_pbc2;
+          double distance_pbc12=distance_pbc6*distance_pbc6;
+          double distance_pbc14=distance_pbc12*distance_pbc2;
+          engconf+=4.0*(1.0/distance_pbc12 - 1.0/distance_pbc6) - engcorrection;
+          for(int k=0; k<3; k++) f[k]=2.0*distance_pbc[k]*4.0*(6.0/distance_pbc14-3.0/distance_pbc8);
 // same force on the two atoms, with opposite sign:
-        for(int k=0; k<3; k++) forces[iatom][k]+=f[k];
-        for(int k=0; k<3; k++) forces[jatom][k]-=f[k];
+          for(int k=0; k<3; k++) myforces[iatom][k]+=f[k];
+          for(int k=0; k<3; k++) myforces[jatom][k]-=f[k];
+        }
+      }
+// sum the copies of the threads, each thread takes care of a stripe of atoms
+      if(nt>1) {
+        #pragma omp for schedule(static)
+        for(int i=0; i<natoms; i++) {
+          Vector sum;
+          for(unsigned j=0; j<nt; j++) sum+=omp_forces[j*natoms+i];
+          forces[i]=sum;
+        }
       }
     }
   }
@@ -400,6 +514,30 @@ private:
 
 
 
+  void assign_domains(const int natoms,const vector<Vector>& positions,const double cell[3],const int nranks,const int rank,
+                      vector<int>& gatindex,int & nlocal) {
+// emulated domain decomposition: atoms are divided in slabs along x.
+// as in MD codes, local atoms are stored in spatial order, so that their local and global indexes differ
+    nlocal=0;
+    for(int iatom=0; iatom<natoms; iatom++) {
+      double s=positions[iatom][0]/cell[0];
+      s-=floor(s);
+      int owner=int(s*nranks);
+      if(owner>=nranks) owner=nranks-1;
+      if(owner==rank) gatindex[nlocal++]=iatom;
+    }
+    std::sort(gatindex.begin(),gatindex.begin()+nlocal,[&](int i,int j) {
+      double si=positions[i][0]/cell[0]; si-=floor(si);
+      double sj=positions[j][0]/cell[0]; sj-=floor(sj);
+      return si<sj || (si==sj && i<j);
+    });
+  }
+
+  double elapsed(const std::chrono::steady_clock::time_point & start) {
+// seconds elapsed since start
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+  }
+
   virtual int main(FILE* in,FILE*out,PLMD::Communicator& pc) {
     int            natoms;       // number of atoms
     vector<Vector> positions;    // atomic positions
@@ -431,6 +569,7 @@ private:
     int         idum;              // seed
     int         plumedWantsToStop; // stop flag
     bool        wrapatoms;         // if true, atomic coordinates are written wrapped in minimal cell
+    bool        domaindecomposition; // if true, atoms are passed to plumed with an emulated domain decomposition
     string      inputfile;         // name of file with starting configuration (xyz)
     string      outputfile;        // name of file with final configuration (xyz)
     string      trajfile;          // name of the trajectory file (xyz)
@@ -442,6 +581,20 @@ private:
 
     bool recompute_list;           // control if the neighbour list have to be recomputed
 
+// emulated domain decomposition
+    int            dd_nlocal=0;    // number of local atoms
+    bool           dd_changed=true; // if true, local atoms have been reassigned since they were last passed to plumed
+    vector<int>    dd_gatindex;    // global index of local atoms
+    vector<Vector> dd_positions;   // positions of local atoms
+    vector<Vector> dd_forces;      // forces on local atoms, only those computed by plumed
+    vector<double> dd_masses;      // masses of local atoms
+    vector<Vector> dd_bias_forces; // forces computed by plumed on all the atoms
+
+// timings, in seconds
+    double time_forces=0.0;
+    double time_list=0.0;
+    double time_plumed=0.0;
+
     Random random;                 // random numbers stream
 
     std::unique_ptr<PlumedMain> plumed;
@@ -456,7 +609,7 @@ private:
 
     read_input(temperature,tstep,friction,forcecutoff,
                listcutoff,nstep,nconfig,nstat,
-               wrapatoms,inputfile,outputfile,trajfile,statfile,
+               wrapatoms,domaindecomposition,inputfile,outputfile,trajfile,statfile,
                maxneighbour,ndim,idum);
 
 // number of atoms is read from file inputfile
@@ -480,6 +633,8 @@ private:
     fprintf(out,"%s %d\n","Dimensionality                   :",ndim);
     fprintf(out,"%s %d\n","Seed                             :",idum);
     fprintf(out,"%s %s\n","Are atoms wrapped on output?     :",(wrapatoms?"T":"F"));
+    fprintf(out,"%s %s\n","Emulated domain decomposition    :",(domaindecomposition?"T":"F"));
+    fprintf(out,"%s %u\n","Number of threads                :",OpenMP::getNumThreads());
 
 // Setting the seed
     random.setSeed(idum);
@@ -496,6 +651,13 @@ private:
     masses.resize(natoms);
     point.resize(natoms);
     list.resize(listsize);
+    if(domaindecomposition) {
+      dd_gatindex.resize(natoms);
+      dd_positions.resize(natoms);
+      dd_forces.resize(natoms);
+      dd_masses.resize(natoms);
+      dd_bias_forces.resize(natoms);
+    }
 
 // masses are hard-coded to 1
     for(int i=0; i<natoms; ++i) masses[i]=1.0;
@@ -510,6 +672,7 @@ private:
     randomize_velocities(natoms,ndim,temperature,masses,velocities,random);
 
     if(plumed) {
+      if(domaindecomposition && Communicator::initialized()) plumed->cmd("setMPIComm",&pc.Get_comm());
       plumed->cmd("setNoVirial");
       plumed->cmd("setNatoms",&natoms);
       plumed->cmd("setMDEngine","simpleMD");
@@ -528,6 +691,7 @@ private:
 
 // neighbour list are computed, and reference positions are saved
     compute_list(natoms,listsize,positions,cell,listcutoff,point,list);
+    if(domaindecomposition) assign_domains(natoms,positions,cell,pc.Get_size(),pc.Get_rank(),dd_gatindex,dd_nlocal);
 
     fprintf(out,"List size: %d\n",point[natoms-1]);
     for(int iatom=0; iatom<natoms; ++iatom) for(int k=0; k<3; ++k) positions0[iatom][k]=positions[iatom][k];
@@ -550,6 +714,10 @@ private:
 //   update velocities
 //   thermostat
 //   (eventually dump output informations)
+// with domain decomposition, the dynamics is replicated and only one process writes
+    const bool writer=(!domaindecomposition || pc.Get_rank()==0);
+
+    const auto start=std::chrono::steady_clock::now();
     for(int istep=0; istep<nstep; istep++) {
       thermostat(natoms,ndim,masses,0.5*tstep,friction,temperature,velocities,engint,random);
 
@@ -560,17 +728,58 @@ private:
           positions[iatom][k]+=velocities[iatom][k]*tstep;
 
 // a check is performed to decide whether to recalculate the neighbour list
+      auto tstart=std::chrono::steady_clock::now();
       check_list(natoms,positions,positions0,listcutoff,forcecutoff,recompute_list);
       if(recompute_list) {
         compute_list(natoms,listsize,positions,cell,listcutoff,point,list);
         for(int iatom=0; iatom<natoms; ++iatom) for(int k=0; k<3; ++k) positions0[iatom][k]=positions[iatom][k];
         fprintf(out,"Neighbour list recomputed at step %d\n",istep);
         fprintf(out,"List size: %d\n",point[natoms-1]);
+        if(domaindecomposition) {
+          assign_domains(natoms,positions,cell,pc.Get_size(),pc.Get_rank(),dd_gatindex,dd_nlocal);
+          dd_changed=true;
+        }
       }
+      time_list+=elapsed(tstart);
 
+      tstart=std::chrono::steady_clock::now();
       compute_forces(natoms,listsize,positions,cell,forcecutoff,point,list,forces,engconf);
+      time_forces+=elapsed(tstart);
 
-      if(plumed) {
+      tstart=std::chrono::steady_clock::now();
+      if(plumed && domaindecomposition) {
+        int istepplusone=istep+1;
+        plumedWantsToStop=0;
+        for(int i=0; i<3; i++)for(int k=0; k<3; k++) cell9[i][k]=0.0;
+        for(int i=0; i<3; i++) cell9[i][i]=cell[i];
+        for(int i=0; i<dd_nlocal; i++) {
+          dd_positions[i]=positions[dd_gatindex[i]];
+          dd_masses[i]=masses[dd_gatindex[i]];
+          dd_forces[i].zero();
+        }
+// the energy is summed over processes by plumed
+        double dd_energy=(pc.Get_rank()==0 ? engconf : 0.0);
+        plumed->cmd("setStep",&istepplusone);
+        if(dd_changed) {
+          plumed->cmd("setAtomsNlocal",&dd_nlocal);
+          plumed->cmd("setAtomsGatindex",dd_gatindex.data());
+          dd_changed=false;
+        }
+        plumed->cmd("setMasses",dd_masses.data());
+        plumed->cmd("setForces",dd_forces.data());
+        plumed->cmd("setEnergy",&dd_energy);
+        plumed->cmd("setPositions",dd_positions.data());
+        plumed->cmd("setBox",cell9);
+        plumed->cmd("setStopFlag",&plumedWantsToStop);
+        plumed->cmd("calc");
+// each process only knows the forces on its own atoms, which are then shared
+        for(int i=0; i<natoms; i++) dd_bias_forces[i].zero();
+        for(int i=0; i<dd_nlocal; i++) dd_bias_forces[dd_gatindex[i]]=dd_forces[i];
+        pc.Sum(dd_bias_forces);
+        for(int i=0; i<natoms; i++) forces[i]+=dd_bias_forces[i];
+        pc.Sum(plumedWantsToStop);
+        if(plumedWantsToStop) nstep=istep;
+      } else if(plumed) {
         int istepplusone=istep+1;
         plumedWantsToStop=0;
         for(int i=0; i<3; i++)for(int k=0; k<3; k++) cell9[i][k]=0.0;
@@ -585,6 +794,7 @@ private:
         plumed->cmd("calc");
         if(plumedWantsToStop) nstep=istep;
       }
+      time_plumed+=elapsed(tstart);
 // remove forces if ndim<3
       if(ndim<3)
         for(int iatom=0; iatom<natoms; ++iatom) for(int k=ndim; k<3; ++k) forces[iatom][k]=0.0;
@@ -598,16 +808,24 @@ private:
       compute_engkin(natoms,masses,velocities,engkin);
 
 // eventually, write positions and statistics
-      if((istep+1)%nconfig==0) write_positions(trajfile,natoms,positions,cell,wrapatoms);
-      if((istep+1)%nstat==0)   write_statistics(statfile,istep+1,tstep,natoms,ndim,engkin,engconf,engint);
+      if(writer && (istep+1)%nconfig==0) write_positions(trajfile,natoms,positions,cell,wrapatoms);
+      if(writer && (istep+1)%nstat==0)   write_statistics(statfile,istep+1,tstep,natoms,ndim,engkin,engconf,engint);
 
     }
 
+    const double time_total=elapsed(start);
+
 // call final plumed jobs
     plumed->cmd("runFinalJobs");
 
+// report performance
+    fprintf(out,"Performance: %d steps in %f s, %f steps/s\n",nstep,time_total,(time_total>0.0?nstep/time_total:0.0));
+    fprintf(out,"  forces          %f s\n",time_forces);
+    fprintf(out,"  neighbour list  %f s\n",time_list);
+    fprintf(out,"  plumed          %f s\n",time_plumed);
+
 // write final positions
-    write_final_positions(outputfile,natoms,positions,cell,wrapatoms);
+    if(writer) write_final_positions(outputfile,natoms,positions,cell,wrapatoms);
 
 // close the statistic file if it was open:
     if(write_statistics_fp) fclose(write_statistics_fp);
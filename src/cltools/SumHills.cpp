@@ -145,6 +145,16 @@ plumed sum_hills --histo PATHTOMYCOLVARORHILLSFILE  --sigma 0.2,0.2 --kt 0.6 --n
 just to check the hypothetical free energy calculated in single blocks of time during a simulation
 and not in a cumulative way
 
+Hills are read from the files in a streaming fashion and are not kept in memory, so that
+also very long HILLS files can be integrated. When a grid is used they are added to it
+in chunks by multiple threads, whose number is set with the environment variable
+PLUMED_NUM_THREADS. Every thread updates its own portion of the grid so that the result
+does not depend on the number of threads.
+
+\verbatim
+PLUMED_NUM_THREADS=4 plumed sum_hills --hills PATHTOMYHILLSFILE
+\endverbatim
+
 Output format can be controlled via the --fmt field
 
 \verbatim
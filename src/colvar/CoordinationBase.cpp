@@ -159,34 +159,48 @@ void CoordinationBase::calculate()
     std::vector<Vector> omp_deriv(getPositions().size());
     Tensor omp_virial;
 
-    #pragma omp for reduction(+:ncoord) nowait
-    for(unsigned int i=rank; i<nn; i+=stride) {
-
-      Vector distance;
-      unsigned i0=nl->getClosePair(i).first;
-      unsigned i1=nl->getClosePair(i).second;
-
-      if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+// pairs are processed in blocks, so that PBC are applied to a whole batch of distances
+    const unsigned nb=64;
+    double dx[nb],dy[nb],dz[nb];
+    unsigned ip0[nb],ip1[nb];
+    const unsigned nlocal=(rank<nn?(nn-rank+stride-1)/stride:0);
 
-      if(pbc) {
-        distance=pbcDistance(getPosition(i0),getPosition(i1));
-      } else {
-        distance=delta(getPosition(i0),getPosition(i1));
+    #pragma omp for reduction(+:ncoord) nowait
+    for(unsigned ib=0; ib<nlocal; ib+=nb) {
+      const unsigned m=(nlocal-ib<nb?nlocal-ib:nb);
+
+      for(unsigned k=0; k<m; k++) {
+        const unsigned i=rank+(ib+k)*stride;
+        const std::pair<unsigned,unsigned> p=nl->getClosePair(i);
+        ip0[k]=p.first;
+        ip1[k]=p.second;
+        Vector d=delta(getPosition(ip0[k]),getPosition(ip1[k]));
+        dx[k]=d[0]; dy[k]=d[1]; dz[k]=d[2];
       }
-
-      double dfunc=0.;
-      ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
-
-      Vector dd(dfunc*distance);
-      Tensor vv(dd,distance);
-      if(nt>1) {
-        omp_deriv[i0]-=dd;
-        omp_deriv[i1]+=dd;
-        omp_virial-=vv;
-      } else {
-        deriv[i0]-=dd;
-        deriv[i1]+=dd;
-        virial-=vv;
+      if(pbc) getPbc().apply(dx,dy,dz,m);
+
+      for(unsigned k=0; k<m; k++) {
+        unsigned i0=ip0[k];
+        unsigned i1=ip1[k];
+
+        if(getAbsoluteIndex(i0)==getAbsoluteIndex(i1)) continue;
+
+        Vector distance(dx[k],dy[k],dz[k]);
+
+        double dfunc=0.;
+        ncoord += pairing(distance.modulo2(), dfunc,i0,i1);
+
+        Vector dd(dfunc*distance);
+        Tensor vv(dd,distance);
+        if(nt>1) {
+          omp_deriv[i0]-=dd;
+          omp_deriv[i1]+=dd;
+          omp_virial-=vv;
+        } else {
+          deriv[i0]-=dd;
+          deriv[i1]+=dd;
+          virial-=vv;
+        }
       }
 
     }
@@ -27,6 +27,7 @@
 #include "tools/PDB.h"
 #include "tools/RMSD.h"
 #include "tools/Tools.h"
+#include <algorithm>
 #include <cmath>
 
 using namespace std;
@@ -45,6 +46,7 @@ void PathMSDBase::registerKeywords(Keywords& keys) {
   keys.add("optional", "DEBUG-CLOSE", "(default=0) value 1 enables extensive debugging info regarding the close structure, the simulation will run much slower");
   keys.add("optional", "LOG_CLOSE", "same as LOG-CLOSE");
   keys.add("optional", "DEBUG_CLOSE", "same as DEBUG-CLOSE");
+  keys.add("optional","WEIGHT_TOL","frames for which exp(-LAMBDA*(d-dmin)) is smaller than this tolerance are ignored when computing the derivatives. dmin here is the distance from the closest frame");
 }
 
 PathMSDBase::PathMSDBase(const ActionOptions&ao):
@@ -52,6 +54,8 @@ PathMSDBase::PathMSDBase(const ActionOptions&ao):
   nopbc(false),
   neigh_size(-1),
   neigh_stride(-1),
+  usemulti(false),
+  weightTol(0),
   epsilonClose(-1),
   debugClose(0),
   logClose(0),
@@ -68,6 +72,7 @@ PathMSDBase::PathMSDBase(const ActionOptions&ao):
   parse("DEBUG-CLOSE", debugClose);
   if(!debugClose) parse("DEBUG_CLOSE",debugClose);
   parseFlag("NOPBC",nopbc);
+  parse("WEIGHT_TOL",weightTol);
 
   // open the file
   FILE* fp=fopen(reference.c_str(),"r");
@@ -124,6 +129,14 @@ PathMSDBase::PathMSDBase(const ActionOptions&ao):
   if (debugClose)
     log.printf(" Extensive debug info regarding close structure turned on\n");
 
+  if( epsilonClose<=0 && MultiReferenceRMSD::compatible( msdv ) ) {
+    usemulti=true; multimsd.set( msdv );
+    log.printf("  computing distances from all frames in one batch \n");
+    if( weightTol>0 ) log.printf("  frames with weights smaller than %g are ignored when computing derivatives \n",weightTol);
+  } else if( weightTol>0 ) {
+    error("WEIGHT_TOL can only be used when all the frames have the same weights and EPSILON is not used");
+  }
+
   rotationRefClose.resize(nframes);
   savedIndices = vector<unsigned>(nframes);
 
@@ -228,7 +241,30 @@ void PathMSDBase::calculate() {
       }
     }
   }
-  else {
+  else if( usemulti ) {
+    // each processor deals with a contiguous block of frames.  The rotations for all of them are computed in one batch
+    unsigned chunk=( imgVec.size() + stride - 1 ) / stride;
+    unsigned istart=std::min( unsigned(imgVec.size()), rank*chunk ), iend=std::min( unsigned(imgVec.size()), istart + chunk );
+    std::vector<unsigned> myframes( iend - istart );
+    for(unsigned i=istart; i<iend; i++) myframes[i-istart]=imgVec[i].index;
+    Vector center; std::vector<double> msd; std::vector<Tensor> rotations;
+    multimsd.calculateRotations( getPositions(), myframes, center, msd, rotations );
+    // find the frames that have a negligible weight
+    std::vector<double> est_distances;
+    double dmin=0;
+    if( weightTol>0 ) {
+      est_distances.assign( imgVec.size(), 0.0 );
+      for(unsigned i=istart; i<iend; i++) est_distances[i]=msd[i-istart];
+      comm.Sum( est_distances );
+      dmin=*std::min_element( est_distances.begin(), est_distances.end() );
+    }
+    for(unsigned i=istart; i<iend; i++) {
+      if( weightTol>0 && exp(-lambda*(est_distances[i]-dmin))<weightTol ) { tmp_distances[i]=msd[i-istart]; continue; }
+      tmp_distances[i]=multimsd.calculateDerivatives( getPositions(), center, imgVec[i].index, rotations[i-istart], tmp_derivs );
+      #pragma omp simd
+      for(unsigned j=0; j<nat; j++) tmp_derivs2[i*nat+j]=tmp_derivs[j];
+    }
+  } else {
     // store temporary local results
     for(unsigned i=rank; i<imgVec.size(); i+=stride) {
       tmp_distances[i]=msdv[imgVec[i].index].calculate(getPositions(),tmp_derivs,true);
@@ -27,6 +27,7 @@
 
 #include "tools/PDB.h"
 #include "tools/RMSD.h"
+#include "tools/MultiReferenceRMSD.h"
 
 namespace PLMD {
 namespace colvar {
@@ -64,6 +65,12 @@ class PathMSDBase : public Colvar {
   int neigh_size;
   int neigh_stride;
   std::vector<RMSD> msdv;
+/// the reference frames packed together so that all the distances can be computed in one batch
+  MultiReferenceRMSD multimsd;
+/// are we using the batched calculation
+  bool usemulti;
+/// frames whose weight relative to the closest frame is smaller than this do not contribute to the derivatives
+  double weightTol;
   std::string reference;
   std::vector<Vector> derivs_s;
   std::vector<Vector> derivs_z;
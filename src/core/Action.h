@@ -226,7 +226,7 @@ public:
   virtual void runFinalJobs() {}
 
 /// Tell to the Action to flush open files
-  void fflush();
+  virtual void fflush();
 
   virtual std::string getDocumentation()const;
 
@@ -76,7 +76,7 @@ void ActionAtomistic::requestAtoms(const vector<AtomNumber> & a, const bool clea
     else unique.insert(indexes[i]);
   }
   updateUniqueLocal();
-  atoms.unique.clear();
+  atoms.clearUnique();
 }
 
 Vector ActionAtomistic::pbcDistance(const Vector &v1,const Vector &v2)const {
@@ -0,0 +1,74 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "ActionWithBackgroundOutput.h"
+#include "PlumedMain.h"
+#include "tools/File.h"
+#include "tools/Communicator.h"
+
+namespace PLMD {
+
+void ActionWithBackgroundOutput::registerKeywords(Keywords& keys) {
+  keys.addFlag("BACKGROUND",false,"write the file on a separate thread");
+  keys.add("compulsory","BUFFER","2","the maximum number of frames kept in memory waiting to be written when using BACKGROUND");
+}
+
+ActionWithBackgroundOutput::ActionWithBackgroundOutput(const ActionOptions&ao):
+  Action(ao),
+  background(false),
+  buffer(2)
+{
+  parseFlag("BACKGROUND",background);
+  parse("BUFFER",buffer);
+  if(buffer==0) error("BUFFER should be positive");
+  if(background) log.printf("  writing on a separate thread, keeping at most %u frames in memory\n",buffer);
+}
+
+void ActionWithBackgroundOutput::openOutputFile(OFile& of,const std::string& file) {
+  if(background) {
+    if(comm.Get_rank()==0) {
+      of.enforceSuffix(plumed.getSuffix());
+      if(getRestart()) of.enforceRestart();
+      of.open(file);
+      writer.reset(new BackgroundWriter(buffer));
+    }
+  } else {
+    of.link(*this);
+    of.open(file);
+  }
+}
+
+void ActionWithBackgroundOutput::writeInBackground(BackgroundWriter::Task task) {
+  plumed_assert(writer);
+  writer->submit(task);
+}
+
+void ActionWithBackgroundOutput::flushOutput(OFile& of) {
+  if(!writer) return;
+  writer->wait();
+  of.flush();
+}
+
+void ActionWithBackgroundOutput::finishOutput() {
+  writer.reset();
+}
+
+}
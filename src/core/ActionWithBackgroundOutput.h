@@ -0,0 +1,76 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_core_ActionWithBackgroundOutput_h
+#define __PLUMED_core_ActionWithBackgroundOutput_h
+
+#include "Action.h"
+#include "BackgroundWriter.h"
+#include <memory>
+#include <string>
+
+namespace PLMD {
+
+class OFile;
+
+/**
+\ingroup MULTIINHERIT
+This is used to create PLMD::Action objects that can write their output file on a separate thread.
+With the BACKGROUND flag the file is only opened and written by the first process, from a
+PLMD::BackgroundWriter, and thus it is not linked to the communicator.
+Without it the file is opened and written as usual.
+
+Frames submitted with writeInBackground() should only use copies of the data,
+so that the MD code can proceed while they are written.
+*/
+class ActionWithBackgroundOutput:
+  public virtual Action
+{
+/// Write frames on a separate thread
+  bool background;
+/// Maximum number of frames kept in memory waiting to be written
+  unsigned buffer;
+/// The writer, only allocated on the first process
+  std::unique_ptr<BackgroundWriter> writer;
+protected:
+/// Open the output file
+  void openOutputFile(OFile& of,const std::string& file);
+/// Check if frames are written in the background
+  bool inBackground()const {return background;}
+/// Check if frames are written by this process
+  bool writesOutput()const {return !background || writer;}
+/// Write a frame on the writer thread
+  void writeInBackground(BackgroundWriter::Task task);
+/// Wait for the pending frames to be written, then flush the file
+  void flushOutput(OFile& of);
+/// Write the pending frames and stop the writer thread.
+/// Should be called in the destructor of the derived class, before the file and
+/// the data used by the frames are destroyed
+  void finishOutput();
+public:
+  explicit ActionWithBackgroundOutput(const ActionOptions&);
+/// Create the keywords for actionWithBackgroundOutput
+  static void registerKeywords(Keywords& keys);
+};
+
+}
+
+#endif
@@ -145,15 +145,21 @@ void Atoms::share() {
   }
 
   if(!(int(gatindex.size())==natoms && shuffledAtoms==0)) {
+    // unique is only regenerated when an action that was not contributing to it becomes active
+    bool changed=false;
     for(unsigned i=0; i<actions.size(); i++) {
       if(actions[i]->isActive()) {
         if(!actions[i]->getUnique().empty()) {
           atomsNeeded=true;
-          // unique are the local atoms
-          unique.insert(actions[i]->getUniqueLocal().begin(),actions[i]->getUniqueLocal().end());
+          if(!uniqueHasAction[i]) {
+            // unique are the local atoms
+            for(const auto & p : actions[i]->getUniqueLocal()) uniqueMask[p.index()]=true;
+            uniqueHasAction[i]=true; changed=true;
+          }
         }
       }
     }
+    if(changed) updateUniqueFromMask();
   } else {
     for(unsigned i=0; i<actions.size(); i++) {
       if(actions[i]->isActive()) {
@@ -169,25 +175,37 @@ void Atoms::share() {
 }
 
 void Atoms::shareAll() {
-  unique.clear();
+  clearUnique();
   // keep in unique only those atoms that are local
   if(dd && shuffledAtoms>0) {
-    for(int i=0; i<natoms; i++) if(g2l[i]>=0) unique.insert(AtomNumber::index(i));
+    for(int i=0; i<natoms; i++) if(g2l[i]>=0) uniqueMask[i]=true;
   } else {
-    for(int i=0; i<natoms; i++) unique.insert(AtomNumber::index(i));
+    uniqueMask.assign(natoms,true);
   }
+  updateUniqueFromMask();
   atomsNeeded=true;
   share(unique);
 }
 
-void Atoms::share(const std::set<AtomNumber>& unique) {
+void Atoms::clearUnique() {
+  unique.clear();
+  uniqueMask.assign(natoms,false);
+  uniqueHasAction.assign(actions.size(),false);
+}
+
+void Atoms::updateUniqueFromMask() {
+  unique.clear();
+  for(int i=0; i<natoms; i++) if(uniqueMask[i]) unique.push_back(AtomNumber::index(i));
+}
+
+void Atoms::share(const std::vector<AtomNumber>& unique) {
   plumed_assert( positionsHaveBeenSet==3 && massesHaveBeenSet );
 
   virial.zero();
   if(zeroallforces || int(gatindex.size())==natoms) {
     for(int i=0; i<natoms; i++) forces[i].zero();
   } else {
-    for(const auto & p : unique) forces[p.index()].zero();
+    for(unsigned i=0; i<unique.size(); i++) forces[unique[i].index()].zero();
   }
   for(unsigned i=getNatoms(); i<positions.size(); i++) forces[i].zero(); // virtual atoms
   forceOnEnergy=0.0;
@@ -203,7 +221,7 @@ void Atoms::share(const std::set<AtomNumber>& unique) {
     uniq_index.clear();
     uniq_index.reserve(unique.size());
     if(shuffledAtoms>0) {
-      for(const auto & p : unique) uniq_index.push_back(g2l[p.index()]);
+      for(unsigned i=0; i<unique.size(); i++) uniq_index.push_back(g2l[unique[i].index()]);
     }
     mdatoms->getPositions(unique,uniq_index,positions);
   }
@@ -331,6 +349,7 @@ void Atoms::updateForces() {
 
 void Atoms::setNatoms(int n) {
   natoms=n;
+  clearUnique();
   positions.resize(n);
   forces.resize(n);
   masses.resize(n);
@@ -342,12 +361,14 @@ void Atoms::setNatoms(int n) {
 
 void Atoms::add(ActionAtomistic*a) {
   actions.push_back(a);
+  clearUnique();
 }
 
 void Atoms::remove(ActionAtomistic*a) {
   auto f=find(actions.begin(),actions.end(),a);
   plumed_massert(f!=actions.end(),"cannot remove an action registered to atoms");
   actions.erase(f);
+  clearUnique();
 }
 
 
@@ -405,7 +426,7 @@ void Atoms::setAtomsGatindex(int*g,bool fortran) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setAtomsContiguous(int start) {
@@ -418,7 +439,7 @@ void Atoms::setAtomsContiguous(int start) {
     // keep in unique only those atoms that are local
     actions[i]->updateUniqueLocal();
   }
-  unique.clear();
+  clearUnique();
 }
 
 void Atoms::setRealPrecision(int p) {
@@ -466,19 +487,20 @@ void Atoms::createFullList(int*n) {
 // We update here the unique list defined at Atoms::unique.
 // This is not very clear, and probably should be coded differently.
 // Hopefully this fix the longstanding issue with NAMD.
-    unique.clear();
+    clearUnique();
     for(unsigned i=0; i<actions.size(); i++) {
       if(actions[i]->isActive()) {
         if(!actions[i]->getUnique().empty()) {
           atomsNeeded=true;
           // unique are the local atoms
-          unique.insert(actions[i]->getUnique().begin(),actions[i]->getUnique().end());
+          for(const auto & p : actions[i]->getUnique()) uniqueMask[p.index()]=true;
         }
       }
     }
+    updateUniqueFromMask();
     fullList.resize(0);
     fullList.reserve(unique.size());
-    for(const auto & p : unique) fullList.push_back(p.index());
+    for(unsigned i=0; i<unique.size(); i++) fullList.push_back(unique[i].index());
     *n=fullList.size();
   }
 }
@@ -49,7 +49,12 @@ class Atoms
   friend class ActionAtomistic;
   friend class ActionWithVirtualAtom;
   int natoms;
-  std::set<AtomNumber> unique;
+/// Sorted list of the local atoms needed by the active actions
+  std::vector<AtomNumber> unique;
+/// Bitmap with the atoms in unique, so that it can be updated without sorting
+  std::vector<bool> uniqueMask;
+/// uniqueHasAction[i] is true if the atoms of actions[i] are already in unique
+  std::vector<bool> uniqueHasAction;
   std::vector<unsigned> uniq_index;
 /// Map global indexes to local indexes
 /// E.g. g2l[i] is the position of atom i in the array passed from the MD engine.
@@ -139,7 +144,11 @@ class Atoms
   DomainDecomposition dd;
   long int ddStep;  //last step in which dd happened
 
-  void share(const std::set<AtomNumber>&);
+  void share(const std::vector<AtomNumber>&);
+/// Empty unique, so that it is recomputed at the next step
+  void clearUnique();
+/// Regenerate the sorted list unique from uniqueMask
+  void updateUniqueFromMask();
 
 public:
 
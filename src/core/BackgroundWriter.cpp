@@ -0,0 +1,108 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "BackgroundWriter.h"
+#include "tools/Exception.h"
+#include <cstdio>
+#include <exception>
+
+namespace PLMD {
+
+BackgroundWriter::BackgroundWriter(unsigned capacity):
+  capacity(capacity),
+  busy(false),
+  stop(false)
+{
+}
+
+BackgroundWriter::~BackgroundWriter() {
+  if(!worker.joinable()) return;
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    stop=true;
+  }
+  cv.notify_all();
+  worker.join();
+// destructors cannot throw
+  if(!error.empty()) std::fprintf(stderr,"PLUMED: error while writing in the background: %s\n",error.c_str());
+}
+
+void BackgroundWriter::run() {
+  std::unique_lock<std::mutex> lock(mtx);
+  while(true) {
+    cv.wait(lock,[this] {return stop || !queue.empty();});
+// pending tasks are executed also when stopping
+    if(queue.empty()) return;
+    Task task=std::move(queue.front().task);
+    queue.pop_front();
+    busy=true;
+    lock.unlock();
+    std::string msg;
+    try {
+      task();
+    } catch(const std::exception & e) {
+      msg=e.what();
+    }
+    lock.lock();
+    busy=false;
+    if(msg.length()>0) error+=msg;
+    cv.notify_all();
+  }
+}
+
+void BackgroundWriter::checkError() {
+  if(error.empty()) return;
+  std::string msg=error;
+  error.clear();
+  plumed_merror("error while writing in the background: "+msg);
+}
+
+void BackgroundWriter::submit(Task task,const std::string& key) {
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+    checkError();
+    bool replaced=false;
+    if(key.length()>0) for(auto & i : queue) if(i.key==key) {
+          i.task=std::move(task);
+          replaced=true;
+          break;
+        }
+    if(!replaced) {
+// back-pressure: do not accumulate tasks faster than they are executed
+      if(capacity>0) cv.wait(lock,[this] {return queue.size()+(busy?1:0)<capacity;});
+      checkError();
+      Item item;
+      item.key=key;
+      item.task=std::move(task);
+      queue.push_back(std::move(item));
+    }
+    if(!worker.joinable()) worker=std::thread(&BackgroundWriter::run,this);
+  }
+  cv.notify_all();
+}
+
+void BackgroundWriter::wait() {
+  std::unique_lock<std::mutex> lock(mtx);
+  cv.wait(lock,[this] {return queue.empty() && !busy;});
+  checkError();
+}
+
+}
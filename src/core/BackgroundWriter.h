@@ -0,0 +1,89 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_core_BackgroundWriter_h
+#define __PLUMED_core_BackgroundWriter_h
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace PLMD {
+
+/**
+Queue of tasks executed in order on a separate thread.
+
+It is used to write files without making the MD code wait for formatting,
+compression and I/O: the caller copies the data that should be written and
+submit()s a function that writes the copy.
+
+- If capacity is positive, at most capacity tasks are pending or running:
+when the writer thread falls behind, submit() blocks until a task has been completed.
+With a capacity of two, one frame is filled while the previous one is written (double buffering).
+- A task submitted with a non-empty key replaces a pending task with the same key,
+so that only the latest copy of e.g. a restart file is written.
+- Errors raised by the tasks are reported on the main thread at the next call
+to submit() or wait().
+
+The thread is only started when the first task is submitted.
+*/
+class BackgroundWriter {
+public:
+/// Function executed on the writer thread
+  typedef std::function<void()> Task;
+private:
+  struct Item {
+    std::string key;
+    Task task;
+  };
+/// Maximum number of tasks that are pending or running (zero means no limit)
+  unsigned capacity;
+/// Tasks waiting to be executed
+  std::deque<Item> queue;
+/// True while the writer thread is executing a task
+  bool busy;
+/// True when the writer thread should exit
+  bool stop;
+/// Error message from the writer thread, reported at the next call from the main thread
+  std::string error;
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::thread worker;
+/// Loop run by the writer thread
+  void run();
+/// Raise errors from the writer thread (with the lock held)
+  void checkError();
+public:
+  explicit BackgroundWriter(unsigned capacity=0);
+/// Waits for pending tasks to be executed
+  ~BackgroundWriter();
+/// Execute a task in the background, replacing the pending task with the same key if any
+  void submit(Task task,const std::string& key="");
+/// Wait for all the submitted tasks to be executed
+  void wait();
+};
+
+}
+
+#endif
@@ -0,0 +1,95 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "Checkpoint.h"
+#include "tools/Exception.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+
+namespace PLMD {
+
+Checkpoint::Checkpoint():
+  async(true)
+{
+  if(std::getenv("PLUMED_ASYNC_CHECKPOINT")) {
+    std::string s(std::getenv("PLUMED_ASYNC_CHECKPOINT"));
+    if(s=="yes") async=true;
+    else if(s=="no") async=false;
+    else plumed_merror("PLUMED_ASYNC_CHECKPOINT variable is set to " + s + "; should be yes or no");
+  }
+}
+
+void Checkpoint::write(const std::string& path,const Writer& writer,const std::string& backup) {
+  std::string fname=path;
+  size_t found=fname.find_last_of("/\\");
+  std::string directory=fname.substr(0,found+1);
+  std::string file=fname.substr(found+1);
+// temporary file in the same directory, so that rename() is atomic
+  std::string tmp=directory+"tmp."+file;
+  writer(tmp);
+  if(backup.length()>0) {
+    std::string bck=directory+backup+"."+file;
+// hard link, so that the file is always present on its final path
+// (falling back to rename on file systems without hard links)
+    std::remove(bck.c_str());
+    if(link(fname.c_str(),bck.c_str())!=0 && errno!=ENOENT) {
+      int check=std::rename(fname.c_str(),bck.c_str());
+      plumed_massert(check==0,"renaming "+fname+" into "+bck+" failed for reason: "+std::strerror(errno));
+    }
+  }
+  int check=std::rename(tmp.c_str(),fname.c_str());
+  plumed_massert(check==0,"renaming "+tmp+" into "+fname+" failed for reason: "+std::strerror(errno));
+}
+
+void Checkpoint::submit(const std::string& path,Writer writer,const std::string& backup) {
+  if(!async) {
+    write(path,writer,backup);
+    return;
+  }
+  worker.submit([path,writer,backup]() {
+    write(path,writer,backup);
+  },path);
+}
+
+void Checkpoint::wait() {
+  worker.wait();
+}
+
+void Checkpoint::add(const Action* action,Snapshot snapshot) {
+  snapshots.push_back(std::make_pair(action,snapshot));
+}
+
+void Checkpoint::remove(const Action* action) {
+  for(unsigned i=0; i<snapshots.size();) {
+    if(snapshots[i].first==action) snapshots.erase(snapshots.begin()+i);
+    else i++;
+  }
+}
+
+void Checkpoint::snapshot() {
+  for(const auto & s : snapshots) s.second();
+  wait();
+}
+
+}
@@ -0,0 +1,84 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_core_Checkpoint_h
+#define __PLUMED_core_Checkpoint_h
+
+#include "BackgroundWriter.h"
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace PLMD {
+
+class Action;
+
+/**
+Background writer for restart files.
+
+Actions that periodically dump their state (e.g. grids of history-dependent biases)
+take a copy of it in memory and submit() a function that writes the copy.
+The function is called by a BackgroundWriter with the name of a temporary file,
+which is then renamed on the final path. In this way the MD code does not wait for I/O
+and the final file is always complete, even if the simulation is killed while writing.
+If a file is submitted again before the previous copy has been written, only the latest copy is written.
+
+Actions can also add() a function that takes a snapshot of their state and submits it.
+When the MD code signals a checkpoint, PlumedMain calls snapshot(), which calls these functions
+and waits for all the files to be written, so that restart files are consistent with the
+checkpoint of the MD code.
+Setting the environment variable PLUMED_ASYNC_CHECKPOINT=no makes all writes synchronous.
+*/
+class Checkpoint {
+public:
+/// Function writing a snapshot on the file whose path is passed as an argument
+  typedef std::function<void(const std::string&)> Writer;
+/// Function taking a copy of the state of an action and submitting it
+  typedef std::function<void()> Snapshot;
+private:
+/// Write files on a separate thread
+  bool async;
+  BackgroundWriter worker;
+/// Functions called at checkpoints, in the order in which they were added
+  std::vector<std::pair<const Action*,Snapshot> > snapshots;
+/// Write a file and move it on its final path
+  static void write(const std::string& path,const Writer& writer,const std::string& backup);
+public:
+  Checkpoint();
+/// Write a file in the background.
+/// If backup is not empty, the previous version of the file is kept
+/// with this prefix (e.g. "bck.last" keeps path as bck.last.path, as done by OFile::rewind())
+  void submit(const std::string& path,Writer writer,const std::string& backup="");
+/// Wait for all the submitted files to be written
+  void wait();
+/// Add a function called at checkpoints.
+/// Actions adding a function should remove it in their destructor
+  void add(const Action*,Snapshot);
+/// Remove the functions added by an action
+  void remove(const Action*);
+/// Take the snapshots and wait for all the files to be written
+  void snapshot();
+};
+
+}
+
+#endif
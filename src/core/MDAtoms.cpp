@@ -86,14 +86,14 @@ public:
   }
   void getBox(Tensor &)const;
   void getPositions(const vector<int>&index,vector<Vector>&positions)const;
-  void getPositions(const std::set<AtomNumber>&index,const vector<unsigned>&i,vector<Vector>&positions)const;
+  void getPositions(const std::vector<AtomNumber>&index,const vector<unsigned>&i,vector<Vector>&positions)const;
   void getPositions(unsigned j,unsigned k,vector<Vector>&positions)const;
   void getLocalPositions(std::vector<Vector>&p)const;
   void getMasses(const vector<int>&index,vector<double>&)const;
   void getCharges(const vector<int>&index,vector<double>&)const;
   void updateVirial(const Tensor&)const;
   void updateForces(const vector<int>&index,const vector<Vector>&);
-  void updateForces(const std::set<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces);
+  void updateForces(const std::vector<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces);
   void rescaleForces(const vector<int>&index,double factor);
   unsigned  getRealPrecision()const;
 };
@@ -131,14 +131,14 @@ void MDAtomsTyped<T>::getPositions(const vector<int>&index,vector<Vector>&positi
 }
 
 template <class T>
-void MDAtomsTyped<T>::getPositions(const std::set<AtomNumber>&index,const vector<unsigned>&i, vector<Vector>&positions)const {
-// cannot be parallelized with omp because access to positions is not ordered
-  unsigned k=0;
-  for(const auto & p : index) {
-    positions[p.index()][0]=px[stride*i[k]]*scalep;
-    positions[p.index()][1]=py[stride*i[k]]*scalep;
-    positions[p.index()][2]=pz[stride*i[k]]*scalep;
-    k++;
+void MDAtomsTyped<T>::getPositions(const std::vector<AtomNumber>&index,const vector<unsigned>&i, vector<Vector>&positions)const {
+// atoms in index are unique, so each iteration writes a different element of positions
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(index))
+  for(unsigned k=0; k<index.size(); ++k) {
+    unsigned p=index[k].index();
+    positions[p][0]=px[stride*i[k]]*scalep;
+    positions[p][1]=py[stride*i[k]]*scalep;
+    positions[p][2]=pz[stride*i[k]]*scalep;
   }
 }
 
@@ -182,13 +182,13 @@ void MDAtomsTyped<T>::updateVirial(const Tensor&virial)const {
 }
 
 template <class T>
-void MDAtomsTyped<T>::updateForces(const std::set<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces) {
-  unsigned k=0;
-  for(const auto & p : index) {
-    fx[stride*i[k]]+=scalef*T(forces[p.index()][0]);
-    fy[stride*i[k]]+=scalef*T(forces[p.index()][1]);
-    fz[stride*i[k]]+=scalef*T(forces[p.index()][2]);
-    k++;
+void MDAtomsTyped<T>::updateForces(const std::vector<AtomNumber>&index,const vector<unsigned>&i,const vector<Vector>&forces) {
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(index))
+  for(unsigned k=0; k<index.size(); ++k) {
+    unsigned p=index[k].index();
+    fx[stride*i[k]]+=scalef*T(forces[p][0]);
+    fy[stride*i[k]]+=scalef*T(forces[p][1]);
+    fz[stride*i[k]]+=scalef*T(forces[p][2]);
   }
 }
 
@@ -30,6 +30,7 @@
 #include "CLToolMain.h"
 #include "ExchangePatterns.h"
 #include "GREX.h"
+#include "Checkpoint.h"
 #include "config/Config.h"
 #include "tools/Citations.h"
 #include "tools/Communicator.h"
@@ -173,14 +174,17 @@ void PlumedMain::cmd(const std::string & word,void*val) {
 
     auto ss=stopwatch.startPause();
 
-    std::vector<std::string> words=Tools::getWords(word);
-    unsigned nw=words.size();
+// Commands made of a single word (including all those used at every step)
+// are not split, which saves a few allocations per call
+    std::vector<std::string> words;
+    if(word.find_first_of(" \t\n")!=std::string::npos) words=Tools::getWords(word);
+    unsigned nw=(words.empty() ? (word.empty() ? 0 : 1) : words.size());
     if(nw==0) {
       // do nothing
     } else {
       int iword=-1;
       double d;
-      const auto it=word_map.find(words[0]);
+      const auto it=word_map.find(words.empty() ? word : words[0]);
       if(it!=word_map.end()) iword=it->second;
       switch(iword) {
       case cmd_setBox:
@@ -278,6 +282,23 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         step=(*static_cast<long int*>(val));
         atoms.startStep();
         break;
+      /* ADDED WITH API==7 */
+      case cmd_setStepData:
+        CHECK_INIT(initialized,word);
+        CHECK_NOTNULL(val,word);
+        {
+          auto data=static_cast<plumed_step_data*>(val);
+          step=data->step;
+          atoms.startStep();
+          if(data->box) atoms.setBox(const_cast<void*>(data->box));
+          if(data->positions) atoms.setPositions(const_cast<void*>(data->positions));
+          if(data->masses) atoms.setMasses(const_cast<void*>(data->masses));
+          if(data->charges) atoms.setCharges(const_cast<void*>(data->charges));
+          if(data->forces) atoms.setForces(data->forces);
+          if(data->virial) atoms.setVirial(data->virial);
+          if(data->energy) atoms.setEnergy(const_cast<void*>(data->energy));
+        }
+        break;
       // words used less frequently:
       case cmd_setAtomsNlocal:
         CHECK_INIT(initialized,word);
@@ -352,7 +373,7 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         break;
       case cmd_getApiVersion:
         CHECK_NOTNULL(val,word);
-        *(static_cast<int*>(val))=6;
+        *(static_cast<int*>(val))=7;
         break;
       // commands which can be used only before initialization:
       case cmd_init:
@@ -536,6 +557,7 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         atoms.setExtraCVForce(words[1],val);
         break;
       case cmd_GREX:
+        plumed_assert(nw>=2);
         if(!grex) grex.reset(new GREX(*this));
         plumed_massert(grex,"error allocating grex");
         {
@@ -546,6 +568,7 @@ void PlumedMain::cmd(const std::string & word,void*val) {
         break;
       case cmd_CLTool:
         CHECK_NOTINIT(initialized,word);
+        plumed_assert(nw>=2);
         if(!cltool) cltool.reset(new CLToolMain);
         {
           std::string kk=words[1];
@@ -874,6 +897,9 @@ void PlumedMain::update() {
     log.flush();
     for(const auto & p : actionSet) p->fflush();
   }
+// actions take snapshots of their state, which should be on disk
+// when the MD code writes its checkpoint
+  if(doCheckPoint) checkpoint.snapshot();
 }
 
 void PlumedMain::load(const std::string& ss) {
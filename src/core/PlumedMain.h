@@ -64,6 +64,7 @@ class Citations;
 class ExchangePatterns;
 class FileBase;
 class DataFetchingObject;
+class Checkpoint;
 
 /**
 Main plumed object.
@@ -107,6 +108,19 @@ private:
 
   plumed_error_handler error_handler= {NULL,NULL};
 
+/// Argument of cmd("setStepData").
+/// Should be kept consistent with the definition in Plumed.h.
+  typedef struct {
+    long int step;
+    const void* box;
+    const void* positions;
+    const void* masses;
+    const void* charges;
+    void* forces;
+    void* virial;
+    const void* energy;
+  } plumed_step_data;
+
 /// Forward declaration.
   ForwardDecl<DLLoader> dlloader_fwd;
   DLLoader& dlloader=*dlloader_fwd;
@@ -157,6 +171,12 @@ private:
 /// Object containing information about atoms (such as positions,...).
   Atoms&    atoms=*atoms_fwd;           // atomic coordinates
 
+/// Forward declaration.
+  ForwardDecl<Checkpoint> checkpoint_fwd;
+/// Background writer for restart files
+/// (declared before actionSet, so that actions are destroyed first)
+  Checkpoint& checkpoint=*checkpoint_fwd;
+
 /// Forward declaration.
   ForwardDecl<ActionSet> actionSet_fwd;
 /// Set of actions found in plumed.dat file
@@ -206,6 +226,11 @@ public:
 /// Flag to switch on detailed timers
   bool detailedTimers;
 
+/// Stopwatch timing the calculation, accessible so that its instrumentation can be configured
+  Stopwatch& getStopwatch() {
+    return stopwatch;
+  }
+
 /// Generic map string -> double
 /// intended to pass information across Actions
   std::map<std::string,double> passMap;
@@ -333,6 +358,8 @@ public:
   const ActionSet & getActionSet()const;
 /// Referenge to the log stream
   Log & getLog();
+/// Reference to the background writer for restart files
+  Checkpoint& getCheckpoint();
 /// Return the number of the step
   long int getStep()const {return step;}
 /// Stop the run
@@ -408,6 +435,11 @@ Atoms& PlumedMain::getAtoms() {
   return atoms;
 }
 
+inline
+Checkpoint& PlumedMain::getCheckpoint() {
+  return checkpoint;
+}
+
 inline
 const std::string & PlumedMain::getSuffix()const {
   return suffix;
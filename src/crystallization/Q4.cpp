@@ -185,18 +185,6 @@ Q4::Q4(const ActionOptions& ao ):
   Steinhardt(ao)
 {
   setAngularMomentum(4);
-
-  normaliz.resize( 5 );
-  normaliz[0] = sqrt( ( 9.0*24.0 ) / (4.0*pi*24.0) );
-  normaliz[1] = -sqrt( ( 9.0*6.0 ) / (4.0*pi*120.0) );
-  normaliz[2] = sqrt( ( 9.0*2.0) / (4.0*pi*720.0) );
-  normaliz[3] = -sqrt( ( 9.0*1) / (4.0*pi*5040.0) );
-  normaliz[4] = sqrt( (9.0*1) / (4.0*pi*40320.0) );
-
-  coeff_poly.resize( 5 );
-  coeff_poly[0]=0.375; coeff_poly[1]=0.0;
-  coeff_poly[2]=-3.75; coeff_poly[3]=0.0;
-  coeff_poly[4]=4.375;
 }
 
 }
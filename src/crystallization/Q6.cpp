@@ -185,21 +185,6 @@ Q6::Q6(const ActionOptions& ao ):
   Steinhardt(ao)
 {
   setAngularMomentum(6);
-
-  normaliz.resize( 7 );
-  normaliz[0] = sqrt( ( 13.0*720.0 ) / (4.0*pi*720.0) );
-  normaliz[1] = -sqrt( ( 13.0*120.0 ) / (4.0*pi*5040) );
-  normaliz[2] = sqrt( ( 13.0*24) / (4.0*pi*40320) );
-  normaliz[3] = -sqrt( ( 13.0*6) / (4.0*pi*362880) );
-  normaliz[4] = sqrt( (13.0*2) / (4.0*pi*3628800) );
-  normaliz[5] = -sqrt( (13.0*1) / (4.0*pi*39916800) );
-  normaliz[6] = sqrt( (13.0*1) / (4.0*pi*479001600) );
-
-  coeff_poly.resize( 7 );
-  coeff_poly[0]=-0.3125; coeff_poly[1]=0.0;
-  coeff_poly[2]=6.5625; coeff_poly[3]=0.0;
-  coeff_poly[4]=-19.6875; coeff_poly[5]=0.0;
-  coeff_poly[6]=14.4375;
 }
 
 }
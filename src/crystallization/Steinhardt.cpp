@@ -21,11 +21,16 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "Steinhardt.h"
 #include "core/PlumedMain.h"
-#include <complex>
+#include "tools/Tools.h"
 
 namespace PLMD {
 namespace crystallization {
 
+/// Number of neighbors that are processed together in calculateVector
+static const unsigned steinhardtBlockSize=32;
+/// Largest angular momentum for which the work space of calculateVector is sized
+static const unsigned steinhardtMaxMoment=8;
+
 void Steinhardt::registerKeywords( Keywords& keys ) {
   VectorMultiColvar::registerKeywords( keys );
   keys.add("compulsory","NN","12","The n parameter of the switching function ");
@@ -66,86 +71,104 @@ Steinhardt::Steinhardt( const ActionOptions& ao ):
 }
 
 void Steinhardt::setAngularMomentum( const unsigned& ang ) {
+  plumed_massert( ang<=steinhardtMaxMoment, "angular momentum is too large for Steinhardt parameters" );
   tmom=ang; setVectorDimensionality( 2*(2*ang + 1) );
+
+  // Legendre polynomial coefficients from ( n+1 )P_{n+1} = ( 2n+1 )xP_n - nP_{n-1}
+  std::vector<double> pm( ang+1, 0.0 ), pp( ang+1 );
+  coeff_poly.assign( ang+1, 0.0 ); coeff_poly[0]=1.0;
+  for(unsigned n=0; n<ang; ++n) {
+    pp.assign( ang+1, 0.0 );
+    for(unsigned k=0; k<=n; ++k) pp[k+1] = (2*n+1)*coeff_poly[k];
+    for(unsigned k=0; k<=ang; ++k) pp[k] = ( pp[k] - n*pm[k] ) / (n+1);
+    pm=coeff_poly; coeff_poly=pp;
+  }
+
+  // Spherical harmonics normalization:
+  // even =  sqrt ( ((2l+1)*(l-m)!) / (4*pi*(l+m)!) )
+  // odd  = -sqrt ( ((2l+1)*(l-m)!) / (4*pi*(l+m)!) )
+  normaliz.resize( ang+1 );
+  for(unsigned m=0; m<=ang; ++m) {
+    double fminus=1.0, fplus=1.0;
+    for(unsigned j=2; j<=ang-m; ++j) fminus*=j;
+    for(unsigned j=2; j<=ang+m; ++j) fplus*=j;
+    normaliz[m] = sqrt( ( (2*ang+1)*fminus ) / (4.0*pi*fplus) );
+    if( m%2==1 ) normaliz[m] = -normaliz[m];
+  }
+
+  // Coefficients of the polynomial in z/r that multiplies ((x+iy)/r)^m in Y_lm.  This is
+  // the normalization times the mth derivative of the Legendre polynomial
+  poly_table.assign( (ang+1)*(ang+1), 0.0 );
+  for(unsigned m=0; m<=ang; ++m) {
+    for(unsigned k=0; k<=ang-m; ++k) {
+      double fact=1.0;
+      for(unsigned j=k+1; j<=k+m; ++j) fact*=j;
+      poly_table[m*(ang+1)+k] = normaliz[m]*coeff_poly[k+m]*fact;
+    }
+  }
 }
 
 void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
-  double dfunc, dpoly_ass, md, tq6, itq6, real_z, imag_z;
-  Vector dz, myrealvec, myimagvec, real_dz, imag_dz;
-  // The square root of -1
-  std::complex<double> ii( 0.0, 1.0 ), dp_x, dp_y, dp_z;
+  const unsigned ncomp=2*tmom+1, nb=steinhardtBlockSize, ntab=tmom+1;
+  // Work space for one block of neighbors.  The spherical harmonics and their derivatives
+  // with respect to the bond vector are stored for all m as structures of arrays.
+  // It has a fixed size, so that nothing is allocated for each task
+  unsigned ind[steinhardtBlockSize];
+  double buffer[(8+8*(steinhardtMaxMoment+1))*steinhardtBlockSize];
+  double* x=buffer; double* y=x+nb; double* z=y+nb; double* d2=z+nb;
+  double* sw=d2+nb; double* df=sw+nb; double* pwr=df+nb; double* pwi=pwr+nb;
+  double* re=pwi+nb; double* im=re+ntab*nb;
+  double* rex=im+ntab*nb; double* rey=rex+ntab*nb; double* rez=rey+ntab*nb;
+  double* imx=rez+ntab*nb; double* imy=imx+ntab*nb; double* imz=imy+ntab*nb;
 
-  unsigned ncomp=2*tmom+1;
-  double sw, poly_ass, dlen; std::complex<double> powered;
+  unsigned n=0;
   for(unsigned i=1; i<myatoms.getNumberOfAtoms(); ++i) {
     Vector& distance=myatoms.getPosition(i);  // getSeparation( myatoms.getPosition(0), myatoms.getPosition(i) );
-    double d2;
-    if ( (d2=distance[0]*distance[0])<rcut2 &&
-         (d2+=distance[1]*distance[1])<rcut2 &&
-         (d2+=distance[2]*distance[2])<rcut2 &&
-         d2>epsilon ) {
-
-      dlen = sqrt(d2);
-      sw = switchingFunction.calculate( dlen, dfunc );
-      accumulateSymmetryFunction( -1, i, sw, (+dfunc)*distance, (-dfunc)*Tensor( distance,distance ), myatoms );
-      double dlen3 = d2*dlen;
-      // Do stuff for m=0
-      poly_ass=deriv_poly( 0, distance[2]/dlen, dpoly_ass );
-      // Derivatives of z/r wrt x, y, z
-      dz = -( distance[2] / dlen3 )*distance; dz[2] += (1.0 / dlen);
-      // Derivative wrt to the vector connecting the two atoms
-      myrealvec = (+sw)*dpoly_ass*dz + poly_ass*(+dfunc)*distance;
-      // Accumulate the derivatives
-      accumulateSymmetryFunction( 2 + tmom, i, sw*poly_ass, myrealvec, Tensor( -myrealvec,distance ), myatoms );
-
-      // The complex number of which we have to take powers
-      std::complex<double> com1( distance[0]/dlen,distance[1]/dlen );
-      powered = std::complex<double>(1.0,0.0);
-
-      // Do stuff for all other m values
-      for(unsigned m=1; m<=tmom; ++m) {
-        // Calculate Legendre Polynomial
-        poly_ass=deriv_poly( m, distance[2]/dlen, dpoly_ass );
-        // Calculate power of complex number
-        // if(std::abs(com1)>epsilon) powered=pow(com1,m-1);
-        // else if(m==1) powered=std::complex<double>(1.,0);
-        // else powered = std::complex<double>(0.,0.);
-        // Real and imaginary parts of z
-        real_z = real(com1*powered); imag_z = imag(com1*powered );
-
-        // Calculate steinhardt parameter
-        tq6=poly_ass*real_z;   // Real part of steinhardt parameter
-        itq6=poly_ass*imag_z;  // Imaginary part of steinhardt parameter
-
-        // Derivatives wrt ( x/r + iy )^m
-        md=static_cast<double>(m);
-        dp_x = md*powered*( (1.0/dlen)-(distance[0]*distance[0])/dlen3-ii*(distance[0]*distance[1])/dlen3 );
-        dp_y = md*powered*( ii*(1.0/dlen)-(distance[0]*distance[1])/dlen3-ii*(distance[1]*distance[1])/dlen3 );
-        dp_z = md*powered*( -(distance[0]*distance[2])/dlen3-ii*(distance[1]*distance[2])/dlen3 );
-
-        // Derivatives of real and imaginary parts of above
-        real_dz[0] = real( dp_x ); real_dz[1] = real( dp_y ); real_dz[2] = real( dp_z );
-        imag_dz[0] = imag( dp_x ); imag_dz[1] = imag( dp_y ); imag_dz[2] = imag( dp_z );
-
-        // Complete derivative of steinhardt parameter
-        myrealvec = (+sw)*dpoly_ass*real_z*dz + (+dfunc)*distance*tq6 + (+sw)*poly_ass*real_dz;
-        myimagvec = (+sw)*dpoly_ass*imag_z*dz + (+dfunc)*distance*itq6 + (+sw)*poly_ass*imag_dz;
-
-        // Real part
-        accumulateSymmetryFunction( 2 + tmom + m, i, sw*tq6, myrealvec, Tensor( -myrealvec,distance ), myatoms );
-        // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom+m, i, sw*itq6, myimagvec, Tensor( -myimagvec,distance ), myatoms );
-        // Store -m part of vector
-        double pref=pow(-1.0,m);
-        // -m part of vector is just +m part multiplied by (-1.0)**m and multiplied by complex
-        // conjugate of Legendre polynomial
-        // Real part
-        accumulateSymmetryFunction( 2+tmom-m, i, pref*sw*tq6, pref*myrealvec, pref*Tensor( -myrealvec,distance ), myatoms );
-        // Imaginary part
-        accumulateSymmetryFunction( 2+ncomp+tmom-m, i, -pref*sw*itq6, -pref*myimagvec, pref*Tensor( myimagvec,distance ), myatoms );
-        // Calculate next power of complex number
-        powered *= com1;
+    double dd;
+    if ( (dd=distance[0]*distance[0])<rcut2 &&
+         (dd+=distance[1]*distance[1])<rcut2 &&
+         (dd+=distance[2]*distance[2])<rcut2 &&
+         dd>epsilon ) {
+      ind[n]=i; x[n]=distance[0]; y[n]=distance[1]; z[n]=distance[2]; d2[n]=dd;
+      sw[n]=switchingFunction.calculateSqr( dd, df[n] ); n++;
+    }
+    if( n==nb || ( n>0 && i+1==myatoms.getNumberOfAtoms() ) ) {
+      computeHarmonics( n, x, y, z, d2, sw, df, pwr, pwi, re, im, rex, rey, rez, imx, imy, imz );
+
+      if( mybasemulticolvars.size()>0 ) {
+        // Weights of the atoms in the coordination sphere must be taken into account one at a time
+        for(unsigned k=0; k<n; ++k) {
+          Vector dist( x[k], y[k], z[k] ), der( df[k]*x[k], df[k]*y[k], df[k]*z[k] );
+          accumulateSymmetryFunction( -1, ind[k], sw[k], der, Tensor( -der, dist ), myatoms );
+          for(unsigned m=0; m<=tmom; ++m) {
+            unsigned j=m*nb+k; Vector myrealvec( rex[j], rey[j], rez[j] );
+            accumulateSymmetryFunction( 2+tmom+m, ind[k], re[j], myrealvec, Tensor( -myrealvec, dist ), myatoms );
+            if( m==0 ) continue;
+            Vector myimagvec( imx[j], imy[j], imz[j] );
+            accumulateSymmetryFunction( 2+ncomp+tmom+m, ind[k], im[j], myimagvec, Tensor( -myimagvec, dist ), myatoms );
+            // -m part of vector is just +m part multiplied by (-1.0)**m and multiplied by complex
+            // conjugate of Legendre polynomial
+            double pref=( m%2==0 ? 1.0 : -1.0 );
+            accumulateSymmetryFunction( 2+tmom-m, ind[k], pref*re[j], pref*myrealvec, pref*Tensor( -myrealvec, dist ), myatoms );
+            accumulateSymmetryFunction( 2+ncomp+tmom-m, ind[k], -pref*im[j], -pref*myimagvec, pref*Tensor( myimagvec, dist ), myatoms );
+          }
+        }
+      } else {
+        // Switching function for the denominator.  The derivative is dfunc times the bond vector
+        // (the space used for the powers and squared distances is reused to store it)
+        for(unsigned k=0; k<n; ++k) { pwr[k]=df[k]*x[k]; pwi[k]=df[k]*y[k]; d2[k]=df[k]*z[k]; }
+        accumulateBlock( -1, 1.0, n, ind, sw, pwr, pwi, d2, x, y, z, myatoms );
+        for(unsigned m=0; m<=tmom; ++m) {
+          const unsigned j=m*nb;
+          accumulateBlock( 2+tmom+m, 1.0, n, ind, re+j, rex+j, rey+j, rez+j, x, y, z, myatoms );
+          if( m==0 ) continue;
+          accumulateBlock( 2+ncomp+tmom+m, 1.0, n, ind, im+j, imx+j, imy+j, imz+j, x, y, z, myatoms );
+          double pref=( m%2==0 ? 1.0 : -1.0 );
+          accumulateBlock( 2+tmom-m, pref, n, ind, re+j, rex+j, rey+j, rez+j, x, y, z, myatoms );
+          accumulateBlock( 2+ncomp+tmom-m, -pref, n, ind, im+j, imx+j, imy+j, imz+j, x, y, z, myatoms );
+        }
       }
+      n=0;
     }
   }
 
@@ -154,21 +177,101 @@ void Steinhardt::calculateVector( multicolvar::AtomValuePack& myatoms ) const {
   for(unsigned i=0; i<getNumberOfComponentsInVector(); ++i) myatoms.getUnderlyingMultiValue().quotientRule( 2+i, 2+i );
 }
 
-double Steinhardt::deriv_poly( const unsigned& m, const double& val, double& df ) const {
-  double fact=1.0;
-  for(unsigned j=1; j<=m; ++j) fact=fact*j;
-  double res=coeff_poly[m]*fact;
-
-  double pow=1.0, xi=val, dxi=1.0; df=0.0;
-  for(int i=m+1; i<=tmom; ++i) {
-    double fact=1.0;
-    for(unsigned j=i-m+1; j<=i; ++j) fact=fact*j;
-    res=res+coeff_poly[i]*fact*xi;
-    df = df + pow*coeff_poly[i]*fact*dxi;
-    xi=xi*val; dxi=dxi*val; pow+=1.0;
+void Steinhardt::computeHarmonics( const unsigned& n, const double* x, const double* y, const double* z, const double* d2,
+                                   const double* sw, const double* df, double* pwr, double* pwi, double* re, double* im,
+                                   double* rex, double* rey, double* rez, double* imx, double* imy, double* imz ) const {
+  const unsigned nb=steinhardtBlockSize, ntab=tmom+1;
+  for(unsigned m=0; m<=tmom; ++m) {
+    const double* c=&poly_table[m*ntab];
+    const double md=static_cast<double>(m);
+    double* mre=re+m*nb; double* mim=im+m*nb;
+    double* mrex=rex+m*nb; double* mrey=rey+m*nb; double* mrez=rez+m*nb;
+    double* mimx=imx+m*nb; double* mimy=imy+m*nb; double* mimz=imz+m*nb;
+    #pragma omp simd
+    for(unsigned k=0; k<n; ++k) {
+      const double s=1.0/sqrt(d2[k]);
+      const double ux=x[k]*s, uy=y[k]*s, uz=z[k]*s;
+      // Polynomial in z/r and its derivative by Horner's rule
+      double poly=c[tmom-m], dpoly=0.0;
+      for(int l=tmom-m-1; l>=0; --l) { dpoly=dpoly*uz+poly; poly=poly*uz+c[l]; }
+      // Derivatives of z/r wrt x, y, z
+      const double dzx=-uz*ux*s, dzy=-uz*uy*s, dzz=s-uz*uz*s;
+      if( m==0 ) {
+        mre[k]=sw[k]*poly; mim[k]=0.0;
+        mrex[k]=sw[k]*dpoly*dzx + poly*df[k]*x[k];
+        mrey[k]=sw[k]*dpoly*dzy + poly*df[k]*y[k];
+        mrez[k]=sw[k]*dpoly*dzz + poly*df[k]*z[k];
+        mimx[k]=mimy[k]=mimz[k]=0.0;
+        // ((x+iy)/r)^0
+        pwr[k]=1.0; pwi[k]=0.0;
+      } else {
+        // ((x+iy)/r)^m from the power computed for m-1
+        const double zr=ux*pwr[k]-uy*pwi[k], zi=ux*pwi[k]+uy*pwr[k];
+        const double tq=poly*zr, itq=poly*zi;
+        // Derivatives of ((x+iy)/r)^m wrt x, y, z
+        const double a=s*(1.0-ux*ux), b=-s*ux*uy, d=s*(1.0-uy*uy), e=-s*ux*uz, f=-s*uy*uz;
+        const double dpxr=md*(pwr[k]*a-pwi[k]*b), dpxi=md*(pwr[k]*b+pwi[k]*a);
+        const double dpyr=md*(pwr[k]*b-pwi[k]*d), dpyi=md*(pwr[k]*d+pwi[k]*b);
+        const double dpzr=md*(pwr[k]*e-pwi[k]*f), dpzi=md*(pwr[k]*f+pwi[k]*e);
+        mre[k]=sw[k]*tq; mim[k]=sw[k]*itq;
+        mrex[k]=sw[k]*dpoly*zr*dzx + df[k]*x[k]*tq + sw[k]*poly*dpxr;
+        mrey[k]=sw[k]*dpoly*zr*dzy + df[k]*y[k]*tq + sw[k]*poly*dpyr;
+        mrez[k]=sw[k]*dpoly*zr*dzz + df[k]*z[k]*tq + sw[k]*poly*dpzr;
+        mimx[k]=sw[k]*dpoly*zi*dzx + df[k]*x[k]*itq + sw[k]*poly*dpxi;
+        mimy[k]=sw[k]*dpoly*zi*dzy + df[k]*y[k]*itq + sw[k]*poly*dpyi;
+        mimz[k]=sw[k]*dpoly*zi*dzz + df[k]*z[k]*itq + sw[k]*poly*dpzi;
+        pwr[k]=zr; pwi[k]=zi;
+      }
+    }
+  }
+}
+
+void Steinhardt::accumulateBlock( const int& ival, const double& pref, const unsigned& n, const unsigned* ind, const double* val,
+                                  const double* derx, const double* dery, const double* derz,
+                                  const double* x, const double* y, const double* z, multicolvar::AtomValuePack& myatoms ) const {
+  MultiValue& myvals=myatoms.getUnderlyingMultiValue();
+  double sum=0.0;
+  #pragma omp simd reduction(+:sum)
+  for(unsigned k=0; k<n; ++k) sum+=val[k];
+  if( ival<0 ) myvals.addTemporyValue( pref*sum );
+  else myatoms.addValue( ival, pref*sum );
+  if( doNotCalculateDerivatives() ) return ;
+
+  // Virial and derivatives of the central atom are summed over the block before being stored
+  double sx=0.0, sy=0.0, sz=0.0;
+  double vxx=0.0, vxy=0.0, vxz=0.0, vyx=0.0, vyy=0.0, vyz=0.0, vzx=0.0, vzy=0.0, vzz=0.0;
+  #pragma omp simd reduction(+:sx,sy,sz,vxx,vxy,vxz,vyx,vyy,vyz,vzx,vzy,vzz)
+  for(unsigned k=0; k<n; ++k) {
+    sx+=derx[k]; sy+=dery[k]; sz+=derz[k];
+    vxx+=derx[k]*x[k]; vxy+=derx[k]*y[k]; vxz+=derx[k]*z[k];
+    vyx+=dery[k]*x[k]; vyy+=dery[k]*y[k]; vyz+=dery[k]*z[k];
+    vzx+=derz[k]*x[k]; vzy+=derz[k]*y[k]; vzz+=derz[k]*z[k];
+  }
+  Tensor vir( -pref*vxx, -pref*vxy, -pref*vxz, -pref*vyx, -pref*vyy, -pref*vyz, -pref*vzx, -pref*vzy, -pref*vzz );
+  unsigned i0=3*myatoms.getIndex(0);
+  if( ival<0 ) {
+    myatoms.addTemporyBoxDerivatives( vir );
+    myvals.addTemporyDerivative( i0+0, -pref*sx );
+    myvals.addTemporyDerivative( i0+1, -pref*sy );
+    myvals.addTemporyDerivative( i0+2, -pref*sz );
+    for(unsigned k=0; k<n; ++k) {
+      unsigned ik=3*myatoms.getIndex(ind[k]);
+      myvals.addTemporyDerivative( ik+0, pref*derx[k] );
+      myvals.addTemporyDerivative( ik+1, pref*dery[k] );
+      myvals.addTemporyDerivative( ik+2, pref*derz[k] );
+    }
+  } else {
+    myatoms.addBoxDerivatives( ival, vir );
+    myatoms.addDerivative( ival, i0+0, -pref*sx );
+    myatoms.addDerivative( ival, i0+1, -pref*sy );
+    myatoms.addDerivative( ival, i0+2, -pref*sz );
+    for(unsigned k=0; k<n; ++k) {
+      unsigned ik=3*myatoms.getIndex(ind[k]);
+      myatoms.addDerivative( ival, ik+0, pref*derx[k] );
+      myatoms.addDerivative( ival, ik+1, pref*dery[k] );
+      myatoms.addDerivative( ival, ik+2, pref*derz[k] );
+    }
   }
-  df = df*normaliz[m];
-  return normaliz[m]*res;
 }
 
 }
@@ -22,7 +22,6 @@
 #ifndef __PLUMED_crystallization_Steinhardt_h
 #define __PLUMED_crystallization_Steinhardt_h
 
-#include <complex>
 #include "tools/SwitchingFunction.h"
 #include "VectorMultiColvar.h"
 
@@ -34,15 +33,27 @@ private:
   unsigned tmom;
   double rcut,rcut2;
   SwitchingFunction switchingFunction;
+/// Coefficients of the polynomials in z/r for each m (normalization included)
+  std::vector<double> poly_table;
+/// Compute the spherical harmonics and their derivatives for a block of neighbors
+  void computeHarmonics( const unsigned& n, const double* x, const double* y, const double* z, const double* d2,
+                         const double* sw, const double* df, double* pwr, double* pwi, double* re, double* im,
+                         double* rex, double* rey, double* rez, double* imx, double* imy, double* imz ) const ;
+/// Add the contributions from a block of neighbors to one component of the vector
+  void accumulateBlock( const int& ival, const double& pref, const unsigned& n, const unsigned* ind, const double* val,
+                        const double* derx, const double* dery, const double* derz,
+                        const double* x, const double* y, const double* z, multicolvar::AtomValuePack& myatoms ) const ;
 protected:
+/// Legendre polynomial coefficients
   std::vector<double> coeff_poly;
+/// Spherical harmonics normalization
   std::vector<double> normaliz;
+/// Set the angular momentum and build the tables of coefficients for the spherical harmonics
   void setAngularMomentum( const unsigned& ang );
 public:
   static void registerKeywords( Keywords& keys );
   explicit Steinhardt( const ActionOptions& ao );
   void calculateVector( multicolvar::AtomValuePack& myatoms ) const ;
-  double deriv_poly( const unsigned&, const double&, double& ) const ;
 };
 
 }
@@ -20,11 +20,13 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "SMACOF.h"
+#include "tools/OpenMP.h"
+#include "tools/Random.h"
 
 namespace PLMD {
 namespace dimred {
 
-void SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops, Matrix<double>& InitialZ ) {
+unsigned SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops, Matrix<double>& InitialZ ) {
   unsigned M = Distances.nrows();
 
   // Calculate V
@@ -46,27 +48,20 @@ void SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances
   Matrix<double> dists( M, M ); double myfirstsig = calculateSigma( Weights, Distances, InitialZ, dists ) / totalWeight;
 
   // initial sigma is made up of the original distances minus the distances between the projections all squared.
-  Matrix<double> temp( M, M ), BZ( M, M ), newZ( M, InitialZ.ncols() );
-  for(unsigned n=0; n<maxloops; ++n) {
+  unsigned nlow=InitialZ.ncols(), n=0; Matrix<double> BZZ( M, nlow ), newZ( M, nlow );
+  for(n=0; n<maxloops; ++n) {
     if(n==maxloops-1) plumed_merror("ran out of steps in SMACOF algorithm");
 
-    // Recompute BZ matrix
+    // Compute V^+ B(Z) Z.  The product B(Z)Z is computed directly so the M by M matrix B(Z) is never stored
+    calculateBZZ( Weights, Distances, dists, InitialZ, BZZ );
+    #pragma omp parallel for num_threads(OpenMP::getNumThreads())
     for(unsigned i=0; i<M; ++i) {
+      for(unsigned k=0; k<nlow; ++k) newZ(i,k)=0;
       for(unsigned j=0; j<M; ++j) {
-        if(i==j) continue;  //skips over the diagonal elements
-
-        if( dists(i,j)>0 ) BZ(i,j) = -Weights(i,j)*Distances(i,j) / dists(i,j);
-        else BZ(i,j)=0.;
-      }
-      //the diagonal elements are -off diagonal elements BZ(i,i)-=BZ(i,j)   (Equation 8.25)
-      BZ(i,i)=0; //create the space memory for the diagonal elements which are scalars
-      for(unsigned j=0; j<M; ++j) {
-        if(i==j) continue;
-        BZ(i,i)-=BZ(i,j);
+        double vij=mypseudo(i,j);
+        for(unsigned k=0; k<nlow; ++k) newZ(i,k)+=vij*BZZ(j,k);
       }
     }
-
-    mult( mypseudo, BZ, temp); mult(temp, InitialZ, newZ);
     //Compute new sigma
     double newsig = calculateSigma( Weights, Distances, newZ, dists ) / totalWeight;
     //Computing whether the algorithm has converged (has the mass of the potato changed
@@ -75,10 +70,81 @@ void SMACOF::run( const Matrix<double>& Weights, const Matrix<double>& Distances
     myfirstsig=newsig;
     InitialZ = newZ;
   }
+  return n+1;
+}
+
+void SMACOF::calculateBZZ( const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& dists, const Matrix<double>& Z, Matrix<double>& BZZ ) {
+  unsigned M=Distances.nrows(), nlow=Z.ncols();
+  // The diagonal elements of B(Z) are minus the sum of the off diagonal elements (Equation 8.25) so
+  // the ith row of B(Z)Z is sum_j B(Z)_ij ( Z_j - Z_i )
+  #pragma omp parallel for num_threads(OpenMP::getNumThreads())
+  for(unsigned i=0; i<M; ++i) {
+    for(unsigned k=0; k<nlow; ++k) BZZ(i,k)=0;
+    for(unsigned j=0; j<M; ++j) {
+      if( i==j || !(dists(i,j)>0) ) continue;
+      double bij = -Weights(i,j)*Distances(i,j) / dists(i,j);
+      for(unsigned k=0; k<nlow; ++k) BZZ(i,k)+=bij*( Z(j,k) - Z(i,k) );
+    }
+  }
+}
+
+unsigned SMACOF::runStochastic( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops,
+                                const unsigned& batchsize, Random& random, Matrix<double>& InitialZ ) {
+  unsigned M = Distances.nrows(), nlow=InitialZ.ncols(); plumed_assert( batchsize>0 );
+  double totalWeight=0.;
+  for(unsigned i=1; i<M; ++i) for(unsigned j=0; j<i; ++j) totalWeight+=Weights(i,j);
+
+  Matrix<double> dists( M, M ); double myfirstsig = calculateSigma( Weights, Distances, InitialZ, dists ) / totalWeight;
+  // Each pass through the points (epoch) moves every point once in a random order.  The points are moved in batches
+  // and the new positions of all the points in a batch are computed in parallel from the old positions.
+  std::vector<unsigned> order( M ); for(unsigned i=0; i<M; ++i) order[i]=i;
+  Matrix<double> newZ( M, nlow ); unsigned n=0;
+  for(n=0; n<maxloops; ++n) {
+    if(n==maxloops-1) plumed_merror("ran out of steps in stochastic SMACOF algorithm");
+
+    random.Shuffle( order );
+    for(unsigned b=0; b<M; b+=batchsize) {
+      unsigned bend=std::min( M, b + batchsize );
+      #pragma omp parallel num_threads(OpenMP::getNumThreads())
+      {
+        std::vector<double> newz( nlow );
+        #pragma omp for
+        for(unsigned ib=b; ib<bend; ++ib) {
+          updatePoint( order[ib], Weights, Distances, InitialZ, newz );
+          for(unsigned k=0; k<nlow; ++k) newZ(order[ib],k)=newz[k];
+        }
+      }
+      for(unsigned ib=b; ib<bend; ++ib) {
+        for(unsigned k=0; k<nlow; ++k) InitialZ(order[ib],k)=newZ(order[ib],k);
+      }
+    }
+    // Test for convergence once every point has been moved
+    double newsig = calculateSigma( Weights, Distances, InitialZ, dists ) / totalWeight;
+    if( fabs( newsig - myfirstsig )<tol ) break;
+    myfirstsig=newsig;
+  }
+  return n+1;
+}
+
+void SMACOF::updatePoint( const unsigned& i, const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& Z, std::vector<double>& newz ) {
+  // The majorizing function for the stress of point i (with all the other points fixed) has its minimum at
+  // sum_j w_ij ( z_j + delta_ij ( z_i - z_j ) / d_ij ) / sum_j w_ij
+  unsigned M=Distances.nrows(), nlow=Z.ncols(); double wtot=0;
+  for(unsigned k=0; k<nlow; ++k) newz[k]=0;
+  for(unsigned j=0; j<M; ++j) {
+    if( i==j ) continue;
+    double dij=0; for(unsigned k=0; k<nlow; ++k) { double tmp=Z(i,k) - Z(j,k); dij+=tmp*tmp; }
+    dij=sqrt(dij); double wij=Weights(i,j); wtot+=wij;
+    double pref = ( dij>0 ? Distances(i,j) / dij : 0 );
+    for(unsigned k=0; k<nlow; ++k) newz[k]+=wij*( Z(j,k) + pref*( Z(i,k) - Z(j,k) ) );
+  }
+  if( wtot>0 ) { for(unsigned k=0; k<nlow; ++k) newz[k]/=wtot; }
+  else { for(unsigned k=0; k<nlow; ++k) newz[k]=Z(i,k); }
 }
 
 double SMACOF::calculateSigma( const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& InitialZ, Matrix<double>& dists ) {
   unsigned M = Distances.nrows(); double sigma=0;
+  #pragma omp parallel for reduction(+:sigma) schedule(dynamic,16) num_threads(OpenMP::getNumThreads())
   for(unsigned i=1; i<M; ++i) {
     for(unsigned j=0; j<i; ++j) {
       double dlow=0; for(unsigned k=0; k<InitialZ.ncols(); ++k) { double tmp=InitialZ(i,k) - InitialZ(j,k); dlow+=tmp*tmp; }
@@ -26,12 +26,36 @@
 #include "tools/Matrix.h"
 
 namespace PLMD {
+
+class Random;
+
 namespace dimred {
 
+/**
+Minimise a weighted stress function using the SMACOF (scaling by majorizing a complicated function) algorithm.
+
+run() performs the full Guttman transform on all the points at each iteration and is parallelized
+over the rows of the matrices using OpenMP.  runStochastic() instead moves a randomly-chosen batch of points
+at each iteration to the minimum of the majorizing function for that point (all the other points are kept fixed).
+Each of these updates costs O(M) so this version can be used when the number of points is so large that
+the pseudo-inverse of the M by M matrix V that is required by the full algorithm cannot be computed.
+The weights passed to runStochastic() must not be negative, as the stress is not bounded from below otherwise.
+This is why the stochastic version is not used for the iteratively reweighted stress of sketch-map.
+In both cases the optimisation stops when the change in stress between two evaluations is less than tol.
+Both functions return the number of iterations that were performed.
+*/
+
 class SMACOF {
+private:
+/// Calculate the product of the matrix B(Z) with Z without storing the full B(Z) matrix
+  static void calculateBZZ( const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& dists, const Matrix<double>& Z, Matrix<double>& BZZ );
+/// Move point i to the minimum of the majorizing function for that point
+  static void updatePoint( const unsigned& i, const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& Z, std::vector<double>& newz );
 public:
   static double calculateSigma( const Matrix<double>& Weights, const Matrix<double>& Distances, const Matrix<double>& InitialZ, Matrix<double>& dists );
-  static void run( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops, Matrix<double>& InitialZ);
+  static unsigned run( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops, Matrix<double>& InitialZ);
+  static unsigned runStochastic( const Matrix<double>& Weights, const Matrix<double>& Distances, const double& tol, const unsigned& maxloops,
+                                 const unsigned& batchsize, Random& random, Matrix<double>& InitialZ );
 };
 
 }
@@ -71,7 +71,8 @@ void SketchMapSmacof::minimise( Matrix<double>& projections ) {
   double filt = recalculateWeights( projections, weights );
 
   for(unsigned i=0; i<maxiter; ++i) {
-    SMACOF::run( weights, distances, smap_tol, max_smap, projections );
+    unsigned niter=SMACOF::run( weights, distances, smap_tol, max_smap, projections );
+    log.printf("  smacof cycle %u converged after %u iterations \n",i+1,niter);
     // Recalculate weights matrix and sigma
     double newsig = recalculateWeights( projections, weights );
     // Test whether or not the algorithm has converged
@@ -21,12 +21,18 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "DimensionalityReductionBase.h"
 #include "core/ActionRegister.h"
+#include "tools/Random.h"
 #include "SMACOF.h"
 
 //+PLUMEDOC DIMRED SMACOF_MDS
 /*
 Optimize the multidimensional scaling stress function using the SMACOF algorithm.
 
+By default all the projections are updated at every step of the optimisation.
+If the SMACOF_BATCH keyword is used the stochastic version of the algorithm is used instead.
+In this version batches of randomly-chosen points are moved to the minima of their majorizing functions,
+which avoids the pseudo-inverse of the full matrix of weights that is required by the full algorithm.
+
 \par Examples
 
 */
@@ -39,6 +45,8 @@ class SmacofMDS : public DimensionalityReductionBase {
 private:
   unsigned maxloops;
   double tol;
+  unsigned batchsize;
+  Random random;
 public:
   static void registerKeywords( Keywords& keys );
   SmacofMDS( const ActionOptions& );
@@ -52,16 +60,24 @@ void SmacofMDS::registerKeywords( Keywords& keys ) {
   keys.remove("NLOW_DIM");
   keys.add("compulsory","SMACOF_TOL","1E-4","tolerance for the SMACOF optimization algorithm");
   keys.add("compulsory","SMACOF_MAXCYC","1000","maximum number of optimization cycles for SMACOF algorithm");
+  keys.add("optional","SMACOF_BATCH","use the stochastic SMACOF algorithm and move this many points in each batch");
+  keys.add("compulsory","SMACOF_SEED","1234","the random number seed for the stochastic SMACOF algorithm");
 }
 
 SmacofMDS::SmacofMDS( const ActionOptions& ao):
   Action(ao),
-  DimensionalityReductionBase(ao)
+  DimensionalityReductionBase(ao),
+  batchsize(0)
 {
   if( !dimredbase ) error("SMACOF must be initialized using output from dimensionality reduction object");
 
   parse("SMACOF_TOL",tol); parse("SMACOF_MAXCYC",maxloops);
   log.printf("  running smacof to convergence at %f or for a maximum of %u steps \n",tol,maxloops);
+  parse("SMACOF_BATCH",batchsize);
+  int seed; parse("SMACOF_SEED",seed); random.setSeed(-seed);
+  if( batchsize>0 ) {
+    log.printf("  using stochastic smacof with batches of %u points \n",batchsize);
+  }
 }
 
 void SmacofMDS::calculateProjections( const Matrix<double>& targets, Matrix<double>& projections ) {
@@ -75,7 +91,10 @@ void SmacofMDS::calculateProjections( const Matrix<double>& targets, Matrix<doub
     }
   }
   // And run SMACOF
-  SMACOF::run( weights, targets, tol, maxloops, projections );
+  unsigned niter;
+  if( batchsize>0 ) niter=SMACOF::runStochastic( weights, targets, tol, maxloops, batchsize, random, projections );
+  else niter=SMACOF::run( weights, targets, tol, maxloops, projections );
+  log.printf("  smacof converged after %u iterations \n",niter);
 }
 
 }
@@ -17,6 +17,7 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #ifdef __PLUMED_HAS_BOOST_SERIALIZATION
 #include "DRR.h"
+#include "tools/OpenMP.h"
 
 namespace PLMD {
 namespace drr {
@@ -75,40 +76,34 @@ size_t DRRForceGrid::index1D(const DRRAxis &c, double x) {
   return idx;
 }
 
-void DRRForceGrid::fillTable(const vector<vector<double>> &in) {
-  table.resize(ndims, vector<double>(sampleSize, 0));
-  for (size_t i = 0; i < ndims; ++i) {
-    size_t repeatAll = 1, repeatOne = 1;
-    for (size_t j = i + 1; j < ndims; ++j)
-      repeatOne *= in[j].size();
-    for (size_t j = 0; j < i; ++j)
-      repeatAll *= in[j].size();
-    size_t in_i_sz = in[i].size();
-    for (size_t l = 0; l < in_i_sz; ++l)
-      std::fill_n(begin(table[i]) + l * repeatOne, repeatOne, in[i][l]);
-    for (size_t k = 0; k < repeatAll - 1; ++k)
-      std::copy_n(begin(table[i]), repeatOne * in_i_sz,
-                  begin(table[i]) + repeatOne * in_i_sz * (k + 1));
+size_t DRRForceGrid::rowAddress(size_t row, double *pos) const {
+  size_t addr = 0;
+  for (size_t j = ndims; j-- > 0;) {
+    const size_t idx = row % dimensions[j].nbins;
+    row /= dimensions[j].nbins;
+    pos[j] = middlePoints[j][idx];
+    addr += shifts[j] * idx;
   }
+  return addr;
 }
 
 DRRForceGrid::DRRForceGrid()
   : suffix(""), ndims(0), dimensions(0), sampleSize(0),
-    headers(""), table(0), forces(0), samples(0), endpoints(0), shifts(0),
+    headers(""), middlePoints(0), forces(0), samples(0), endpoints(0), shifts(0),
     outputunit(1.0) {}
 
 DRRForceGrid::DRRForceGrid(const vector<DRRAxis> &p_dimensions,
-                           const string &p_suffix, bool initializeTable)
+                           const string &p_suffix)
   : suffix(p_suffix), ndims(p_dimensions.size()), dimensions(p_dimensions) {
   sampleSize = 1;
-  vector<vector<double>> mp(ndims);
+  middlePoints.resize(ndims);
   std::stringstream ss;
   ss << "# " << ndims << '\n';
   shifts.resize(ndims, 0);
   shifts[0] = 1;
   for (size_t i = 0; i < ndims; ++i) {
     sampleSize = dimensions[i].nbins * sampleSize;
-    mp[i] = dimensions[i].getMiddlePoints();
+    middlePoints[i] = dimensions[i].getMiddlePoints();
     if (i > 0) {
       shifts[i] = shifts[i - 1] * dimensions[i - 1].nbins;
     }
@@ -121,8 +116,6 @@ DRRForceGrid::DRRForceGrid(const vector<DRRAxis> &p_dimensions,
       ss << " 0" << '\n';
   }
   headers = ss.str();
-  if (initializeTable)
-    fillTable(mp);
   forces.resize(sampleSize * ndims, 0.0);
   samples.resize(sampleSize, 0);
   outputunit = 1.0;
@@ -180,12 +173,20 @@ vector<DRRAxis> DRRForceGrid::merge(const vector<DRRAxis> &dA,
 vector<double>
 DRRForceGrid::getAccumulatedForces(const vector<double> &pos) const {
   vector<double> result(ndims, 0);
-  if (!isInBoundary(pos))
-    return result;
+  getAccumulatedForces(pos, result);
+  return result;
+}
+
+void DRRForceGrid::getAccumulatedForces(const vector<double> &pos,
+                                        vector<double> &result) const {
+  result.resize(ndims);
+  if (!isInBoundary(pos)) {
+    std::fill(begin(result), end(result), 0.0);
+    return;
+  }
   const size_t baseaddr = sampleAddress(pos) * ndims;
   std::copy(begin(forces) + baseaddr, begin(forces) + baseaddr + ndims,
             begin(result));
-  return result;
 }
 
 unsigned long int DRRForceGrid::getCount(const vector<double> &pos,
@@ -201,19 +202,31 @@ unsigned long int DRRForceGrid::getCount(const vector<double> &pos,
 vector<double> DRRForceGrid::getGradient(const vector<double> &pos,
     bool SkipCheck) const {
   vector<double> result(ndims, 0);
+  getGradient(pos, result, SkipCheck);
+  return result;
+}
+
+void DRRForceGrid::getGradient(const vector<double> &pos,
+                               vector<double> &result, bool SkipCheck) const {
+  result.resize(ndims);
   if (!SkipCheck) {
     if (!isInBoundary(pos)) {
-      return result;
+      std::fill(begin(result), end(result), 0.0);
+      return;
     }
   }
-  const size_t baseaddr = sampleAddress(pos);
-  const unsigned long int &count = samples[baseaddr];
-  if (count == 0)
-    return result;
-  auto it_fa = begin(forces) + baseaddr * ndims;
-  std::transform(it_fa, it_fa + ndims, begin(result),
+  gradientAt(sampleAddress(pos), result.data());
+}
+
+void DRRForceGrid::gradientAt(size_t addr, double *result) const {
+  const unsigned long int &count = samples[addr];
+  if (count == 0) {
+    std::fill_n(result, ndims, 0.0);
+    return;
+  }
+  auto it_fa = begin(forces) + addr * ndims;
+  std::transform(it_fa, it_fa + ndims, result,
   [&count](double fa) { return (-1.0) * fa / count; });
-  return result;
 }
 
 double DRRForceGrid::getDivergence(const vector<double> &pos) const {
@@ -284,13 +297,24 @@ double DRRForceGrid::getDivergence(const vector<double> &pos) const {
 
 vector<double>
 DRRForceGrid::getCountsLogDerivative(const vector<double> &pos) const {
-  const size_t addr = sampleAddress(pos);
-  const unsigned long int count_this = samples[addr];
   vector<double> result(ndims, 0);
+  getCountsLogDerivative(pos, result);
+  return result;
+}
+
+void DRRForceGrid::getCountsLogDerivative(const vector<double> &pos,
+    vector<double> &result) const {
+  result.resize(ndims);
+  countsLogDerivativeAt(sampleAddress(pos), result.data());
+}
+
+void DRRForceGrid::countsLogDerivativeAt(size_t addr, double *result) const {
+  const unsigned long int count_this = samples[addr];
+  std::fill_n(result, ndims, 0.0);
   for (size_t i = 0; i < ndims; ++i) {
     const double binWidth = dimensions[i].binWidth;
     const size_t addr_first =
-      addr - shifts[i] * index1D(dimensions[i], pos[i]) + 0;
+      addr - shifts[i] * ((addr / shifts[i]) % dimensions[i].nbins);
     const size_t addr_last = addr_first + shifts[i] * (dimensions[i].nbins - 1);
     if (addr == addr_first) {
       if (dimensions[i].isRealPeriodic() == true) {
@@ -331,7 +355,6 @@ DRRForceGrid::getCountsLogDerivative(const vector<double> &pos) const {
           (std::log(count_next) - std::log(count_prev)) / (2 * binWidth);
     }
   }
-  return result;
 }
 
 void DRRForceGrid::write1DPMF(string filename) const {
@@ -341,11 +364,10 @@ void DRRForceGrid::write1DPMF(string filename) const {
   const double w = dimensions[0].binWidth;
   double pmf = 0;
   fprintf(ppmf, "%.9f %.9f\n", endpoints[0], pmf);
+  double pos, f;
   for (size_t i = 0; i < dimensions[0].nbins; ++i) {
-    vector<double> pos(1, 0);
-    pos[0] = table[0][i];
-    const vector<double> f = getGradient(pos, true);
-    pmf += f[0] * w / outputunit;
+    gradientAt(rowAddress(i, &pos), &f);
+    pmf += f * w / outputunit;
     fprintf(ppmf, "%.9f %.9f\n", endpoints[i + 1], pmf);
   }
   fclose(ppmf);
@@ -354,34 +376,58 @@ void DRRForceGrid::write1DPMF(string filename) const {
 void DRRForceGrid::writeAll(const string &filename) const {
   string countname = filename + suffix + ".count";
   string gradname = filename + suffix + ".grad";
-  vector<double> pos(ndims, 0);
   FILE *pGrad, *pCount;
   pGrad = fopen(gradname.c_str(), "w");
   pCount = fopen(countname.c_str(), "w");
-  char *buffer1, *buffer2;
-  buffer1 = (char *)malloc((sizeof(double)) * sampleSize * ndims);
-  buffer2 = (char *)malloc((sizeof(double)) * sampleSize * ndims);
-  setvbuf(pGrad, buffer1, _IOFBF, (sizeof(double)) * sampleSize * ndims);
-  setvbuf(pCount, buffer2, _IOFBF, (sizeof(double)) * sampleSize * ndims);
   fwrite(headers.c_str(), sizeof(char), strlen(headers.c_str()), pGrad);
   fwrite(headers.c_str(), sizeof(char), strlen(headers.c_str()), pCount);
-  for (size_t i = 0; i < sampleSize; ++i) {
-    for (size_t j = 0; j < ndims; ++j) {
-      pos[j] = table[j][i];
-      fprintf(pGrad, " %.9f", table[j][i]);
-      fprintf(pCount, " %.9f", table[j][i]);
+  // Lines are formatted in blocks by different threads, then the blocks are
+  // written in order
+  const size_t blockSize = 4096;
+  const size_t nblocks = (sampleSize + blockSize - 1) / blockSize;
+  unsigned nt = OpenMP::getNumThreads();
+  if (nt > nblocks)
+    nt = nblocks > 0 ? nblocks : 1;
+  vector<string> gradBlocks(nt), countBlocks(nt);
+  for (size_t b0 = 0; b0 < nblocks; b0 += nt) {
+    const size_t nb = std::min(size_t(nt), nblocks - b0);
+    #pragma omp parallel num_threads(nt)
+    {
+      vector<double> pos(ndims, 0), grad(ndims, 0);
+      char buffer[512];
+      #pragma omp for
+      for (size_t k = 0; k < nb; ++k) {
+        string &g = gradBlocks[k];
+        string &c = countBlocks[k];
+        g.clear();
+        c.clear();
+        const size_t first = (b0 + k) * blockSize;
+        const size_t last = std::min(first + blockSize, sampleSize);
+        for (size_t i = first; i < last; ++i) {
+          const size_t addr = rowAddress(i, pos.data());
+          for (size_t j = 0; j < ndims; ++j) {
+            snprintf(buffer, sizeof(buffer), " %.9f", pos[j]);
+            g += buffer;
+            c += buffer;
+          }
+          snprintf(buffer, sizeof(buffer), " %lu\n", samples[addr]);
+          c += buffer;
+          gradientAt(addr, grad.data());
+          for (size_t j = 0; j < ndims; ++j) {
+            snprintf(buffer, sizeof(buffer), " %.9f", (grad[j] / outputunit));
+            g += buffer;
+          }
+          g += '\n';
+        }
+      }
     }
-    fprintf(pCount, " %lu\n", getCount(pos, true));
-    vector<double> f = getGradient(pos, true);
-    for (size_t j = 0; j < ndims; ++j) {
-      fprintf(pGrad, " %.9f", (f[j] / outputunit));
+    for (size_t k = 0; k < nb; ++k) {
+      fwrite(gradBlocks[k].c_str(), sizeof(char), gradBlocks[k].size(), pGrad);
+      fwrite(countBlocks[k].c_str(), sizeof(char), countBlocks[k].size(), pCount);
     }
-    fprintf(pGrad, "\n");
   }
   fclose(pGrad);
   fclose(pCount);
-  free(buffer1);
-  free(buffer2);
   if (ndims == 1) {
     write1DPMF(filename);
   }
@@ -394,9 +440,9 @@ void DRRForceGrid::writeDivergence(const string &filename) const {
   pDiv = fopen(divname.c_str(), "w");
   fwrite(headers.c_str(), sizeof(char), strlen(headers.c_str()), pDiv);
   for (size_t i = 0; i < sampleSize; ++i) {
+    rowAddress(i, pos.data());
     for (size_t j = 0; j < ndims; ++j) {
-      pos[j] = table[j][i];
-      fprintf(pDiv, " %.9f", table[j][i]);
+      fprintf(pDiv, " %.9f", pos[j]);
     }
     const double divergence = getDivergence(pos);
     fprintf(pDiv, " %.9f", (divergence / outputunit));
@@ -438,45 +484,37 @@ ABF ABF::mergewindow(const ABF &aWA, const ABF &aWB) {
   ABF result(dR, suffix);
   const size_t nrows = result.sampleSize;
   const size_t ncols = result.ndims;
-  vector<double> pos(ncols, 0);
+  vector<double> pos(ncols, 0), aForceA(ncols, 0), aForceB(ncols, 0);
   for (size_t i = 0; i < nrows; ++i) {
-    for (size_t j = 0; j < ncols; ++j) {
-      pos[j] = result.table[j][i];
-    }
+    result.rowAddress(i, pos.data());
     const unsigned long int countA = aWA.getCount(pos);
     const unsigned long int countB = aWB.getCount(pos);
-    const vector<double> aForceA = aWA.getAccumulatedForces(pos);
-    const vector<double> aForceB = aWB.getAccumulatedForces(pos);
+    aWA.getAccumulatedForces(pos, aForceA);
+    aWB.getAccumulatedForces(pos, aForceB);
     result.store(pos, aForceA, countA);
     result.store(pos, aForceB, countB);
   }
   return result;
 }
 
-vector<double> CZAR::getGradient(const vector<double> &pos,
-                                 bool SkipCheck) const {
-  vector<double> result(ndims, 0);
-  if (!SkipCheck) {
-    if (!isInBoundary(pos)) {
-      return result;
-    }
-  }
+void CZAR::gradientAt(size_t addr, double *result) const {
   if (kbt <= std::numeric_limits<double>::epsilon()) {
     std::cerr << "ERROR! The kbt shouldn't be zero when use CZAR estimator. "
               << '\n';
     std::abort();
   }
-  const size_t baseaddr = sampleAddress(pos);
-  const vector<double> log_deriv(getCountsLogDerivative(pos));
-  const unsigned long int &count = samples[baseaddr];
-  if (count == 0)
-    return result;
-  auto it_fa = begin(forces) + baseaddr * ndims;
-  std::transform(it_fa, it_fa + ndims, begin(log_deriv), begin(result),
+  const unsigned long int &count = samples[addr];
+  if (count == 0) {
+    std::fill_n(result, ndims, 0.0);
+    return;
+  }
+  // result first holds dln(ρ)/dz
+  countsLogDerivativeAt(addr, result);
+  auto it_fa = begin(forces) + addr * ndims;
+  std::transform(it_fa, it_fa + ndims, result, result,
   [&count, this](double fa, double ld) {
     return fa * (-1.0) / count - kbt * ld;
   });
-  return result;
 }
 
 CZAR CZAR::mergewindow(const CZAR &cWA, const CZAR &cWB) {
@@ -486,15 +524,13 @@ CZAR CZAR::mergewindow(const CZAR &cWA, const CZAR &cWB) {
   CZAR result(dR, suffix, newkbt);
   const size_t nrows = result.sampleSize;
   const size_t ncols = result.ndims;
-  vector<double> pos(ncols, 0);
+  vector<double> pos(ncols, 0), aForceA(ncols, 0), aForceB(ncols, 0);
   for (size_t i = 0; i < nrows; ++i) {
-    for (size_t j = 0; j < ncols; ++j) {
-      pos[j] = result.table[j][i];
-    }
+    result.rowAddress(i, pos.data());
     const unsigned long int countA = cWA.getCount(pos);
     const unsigned long int countB = cWB.getCount(pos);
-    const vector<double> aForceA = cWA.getAccumulatedForces(pos);
-    const vector<double> aForceB = cWB.getAccumulatedForces(pos);
+    cWA.getAccumulatedForces(pos, aForceA);
+    cWB.getAccumulatedForces(pos, aForceB);
     result.store(pos, aForceA, countA);
     result.store(pos, aForceB, countB);
   }
@@ -151,13 +151,10 @@ public:
   /// Empty constructor
   DRRForceGrid();
   /// "Real" constructor
-  /// The 2D table vector is mainly used for print grid points in grad and count
-  /// file.
-  /// So when use binary output we can set initializeTable to false to save
-  /// memory.
+  /// The grid points printed in grad and count files are obtained from the
+  /// middle points of each axis, which only need O(sum of bins) memory.
   explicit DRRForceGrid(const vector<DRRAxis> &p_dimensions,
-                        const string &p_suffix,
-                        bool initializeTable = true);
+                        const string &p_suffix);
   /// Check whether a point is in this grid
   bool isInBoundary(const vector<double> &pos) const;
   //  /// Get internal indices of a point
@@ -171,19 +168,31 @@ public:
   /// Get accumulated forces of a point
   vector<double>
   getAccumulatedForces(const vector<double> &pos) const;
+  /// Get accumulated forces of a point into result (no allocation if result
+  /// has already the right size)
+  void getAccumulatedForces(const vector<double> &pos,
+                            vector<double> &result) const;
   /// Get counts of a point
   unsigned long int getCount(const vector<double> &pos,
                              bool SkipCheck = false) const;
-  /// Virtual function! get gradients of a point
-  /// CZAR and naive(ABF) have different gradient formulae
-  virtual vector<double> getGradient(const vector<double> &pos,
-                                     bool SkipCheck = false) const;
+  /// Get gradients of a point
+  /// CZAR and naive(ABF) have different gradient formulae, see gradientAt()
+  vector<double> getGradient(const vector<double> &pos,
+                             bool SkipCheck = false) const;
+  /// Get gradients of a point into result (no allocation if result has
+  /// already the right size)
+  void getGradient(const vector<double> &pos, vector<double> &result,
+                   bool SkipCheck = false) const;
   /// Calculate divergence of the mean force field (experimental)
   double getDivergence(const vector<double> &pos) const;
   /// Calculate dln(ρ)/dz, useful for CZAR
   /// This function may be moved to CZAR class in the future
   vector<double>
   getCountsLogDerivative(const vector<double> &pos) const;
+  /// Calculate dln(ρ)/dz into result (no allocation if result has already the
+  /// right size)
+  void getCountsLogDerivative(const vector<double> &pos,
+                              vector<double> &result) const;
   /// Write grad file
 //   void writeGrad(string filename) const;
   /// Write 1D pmf file on one dimensional occasion
@@ -191,6 +200,7 @@ public:
   /// Write count file
 //   void writeCount(string filename) const;
   /// Write necessary output file in one function (.grad and .count)
+  /// Lines are formatted in parallel and written in order
   void writeAll(const string &filename) const;
   /// Output divergence (.div) (experimental)
   void writeDivergence(const string &filename) const;
@@ -216,12 +226,13 @@ protected:
   size_t sampleSize;
   /// The header lines of .grad and .count files
   string headers;
-  /// A table stores the middle points of all dimensions.
+  /// The middle points of the bins of each dimension.
   /// For output in .grad and .count files
-  vector<vector<double>> table;
-  /// Store the average force of each bins
+  vector<vector<double>> middlePoints;
+  /// Store the accumulated forces of each bins, contiguous for each bin
+  /// (ndims values at sampleAddress * ndims)
   vector<double> forces;
-  /// Store counts of each bins
+  /// Store counts of each bins (at sampleAddress)
   vector<unsigned long int> samples;
   /// Only for 1D pmf output
   vector<double> endpoints;
@@ -233,7 +244,14 @@ protected:
 
   /// Miscellaneous helper functions
   static size_t index1D(const DRRAxis &c, double x);
-  void fillTable(const vector<vector<double>> &in);
+  /// Get the grid point of the row-th line of the output files and return
+  /// its address. Lines are ordered with the last dimension running fastest.
+  size_t rowAddress(size_t row, double *pos) const;
+  /// Calculate dln(ρ)/dz of the bin at address addr (ndims values)
+  void countsLogDerivativeAt(size_t addr, double *result) const;
+  /// Virtual function! get gradients of the bin at address addr (ndims values)
+  /// CZAR and naive(ABF) have different gradient formulae
+  virtual void gradientAt(size_t addr, double *result) const;
 
   /// Boost serialization functions
   friend class boost::serialization::access;
@@ -255,11 +273,11 @@ protected:
     sampleSize = samples.size();
     std::stringstream ss;
     ss << "# " << ndims << '\n';
-    vector<vector<double>> mp(ndims);
+    middlePoints.resize(ndims);
     shifts.resize(ndims, 0);
     shifts[0] = 1;
     for (size_t i = 0; i < ndims; ++i) {
-      mp[i] = dimensions[i].getMiddlePoints();
+      middlePoints[i] = dimensions[i].getMiddlePoints();
       if (i > 0) {
         shifts[i] = shifts[i - 1] * dimensions[i - 1].nbins;
       }
@@ -271,7 +289,6 @@ protected:
       else
         ss << " 0" << '\n';
     }
-    fillTable(mp);
     headers = ss.str();
     outputunit = 1.0;
     // For 1D pmf
@@ -295,9 +312,8 @@ class ABF : public DRRForceGrid {
 public:
   ABF() {}
   ABF(const vector<DRRAxis> &p_dimensions, const string &p_suffix,
-      double fullSamples = 500.0, double maxFactor = 1.0,
-      bool initializeTable = true)
-    : DRRForceGrid(p_dimensions, p_suffix, initializeTable),
+      double fullSamples = 500.0, double maxFactor = 1.0)
+    : DRRForceGrid(p_dimensions, p_suffix),
       mFullSamples(fullSamples), mMaxFactor(maxFactor) {}
   // Provide a setter for ABF parametres (fullsamples, maxfactor)
   void setParameters(double fullSamples, double maxFactor) {
@@ -327,15 +343,16 @@ class CZAR : public DRRForceGrid {
 public:
   CZAR() : kbt(0) {}
   CZAR(const vector<DRRAxis> &p_dimensions, const string &p_suffix,
-       double p_kbt, bool initializeTable = true)
-    : DRRForceGrid(p_dimensions, p_suffix, initializeTable), kbt(p_kbt) {}
-  vector<double> getGradient(const vector<double> &pos,
-                             bool SkipCheck = false) const;
+       double p_kbt)
+    : DRRForceGrid(p_dimensions, p_suffix), kbt(p_kbt) {}
   double getkbt() const { return kbt; }
   void setkbt(double p_kbt) { kbt = p_kbt; }
   static CZAR mergewindow(const CZAR &cWA, const CZAR &cWB);
   ~CZAR() {}
 
+protected:
+  void gradientAt(size_t addr, double *result) const;
+
 private:
   double kbt;
   friend class boost::serialization::access;
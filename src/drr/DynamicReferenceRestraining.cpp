@@ -20,6 +20,7 @@
 #include "bias/Bias.h"
 #include "core/Atoms.h"
 #include "core/PlumedMain.h"
+#include "core/Checkpoint.h"
 #include "DRR.h"
 #include "tools/Random.h"
 #include "tools/Tools.h"
@@ -33,6 +34,7 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <random>
 #include <string>
 
@@ -630,11 +632,9 @@ DynamicReferenceRestraining::DynamicReferenceRestraining(
   cptname = outputprefix + ".cpt.drrstate";
 
   if (!isRestart) {
-    // If you want to use on-the-fly text output for CZAR and naive estimator,
-    // you should turn it to true first!
-    ABFGrid = ABF(delim, ".abf", fullsamples, maxFactor, textoutput);
+    ABFGrid = ABF(delim, ".abf", fullsamples, maxFactor);
     // Just initialize it even useCZARestimator is off.
-    CZARestimator = CZAR(zdelim, ".czar", kbt, textoutput);
+    CZARestimator = CZAR(zdelim, ".czar", kbt);
     log << "eABF/DRR: The init function of the grid is finished." << '\n';
   } else {
     // ABF Parametres are not saved in binary files
@@ -791,12 +791,22 @@ void DynamicReferenceRestraining::update() {
 
 void DynamicReferenceRestraining::save(const string &filename,
                                        long long int step) {
-  std::ofstream out;
-  out.open(filename.c_str(), std::ios::binary);
-  boost::archive::binary_oarchive oa(out);
-  oa << step << fict << vfict << vfict_laststep << ffict << ABFGrid
-     << CZARestimator;
-  out.close();
+  if (comm.Get_rank() != 0)
+    return;
+  // Serialize the state in memory and write it in the background
+  std::ostringstream buffer(std::ios::binary);
+  {
+    boost::archive::binary_oarchive oa(buffer);
+    oa << step << fict << vfict << vfict_laststep << ffict << ABFGrid
+       << CZARestimator;
+  }
+  std::shared_ptr<const string> data(new string(buffer.str()));
+  plumed.getCheckpoint().submit(filename, [data](const string &path) {
+    std::ofstream out;
+    out.open(path.c_str(), std::ios::binary);
+    out.write(data->data(), data->size());
+    out.close();
+  });
 }
 
 void DynamicReferenceRestraining::load(const string &rfile_prefix) {
@@ -23,6 +23,8 @@
 #include "core/ActionPilot.h"
 #include "core/ActionSet.h"
 #include "core/PlumedMain.h"
+#include "tools/Stopwatch.h"
+#include "tools/StopwatchTrace.h"
 
 using namespace std;
 
@@ -44,6 +46,21 @@ DEBUG DETAILED_TIMERS
 DEBUG logRequestedAtoms STRIDE=2
 \endplumedfile
 
+Timers only report averages, which can hide steps that are occasionally much slower
+than the others. The following line also logs the median and the 90th and 99th
+percentiles of each timer and writes a trace of all the timed intervals,
+including each action and the parts of the calculation of multicolvars:
+
+\plumedfile
+DEBUG DETAILED_TIMERS TIMERS_HISTOGRAMS TIMERS_TRACE=trace.json
+\endplumedfile
+
+The trace can be opened with chrome://tracing or https://ui.perfetto.dev.
+It grows by a few hundred bytes per timed interval, so it is meant for short runs.
+On Linux, TIMERS_COUNTERS also logs the CPU cycles, instructions and cache misses
+spent in every timer. This requires access to hardware counters, which might be
+forbidden by the kernel setting /proc/sys/kernel/perf_event_paranoid.
+
 */
 //+ENDPLUMEDOC
 class Debug:
@@ -72,6 +89,9 @@ void Debug::registerKeywords( Keywords& keys ) {
   keys.addFlag("logRequestedAtoms",false,"write in the log which atoms have been requested at a given time");
   keys.addFlag("NOVIRIAL",false,"switch off the virial contribution for the entirety of the simulation");
   keys.addFlag("DETAILED_TIMERS",false,"switch on detailed timers");
+  keys.addFlag("TIMERS_HISTOGRAMS",false,"also log median, 90th and 99th percentiles of each timer");
+  keys.addFlag("TIMERS_COUNTERS",false,"also log hardware counters (cycles, instructions, cache misses) of each timer. Only available on Linux");
+  keys.add("optional","TIMERS_TRACE","write all the timed intervals on this file in Chrome trace format. Implies DETAILED_TIMERS");
   keys.add("optional","FILE","the name of the file on which to output these quantities");
 }
 
@@ -89,10 +109,31 @@ Debug::Debug(const ActionOptions&ao):
   if(novirial) log.printf("  Switching off virial contribution\n");
   if(novirial) plumed.novirial=true;
   parseFlag("DETAILED_TIMERS",detailedTimers);
+  std::string tracefile;
+  parse("TIMERS_TRACE",tracefile);
+  if(tracefile.length()>0) {
+    auto trace=std::make_shared<StopwatchTrace>();
+    trace->link(plumed).open(tracefile);
+    plumed.getStopwatch().setTrace(trace);
+    log.printf("  Writing trace of timers on file %s\n",tracefile.c_str());
+    detailedTimers=true;
+  }
   if(detailedTimers) {
     log.printf("  Detailed timing on\n");
     plumed.detailedTimers=true;
   }
+  bool histograms=false;
+  parseFlag("TIMERS_HISTOGRAMS",histograms);
+  if(histograms) {
+    log.printf("  Logging percentiles of timers\n");
+    plumed.getStopwatch().enableHistograms(true);
+  }
+  bool counters=false;
+  parseFlag("TIMERS_COUNTERS",counters);
+  if(counters) {
+    if(plumed.getStopwatch().enableCounters(true)) log.printf("  Logging hardware counters of timers\n");
+    else log.printf("  WARNING: hardware counters are not available, TIMERS_COUNTERS is ignored\n");
+  }
   ofile.link(*this);
   std::string file;
   parse("FILE",file);
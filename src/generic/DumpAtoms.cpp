@@ -31,6 +31,7 @@
 #include <memory>
 #include "core/SetupMolInfo.h"
 #include "core/ActionSet.h"
+#include "core/ActionWithBackgroundOutput.h"
 
 #if defined(__PLUMED_HAS_XDRFILE)
 #include <xdrfile/xdrfile_xtc.h>
@@ -115,6 +116,16 @@ COM ATOMS=11-20 LABEL=c1
 DUMPATOMS STRIDE=10 FILE=file.xtc ATOMS=1-10,c1 PRECISION=7
 \endplumedfile
 
+When writing many atoms frequently, formatting and writing the file might slow down
+the simulation. With the BACKGROUND flag a copy of the coordinates is taken at each step and the
+file is written on a separate thread, so that the MD code can proceed.
+BUFFER sets how many frames can be kept in memory waiting to be written; when the writer
+falls behind the simulation waits. xyz and gro files can also be compressed by adding
+a `.gz` suffix to their name. The following writes a compressed gro file in the background:
+\plumedfile
+DUMPATOMS STRIDE=10 FILE=file.gro.gz ATOMS=1-1000 BACKGROUND
+\endplumedfile
+
 
 
 */
@@ -122,11 +133,15 @@ DUMPATOMS STRIDE=10 FILE=file.xtc ATOMS=1-10,c1 PRECISION=7
 
 class DumpAtoms:
   public ActionAtomistic,
-  public ActionPilot
+  public ActionPilot,
+  public ActionWithBackgroundOutput
 {
   OFile of;
   double lenunit;
   int iprecision;
+/// Atom serial numbers and names are set in the constructor and only read afterwards,
+/// so that they can be used by the writer thread
+  std::vector<unsigned>    serials;
   std::vector<std::string> names;
   std::vector<unsigned>    residueNumbers;
   std::vector<std::string> residueNames;
@@ -137,6 +152,8 @@ class DumpAtoms:
 #if defined(__PLUMED_HAS_XDRFILE)
   XDRFILE* xd;
 #endif
+/// Write a frame; the time is in the output units
+  void writeFrame(const std::vector<Vector>&positions,const Tensor&box,bool orthorombic,long step,double time);
 public:
   explicit DumpAtoms(const ActionOptions&);
   ~DumpAtoms();
@@ -144,6 +161,7 @@ public:
   void calculate() {}
   void apply() {}
   void update();
+  void fflush();
 };
 
 PLUMED_REGISTER_ACTION(DumpAtoms,"DUMPATOMS")
@@ -152,6 +170,7 @@ void DumpAtoms::registerKeywords( Keywords& keys ) {
   Action::registerKeywords( keys );
   ActionPilot::registerKeywords( keys );
   ActionAtomistic::registerKeywords( keys );
+  ActionWithBackgroundOutput::registerKeywords( keys );
   keys.add("compulsory","STRIDE","1","the frequency with which the atoms should be output");
   keys.add("atoms", "ATOMS", "the atom indices whose positions you would like to print out");
   keys.add("compulsory", "FILE", "file on which to output coordinates; extension is automatically detected");
@@ -171,14 +190,22 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
   Action(ao),
   ActionAtomistic(ao),
   ActionPilot(ao),
+  ActionWithBackgroundOutput(ao),
   iprecision(3)
 {
   vector<AtomNumber> atoms;
   string file;
   parse("FILE",file);
   if(file.length()==0) error("name out output file was not specified");
-  type=Tools::extension(file);
   log<<"  file name "<<file<<"\n";
+// compressed files are detected from the extension preceding .gz
+  std::string uncompressed=file;
+  bool compressed=false;
+  if(Tools::extension(file)=="gz") {
+    uncompressed=file.substr(0,file.length()-3);
+    compressed=true;
+  }
+  type=Tools::extension(uncompressed);
   if(type=="gro" || type=="xyz" || type=="xtc" || type=="trr") {
     log<<"  file extension indicates a "<<type<<" file\n";
   } else {
@@ -193,6 +220,7 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
     log<<"  file type enforced to be "<<ntype<<"\n";
     type=ntype;
   }
+  if(compressed && (type=="xtc" || type=="trr")) error("only xyz and gro files can be compressed");
 #ifndef __PLUMED_HAS_XDRFILE
   if(type=="xtc" || type=="trr") error("types xtc and trr require PLUMED to be linked with the xdrfile library. Please install it and recompile PLUMED.");
 #endif
@@ -227,16 +255,14 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
   else lenunit=1.0;
 
   checkRead();
-  of.link(*this);
-  of.open(file);
-  std::string path=of.getPath();
-  log<<"  Writing on file "<<path<<"\n";
+  openOutputFile(of,file);
+  log<<"  Writing on file "<<file<<"\n";
 #ifdef __PLUMED_HAS_XDRFILE
+  xd=NULL;
   std::string mode=of.getMode();
-  if(type=="xtc") {
-    of.close();
-    xd=xdrfile_open(path.c_str(),mode.c_str());
-  } else if(type=="trr") {
+  std::string path=of.getPath();
+// in background mode, only the first process opens the file
+  if((type=="xtc" || type=="trr") && writesOutput()) {
     of.close();
     xd=xdrfile_open(path.c_str(),mode.c_str());
   }
@@ -245,6 +271,8 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
   for(unsigned i=0; i<atoms.size(); ++i) log.printf(" %d",atoms[i].serial() );
   log.printf("\n");
   requestAtoms(atoms);
+  serials.resize(atoms.size());
+  for(unsigned i=0; i<atoms.size(); ++i) serials[i]=atoms[i].serial();
   std::vector<SetupMolInfo*> moldat=plumed.getActionSet().select<SetupMolInfo*>();
   if( moldat.size()==1 ) {
     log<<"  MOLINFO DATA found, using proper atom names\n";
@@ -258,10 +286,32 @@ DumpAtoms::DumpAtoms(const ActionOptions&ao):
 }
 
 void DumpAtoms::update() {
+  const double time=getTime()/plumed.getAtoms().getUnits().getTime();
+  if(!writesOutput()) return;
+  if(!inBackground()) {
+    writeFrame(getPositions(),getPbc().getBox(),getPbc().isOrthorombic(),getStep(),time);
+    return;
+  }
+// positions are copied, so that the MD code can proceed while they are written
+  const std::vector<Vector> positions(getPositions());
+  const Tensor box(getPbc().getBox());
+  const bool orthorombic=getPbc().isOrthorombic();
+  const long step=getStep();
+  writeInBackground([this,positions,box,orthorombic,step,time]() {
+    writeFrame(positions,box,orthorombic,step,time);
+  });
+}
+
+void DumpAtoms::fflush() {
+  Action::fflush();
+  flushOutput(of);
+}
+
+void DumpAtoms::writeFrame(const std::vector<Vector>&positions,const Tensor&t,bool orthorombic,long step,double time) {
+  const unsigned natoms=positions.size();
   if(type=="xyz") {
-    of.printf("%d\n",getNumberOfAtoms());
-    const Tensor & t(getPbc().getBox());
-    if(getPbc().isOrthorombic()) {
+    of.printf("%u\n",natoms);
+    if(orthorombic) {
       of.printf((" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+"\n").c_str(),lenunit*t(0,0),lenunit*t(1,1),lenunit*t(2,2));
     } else {
       of.printf((" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+"\n").c_str(),
@@ -270,17 +320,16 @@ void DumpAtoms::update() {
                 lenunit*t(2,0),lenunit*t(2,1),lenunit*t(2,2)
                );
     }
-    for(unsigned i=0; i<getNumberOfAtoms(); ++i) {
+    for(unsigned i=0; i<natoms; ++i) {
       const char* defname="X";
       const char* name=defname;
       if(names.size()>0) if(names[i].length()>0) name=names[i].c_str();
-      of.printf(("%s "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+"\n").c_str(),name,lenunit*getPosition(i)(0),lenunit*getPosition(i)(1),lenunit*getPosition(i)(2));
+      of.printf(("%s "+fmt_xyz+" "+fmt_xyz+" "+fmt_xyz+"\n").c_str(),name,lenunit*positions[i](0),lenunit*positions[i](1),lenunit*positions[i](2));
     }
   } else if(type=="gro") {
-    const Tensor & t(getPbc().getBox());
-    of.printf("Made with PLUMED t=%f\n",getTime()/plumed.getAtoms().getUnits().getTime());
-    of.printf("%d\n",getNumberOfAtoms());
-    for(unsigned i=0; i<getNumberOfAtoms(); ++i) {
+    of.printf("Made with PLUMED t=%f\n",time);
+    of.printf("%u\n",natoms);
+    for(unsigned i=0; i<natoms; ++i) {
       const char* defname="X";
       const char* name=defname;
       unsigned residueNumber=0;
@@ -289,8 +338,8 @@ void DumpAtoms::update() {
       std::string resname="";
       if(residueNames.size()>0) resname=residueNames[i];
       of.printf(("%5u%-5s%5s%5d"+fmt_gro_pos+fmt_gro_pos+fmt_gro_pos+"\n").c_str(),
-                residueNumber%100000,resname.c_str(),name,getAbsoluteIndex(i).serial()%100000,
-                lenunit*getPosition(i)(0),lenunit*getPosition(i)(1),lenunit*getPosition(i)(2));
+                residueNumber%100000,resname.c_str(),name,serials[i]%100000,
+                lenunit*positions[i](0),lenunit*positions[i](1),lenunit*positions[i](2));
     }
     of.printf((fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+" "+fmt_gro_box+"\n").c_str(),
               lenunit*t(0,0),lenunit*t(1,1),lenunit*t(2,2),
@@ -299,14 +348,10 @@ void DumpAtoms::update() {
 #if defined(__PLUMED_HAS_XDRFILE)
   } else if(type=="xtc" || type=="trr") {
     matrix box;
-    const Tensor & t(getPbc().getBox());
-    int natoms=getNumberOfAtoms();
-    int step=getStep();
-    float time=getTime()/plumed.getAtoms().getUnits().getTime();
     float precision=Tools::fastpow(10.0,iprecision);
     for(int i=0; i<3; i++) for(int j=0; j<3; j++) box[i][j]=lenunit*t(i,j);
     std::unique_ptr<rvec[]> pos(new rvec [natoms]);
-    for(int i=0; i<natoms; i++) for(int j=0; j<3; j++) pos[i][j]=lenunit*getPosition(i)(j);
+    for(unsigned i=0; i<natoms; i++) for(int j=0; j<3; j++) pos[i][j]=lenunit*positions[i](j);
     if(type=="xtc") {
       write_xtc(xd,natoms,step,time,box,&pos[0],precision);
     } else if(type=="trr") {
@@ -317,12 +362,9 @@ void DumpAtoms::update() {
 }
 
 DumpAtoms::~DumpAtoms() {
+  finishOutput();
 #ifdef __PLUMED_HAS_XDRFILE
-  if(type=="xtc") {
-    xdrfile_close(xd);
-  } else if(type=="trr") {
-    xdrfile_close(xd);
-  }
+  if(xd) xdrfile_close(xd);
 #endif
 }
 
@@ -24,6 +24,7 @@
 #include "core/ActionWithArguments.h"
 #include "core/ActionRegister.h"
 #include "tools/File.h"
+#include "core/ActionWithBackgroundOutput.h"
 
 using namespace std;
 
@@ -38,6 +39,7 @@ For a CV this line in input instructs plumed to print the derivative of the CV w
 and the cell vectors (virial-like form).  In contrast, for a function or bias the derivative with respect to the input "CVs"
 will be output.  This command is most often used to test whether or not analytic derivatives have been implemented correctly.  This
 can be done by outputting the derivatives calculated analytically and numerically.  You can control the buffering of output using the \ref FLUSH keyword.
+With the BACKGROUND flag the file is written on a separate thread, as described for \ref DUMPATOMS.
 
 \par Examples
 
@@ -56,17 +58,25 @@ DUMPDERIVATIVES ARG=distance,distanceN STRIDE=1 FILE=deriv
 
 class DumpDerivatives :
   public ActionPilot,
-  public ActionWithArguments
+  public ActionWithArguments,
+  public ActionWithBackgroundOutput
 {
   string file;
   string fmt;
   OFile of;
+/// Names of the arguments, stored so that they can be used by the writer thread
+  std::vector<std::string> names;
+/// Derivatives of the current frame, stored parameter by parameter
+  std::vector<double> derivatives;
+/// Write a frame
+  void writeFrame(double time,const std::vector<double>&values);
 public:
   void calculate() {}
   explicit DumpDerivatives(const ActionOptions&);
   static void registerKeywords(Keywords& keys);
   void apply() {}
   void update();
+  void fflush();
   ~DumpDerivatives();
 };
 
@@ -76,6 +86,7 @@ void DumpDerivatives::registerKeywords(Keywords& keys) {
   Action::registerKeywords(keys);
   ActionPilot::registerKeywords(keys);
   ActionWithArguments::registerKeywords(keys);
+  ActionWithBackgroundOutput::registerKeywords(keys);
   keys.use("ARG");
   keys.add("compulsory","STRIDE","1","the frequency with which the derivatives should be output");
   keys.add("compulsory","FILE","the name of the file on which to output the derivatives");
@@ -89,14 +100,14 @@ DumpDerivatives::DumpDerivatives(const ActionOptions&ao):
   Action(ao),
   ActionPilot(ao),
   ActionWithArguments(ao),
+  ActionWithBackgroundOutput(ao),
   fmt("%15.10f")
 {
   parse("FILE",file);
   if( file.length()==0 ) error("name of output file was not specified");
   parse("FMT",fmt);
   fmt=" "+fmt;
-  of.link(*this);
-  of.open(file);
+  openOutputFile(of,file);
   log.printf("  on file %s\n",file.c_str());
   log.printf("  with format %s\n",fmt.c_str());
   unsigned nargs=getNumberOfArguments();
@@ -108,25 +119,54 @@ DumpDerivatives::DumpDerivatives(const ActionOptions&ao):
     (getPntrToArgument(i)->getPntrToAction())->turnOnDerivatives();
     if( npar!=getPntrToArgument(i)->getNumberOfDerivatives() ) error("the number of derivatives must be the same in all values being dumped");
   }
+  names.resize(getNumberOfArguments());
+  for(unsigned i=0; i<names.size(); i++) names[i]=getPntrToArgument(i)->getName();
   checkRead();
 }
 
 
 void DumpDerivatives::update() {
+  if(!writesOutput()) return;
   unsigned npar=getPntrToArgument(0)->getNumberOfDerivatives();
+  unsigned nargs=getNumberOfArguments();
+  derivatives.resize(npar*nargs);
+  for(unsigned ipar=0; ipar<npar; ipar++) for(unsigned i=0; i<nargs; i++) {
+      derivatives[ipar*nargs+i]=getPntrToArgument(i)->getDerivative(ipar);
+    }
+  const double time=getTime();
+  if(!inBackground()) {
+    writeFrame(time,derivatives);
+    return;
+  }
+// derivatives are copied, so that the MD code can proceed while they are written
+  const std::vector<double> copy(derivatives);
+  writeInBackground([this,time,copy]() {
+    writeFrame(time,copy);
+  });
+}
+
+void DumpDerivatives::fflush() {
+  Action::fflush();
+  flushOutput(of);
+}
+
+void DumpDerivatives::writeFrame(double time,const std::vector<double>&values) {
+  unsigned nargs=names.size();
+  unsigned npar=values.size()/nargs;
   for(unsigned ipar=0; ipar<npar; ipar++) {
     of.fmtField(" %f");
-    of.printField("time",getTime());
+    of.printField("time",time);
     of.printField("parameter",(int)ipar);
-    for(unsigned i=0; i<getNumberOfArguments(); i++) {
+    for(unsigned i=0; i<nargs; i++) {
       of.fmtField(fmt);
-      of.printField(getPntrToArgument(i)->getName(),getPntrToArgument(i)->getDerivative(ipar) );
+      of.printField(names[i],values[ipar*nargs+i]);
     }
     of.printField();
   }
 }
 
 DumpDerivatives::~DumpDerivatives() {
+  finishOutput();
 }
 
 }
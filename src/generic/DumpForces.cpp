@@ -23,6 +23,7 @@
 #include "core/ActionWithArguments.h"
 #include "core/ActionRegister.h"
 #include "tools/File.h"
+#include "core/ActionWithBackgroundOutput.h"
 
 using namespace std;
 
@@ -38,6 +39,7 @@ the force on the CV itself. Be aware that in order to have the forces on the ato
 you should multiply the output from this argument by the output from DUMPDERIVATIVES.
 Furthermore, also note that you can output the forces on multiple quantities simultaneously
 by specifying more than one argument. You can control the buffering of output using the \ref FLUSH keyword.
+With the BACKGROUND flag the file is written on a separate thread, as described for \ref DUMPATOMS.
 
 
 \par Examples
@@ -54,17 +56,25 @@ DUMPFORCES ARG=distance STRIDE=1 FILE=forces
 
 class DumpForces :
   public ActionPilot,
-  public ActionWithArguments
+  public ActionWithArguments,
+  public ActionWithBackgroundOutput
 {
   string file;
   string fmt;
   OFile of;
+/// Names of the arguments, stored so that they can be used by the writer thread
+  std::vector<std::string> names;
+/// Forces of the current frame
+  std::vector<double> forces;
+/// Write a frame
+  void writeFrame(double time,const std::vector<double>&values);
 public:
   void calculate() {}
   explicit DumpForces(const ActionOptions&);
   static void registerKeywords(Keywords& keys);
   void apply() {}
   void update();
+  void fflush();
   ~DumpForces();
 };
 
@@ -74,6 +84,7 @@ void DumpForces::registerKeywords(Keywords& keys) {
   Action::registerKeywords(keys);
   ActionPilot::registerKeywords(keys);
   ActionWithArguments::registerKeywords(keys);
+  ActionWithBackgroundOutput::registerKeywords(keys);
   keys.use("ARG");
   keys.add("compulsory","STRIDE","1","the frequency with which the forces should be output");
   keys.add("compulsory","FILE","the name of the file on which to output the forces");
@@ -87,32 +98,56 @@ DumpForces::DumpForces(const ActionOptions&ao):
   Action(ao),
   ActionPilot(ao),
   ActionWithArguments(ao),
+  ActionWithBackgroundOutput(ao),
   fmt("%15.10f")
 {
   parse("FILE",file);
   if( file.length()==0 ) error("name of file was not specified");
   parse("FMT",fmt);
   fmt=" "+fmt;
-  of.link(*this);
-  of.open(file);
+  openOutputFile(of,file);
   log.printf("  on file %s\n",file.c_str());
   log.printf("  with format %s\n",fmt.c_str());
   if( getNumberOfArguments()==0 ) error("no arguments have been specified");
+  names.resize(getNumberOfArguments());
+  for(unsigned i=0; i<names.size(); i++) names[i]=getPntrToArgument(i)->getName();
   checkRead();
 }
 
 
 void DumpForces::update() {
+  if(!writesOutput()) return;
+  forces.resize(getNumberOfArguments());
+  for(unsigned i=0; i<forces.size(); i++) forces[i]=getPntrToArgument(i)->getForce();
+  const double time=getTime();
+  if(!inBackground()) {
+    writeFrame(time,forces);
+    return;
+  }
+// forces are copied, so that the MD code can proceed while they are written
+  const std::vector<double> copy(forces);
+  writeInBackground([this,time,copy]() {
+    writeFrame(time,copy);
+  });
+}
+
+void DumpForces::fflush() {
+  Action::fflush();
+  flushOutput(of);
+}
+
+void DumpForces::writeFrame(double time,const std::vector<double>&values) {
   of.fmtField(" %f");
-  of.printField("time",getTime());
-  for(unsigned i=0; i<getNumberOfArguments(); i++) {
+  of.printField("time",time);
+  for(unsigned i=0; i<values.size(); i++) {
     of.fmtField(fmt);
-    of.printField(getPntrToArgument(i)->getName(),getPntrToArgument(i)->getForce());
+    of.printField(names[i],values[i]);
   }
   of.printField();
 }
 
 DumpForces::~DumpForces() {
+  finishOutput();
 }
 
 }
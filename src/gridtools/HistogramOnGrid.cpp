@@ -52,6 +52,9 @@ HistogramOnGrid::HistogramOnGrid( const vesselbase::VesselOptions& da ):
   }
 }
 
+HistogramOnGrid::~HistogramOnGrid() {
+}
+
 double HistogramOnGrid::getFibonacciCutoff() const {
   return std::log( epsilon / von_misses_norm ) / von_misses_concentration;
 }
@@ -71,38 +74,38 @@ void HistogramOnGrid::setBounds( const std::vector<std::string>& smin, const std
       if( pbc[i] && 2*support[i]>getGridExtent(i) ) error("bandwidth is too large for periodic grid");
       neigh_tot *= (2*nneigh[i]+1);
     }
+    // The normalization does not depend on where the kernel is centered so it is done once here
+    period.assign( dimension, 0.0 );
+    for(unsigned i=0; i<dimension; ++i) {
+      if( pbc[i] ) period[i]=getGridExtent(i);
+    }
+    basekernel.reset( new KernelFunctions( &kernel ) ); basekernel->normalize( period );
   }
 }
 
-std::unique_ptr<KernelFunctions> HistogramOnGrid::getKernelAndNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const {
+bool HistogramOnGrid::getPointNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const {
   if( discrete ) {
     plumed_assert( getType()=="flat" );
     num_neigh=1; for(unsigned i=0; i<dimension; ++i) point[i] += 0.5*dx[i];
-    neighbors[0] = getIndex( point ); return NULL;
+    neighbors[0] = getIndex( point ); return false;
   } else if( getType()=="flat" ) {
-    std::unique_ptr<KernelFunctions> kernel(new KernelFunctions( point, bandwidths, kerneltype, "DIAGONAL", 1.0 ));
-// GB: Now values is destroyed when exiting this function.
-// I think before there was a leak
-    std::vector<std::unique_ptr<Value>> values=getVectorOfValues();
-    kernel->normalize( Tools::unique2raw(values) ); getNeighbors( kernel->getCenter(), nneigh, num_neigh, neighbors );
-    return kernel;
+    plumed_dbg_assert( basekernel );
+    getNeighbors( point, nneigh, num_neigh, neighbors );
+    return true;
   } else if( getType()=="fibonacci" ) {
     getNeighbors( point, nneigh, num_neigh, neighbors );
-    return NULL;
+    return false;
   } else {
     plumed_error();
   }
-  return NULL;
+  return false;
 }
 
-std::vector<std::unique_ptr<Value>> HistogramOnGrid::getVectorOfValues() const {
-  std::vector<std::unique_ptr<Value>> vv;
-  for(unsigned i=0; i<dimension; ++i) {
-    vv.emplace_back(new Value());
-    if( pbc[i] ) vv[i]->setDomain( str_min[i], str_max[i] );
-    else vv[i]->setNotPeriodic();
-  }
-  return vv;
+std::unique_ptr<KernelFunctions> HistogramOnGrid::getKernelAndNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const {
+  if( !getPointNeighbors( point, num_neigh, neighbors ) ) return NULL;
+  std::unique_ptr<KernelFunctions> kernel(new KernelFunctions( basekernel.get() ));
+  kernel->setCenter( point.data() );
+  return kernel;
 }
 
 void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const {
@@ -118,24 +121,25 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
     // Get the kernel
     unsigned num_neigh; std::vector<unsigned> neighbors(1);
     std::vector<double> der( dimension );
-    std::unique_ptr<KernelFunctions> kernel=getKernelAndNeighbors( point, num_neigh, neighbors );
+    bool usekernel=getPointNeighbors( point, num_neigh, neighbors );
 
-    if( !kernel && getType()=="flat" ) {
+    if( !usekernel && getType()=="flat" ) {
       plumed_dbg_assert( num_neigh==1 ); der.resize(0);
       accumulate( neighbors[0], weight, 1.0, der, buffer );
     } else {
       double totwforce=0.0;
       std::vector<double> intforce( 2*dimension, 0.0 );
-      std::vector<std::unique_ptr<Value>> vv( getVectorOfValues() );
 
       double newval; std::vector<unsigned> tindices( dimension ); std::vector<double> xx( dimension );
       for(unsigned i=0; i<num_neigh; ++i) {
         unsigned ineigh=neighbors[i];
         if( inactive( ineigh ) ) continue ;
         getGridPointCoordinates( ineigh, tindices, xx );
-        if( kernel ) {
-          for(unsigned j=0; j<dimension; ++j) vv[j]->set(xx[j]);
-          newval = kernel->evaluate( Tools::unique2raw(vv), der, true );
+        if( usekernel ) {
+          // the kernel centered at the origin is evaluated at the displacement from the
+          // sample, so that no kernel has to be built for each sample
+          for(unsigned j=0; j<dimension; ++j) xx[j]-=point[j];
+          newval = basekernel->evaluate( xx.data(), period.data(), der.data(), true );
         } else {
           // Evalulate dot product
           double dot=0; for(unsigned j=0; j<dimension; ++j) { dot+=xx[j]*point[j]; der[j]=xx[j]; }
@@ -153,7 +157,7 @@ void HistogramOnGrid::calculate( const unsigned& current, MultiValue& myvals, st
       if( wasForced() ) {
         // Minus sign for kernel here as we are taking derivative with respect to position of center of
         // kernel NOT derivative wrt to grid point
-        double pref = 1; if( kernel ) pref = -1;
+        double pref = 1; if( usekernel ) pref = -1;
         unsigned nder = getAction()->getNumberOfDerivatives();
         unsigned gridbuf = getNumberOfBufferPoints()*getNumberOfQuantities();
         for(unsigned j=0; j<dimension; ++j) {
@@ -38,6 +38,12 @@ private:
   std::string kerneltype;
   std::vector<double> bandwidths;
   std::vector<unsigned> nneigh;
+/// The period of each direction of the grid (zero for directions that are not periodic)
+  std::vector<double> period;
+/// The normalized kernel centered at the origin that all kernels are copied from
+  std::unique_ptr<KernelFunctions> basekernel;
+/// Find the grid points a sample contributes to; returns true if basekernel has to be evaluated on them
+  bool getPointNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const;
 protected:
   bool discrete;
 public:
@@ -45,6 +51,7 @@ public:
   double von_misses_concentration;
   static void registerKeywords( Keywords& keys );
   explicit HistogramOnGrid( const vesselbase::VesselOptions& da );
+  ~HistogramOnGrid();
   void setBounds( const std::vector<std::string>& smin, const std::vector<std::string>& smax,
                   const std::vector<unsigned>& nbins, const std::vector<double>& spacing );
   void calculate( const unsigned& current, MultiValue& myvals, std::vector<double>& buffer, std::vector<unsigned>& der_list ) const ;
@@ -53,13 +60,19 @@ public:
   virtual void accumulateForce( const unsigned& ipoint, const double& weight, const std::vector<double>& der, std::vector<double>& intforce ) const ;
   unsigned getNumberOfBufferPoints() const ;
   std::unique_ptr<KernelFunctions> getKernelAndNeighbors( std::vector<double>& point, unsigned& num_neigh, std::vector<unsigned>& neighbors ) const;
-  std::vector<std::unique_ptr<Value>> getVectorOfValues() const ;
+/// Get the periods of the grid directions in the form used by KernelFunctions::evaluate
+  const std::vector<double>& getPeriods() const ;
   void addOneKernelEachTimeOnly() { addOneKernelAtATime=true; }
   virtual void getFinalForces( const std::vector<double>& buffer, std::vector<double>& finalForces );
   bool noDiscreteKernels() const ;
   double getFibonacciCutoff() const ;
 };
 
+inline
+const std::vector<double>& HistogramOnGrid::getPeriods() const {
+  return period;
+}
+
 inline
 unsigned HistogramOnGrid::getNumberOfBufferPoints() const {
   if( addOneKernelAtATime ) return neigh_tot;
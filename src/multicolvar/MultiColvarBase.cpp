@@ -81,8 +81,6 @@ MultiColvarBase::MultiColvarBase(const ActionOptions&ao):
   usepbc(false),
   allthirdblockintasks(false),
   uselinkforthree(false),
-  linkcells(comm),
-  threecells(comm),
   setup_completed(false),
   atomsWereRetrieved(false),
   matsums(false),
@@ -64,7 +64,6 @@ class VolumeInEnvelope : public ActionVolume {
 private:
   LinkCells mylinks;
   std::unique_ptr<KernelFunctions> kernel;
-  std::vector<std::unique_ptr<Value>> pos;
   std::vector<Vector> ltmp_pos;
   std::vector<unsigned> ltmp_ind;
   SwitchingFunction sfunc;
@@ -86,8 +85,7 @@ void VolumeInEnvelope::registerKeywords( Keywords& keys ) {
 
 VolumeInEnvelope::VolumeInEnvelope(const ActionOptions& ao):
   Action(ao),
-  ActionVolume(ao),
-  mylinks(comm)
+  ActionVolume(ao)
 {
   std::vector<AtomNumber> atoms; parseAtomList("ATOMS",atoms);
   log.printf("  creating density field from atoms : ");
@@ -104,7 +102,6 @@ VolumeInEnvelope::VolumeInEnvelope(const ActionOptions& ao):
   std::vector<double> pp(3,0.0), bandwidth(3); parseVector("BANDWIDTH",bandwidth);
   log.printf("  using %s kernel with bandwidths %f %f %f \n",getKernelType().c_str(),bandwidth[0],bandwidth[1],bandwidth[2] );
   kernel.reset( new KernelFunctions( pp, bandwidth, getKernelType(), "DIAGONAL", 1.0 ) );
-  for(unsigned i=0; i<3; ++i) { pos.emplace_back(new Value()); pos[i]->setNotPeriodic(); }
   std::vector<double> csupport( kernel->getContinuousSupport() );
   double maxs = csupport[0];
   for(unsigned i=1; i<csupport.size(); ++i) {
@@ -122,15 +119,13 @@ double VolumeInEnvelope::calculateNumberInside( const Vector& cpos, Vector& deri
   unsigned ncells_required=0, natoms=1; std::vector<unsigned> cells_required( mylinks.getNumberOfCells() ), indices( 1 + getNumberOfAtoms() );
   mylinks.addRequiredCells( mylinks.findMyCell( cpos ), ncells_required, cells_required );
   indices[0]=getNumberOfAtoms(); mylinks.retrieveAtomsInCells( ncells_required, cells_required, natoms, indices );
-  double value=0; std::vector<double> der(3); Vector tder;
-
-  // convert pointer once
-  auto pos_ptr=Tools::unique2raw(pos);
+  double value=0; double der[3]; Vector tder;
+  // separations are already minimum image so no direction is treated as periodic
+  const double period[3]= {0.0,0.0,0.0};
 
   for(unsigned i=1; i<natoms; ++i) {
     Vector dist = getSeparation( cpos, getPosition( indices[i] ) );
-    for(unsigned j=0; j<3; ++j) pos[j]->set( dist[j] );
-    value += kernel->evaluate( pos_ptr, der, true );
+    value += kernel->evaluate( &dist[0], period, der, true );
     for(unsigned j=0; j<3; ++j) {
       derivatives[j] -= der[j]; refders[ indices[i] ][j] += der[j]; tder[j]=der[j];
     }
@@ -26,6 +26,7 @@
 #include "KernelFunctions.h"
 #include "File.h"
 #include "Grid.h"
+#include "OpenMP.h"
 
 
 namespace PLMD {
@@ -33,7 +34,7 @@ namespace PLMD {
 using namespace std;
 
 /// the constructor here
-BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc ):hasgrid(false),rescaledToBias(false),mycomm(cc) {
+BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc ):hasgrid(false),rescaledToBias(false),nkernels(0),mycomm(cc) {
   lowI_=0.0;
   uppI_=0.0;
   doInt_=false;
@@ -44,7 +45,7 @@ BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communi
   }
 }
 /// overload the constructor: add the sigma  at constructor time
-BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc,  const vector<double> & sigma ):hasgrid(false), rescaledToBias(false), histosigma(sigma),mycomm(cc) {
+BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc,  const vector<double> & sigma ):hasgrid(false), rescaledToBias(false), nkernels(0), histosigma(sigma),mycomm(cc) {
   lowI_=0.0;
   uppI_=0.0;
   doInt_=false;
@@ -56,7 +57,7 @@ BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communi
 }
 /// overload the constructor: add the grid at constructor time
 BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc, const vector<string> & gmin, const vector<string> & gmax,
-                                       const vector<unsigned> & nbin, bool doInt, double lowI, double uppI ):hasgrid(false), rescaledToBias(false), mycomm(cc) {
+                                       const vector<unsigned> & nbin, bool doInt, double lowI, double uppI ):hasgrid(false), rescaledToBias(false), nkernels(0), mycomm(cc) {
   ndim=tmpvalues.size();
   for(int  i=0; i<ndim; i++) {
     values.push_back(tmpvalues[i]);
@@ -69,7 +70,7 @@ BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communi
   addGrid(gmin,gmax,nbin);
 }
 /// overload the constructor with some external sigmas: needed for histogram
-BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc, const vector<string> & gmin, const vector<string> & gmax, const vector<unsigned> & nbin, const vector<double> & sigma):hasgrid(false), rescaledToBias(false),histosigma(sigma),mycomm(cc) {
+BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communicator &cc, const vector<string> & gmin, const vector<string> & gmax, const vector<unsigned> & nbin, const vector<double> & sigma):hasgrid(false), rescaledToBias(false), nkernels(0), histosigma(sigma),mycomm(cc) {
   lowI_=0.0;
   uppI_=0.0;
   doInt_=false;
@@ -83,7 +84,7 @@ BiasRepresentation::BiasRepresentation(const vector<Value*> & tmpvalues, Communi
 }
 
 void  BiasRepresentation::addGrid( const vector<string> & gmin, const vector<string> & gmax, const vector<unsigned> & nbin ) {
-  plumed_massert(hills.size()==0,"you can set the grid before loading the hills");
+  plumed_massert(nkernels==0,"you can set the grid before loading the hills");
   plumed_massert(hasgrid==false,"to build the grid you should not having the grid in this bias representation");
   string ss; ss="file.free";
   vector<Value*> vv; for(unsigned i=0; i<values.size(); i++)vv.push_back(values[i]);
@@ -95,7 +96,7 @@ bool BiasRepresentation::hasSigmaInInput() {
   if(histosigma.size()==0) {return false;} else {return true;}
 }
 void BiasRepresentation::setRescaledToBias(bool rescaled) {
-  plumed_massert(hills.size()==0,"you can set the rescaling function only before loading hills");
+  plumed_massert(nkernels==0,"you can set the rescaling function only before loading hills");
   rescaledToBias=rescaled;
 }
 const bool & BiasRepresentation::isRescaledToBias() {
@@ -145,7 +146,6 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
     ifile->scanField("biasf",dummy);
     Tools::convert(dummy,dummyd);
   } else {dummyd=1.0;}
-  biasf.push_back(dummyd);
   // the domain does not pertain to the kernel but to the values here defined
   string	mins,maxs,minv,maxv,mini,maxi; mins="min_"; maxs="max_";
   for(int i=0 ; i<ndim; i++) {
@@ -158,94 +158,134 @@ void BiasRepresentation::pushKernel( IFile *ifile ) {
       plumed_massert(maxi==maxv,"the input periodicity in hills and in value definition does not match"  );
     }
   }
-  // if grid is defined then it should be added on the grid
-  //cerr<<"now with "<<hills.size()<<endl;
-  if(hasgrid) {
-    vector<unsigned> nneighb;
-    if(doInt_&&(kk->getCenter()[0]+kk->getContinuousSupport()[0] > uppI_ || kk->getCenter()[0]-kk->getContinuousSupport()[0] < lowI_ )) {
-      nneighb=BiasGrid_->getNbin();
-    } else nneighb=kk->getSupport(BiasGrid_->getDx());
-    vector<Grid::index_t> neighbors=BiasGrid_->getNeighbors(kk->getCenter(),nneighb);
-    vector<double> der(ndim);
-    vector<double> xx(ndim);
-    if(mycomm.Get_size()==1) {
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(int j=0; j<ndim; ++j) {der[j]=0.0;}
+  nkernels++;
+  // kernels are not stored: without a grid only the extent of the kernels is retained
+  if(!hasgrid) {
+    updateMinMaxBin(*kk);
+    return;
+  }
+  // with more processes the neighbors of each kernel are shared among them
+  if(mycomm.Get_size()>1) {
+    depositKernel(*kk,dummyd);
+    return;
+  }
+  // otherwise kernels are deposited in chunks by threads
+  pending.emplace_back(std::move(kk));
+  pendingBiasf.push_back(dummyd);
+  if(pending.size()>=chunksize) flushKernels();
+}
+vector<Grid::index_t> BiasRepresentation::getKernelNeighbors(const KernelFunctions & kk) {
+  vector<unsigned> nneighb;
+  if(doInt_&&(kk.getCenter()[0]+kk.getContinuousSupport()[0] > uppI_ || kk.getCenter()[0]-kk.getContinuousSupport()[0] < lowI_ )) {
+    nneighb=BiasGrid_->getNbin();
+  } else nneighb=kk.getSupport(BiasGrid_->getDx());
+  return BiasGrid_->getNeighbors(kk.getCenter(),nneighb);
+}
+double BiasRepresentation::evaluateKernel(const KernelFunctions & kk, double bf, const vector<double> & xx, const vector<double> & period, vector<double> & der) {
+  double bias;
+  if(doInt_) bias=kk.evaluate(xx.data(),period.data(),der.data(),true,doInt_,lowI_,uppI_);
+  else bias=kk.evaluate(xx.data(),period.data(),der.data(),true);
+  if(rescaledToBias) {
+    double f=(bf-1.)/(bf);
+    bias*=f;
+    for(int j=0; j<ndim; ++j) {der[j]*=f;}
+  }
+  return bias;
+}
+vector<double> BiasRepresentation::getPeriods() {
+  vector<double> period(ndim,0.0);
+  for(int j=0; j<ndim; ++j) if(values[j]->isPeriodic()) period[j]=values[j]->getMaxMinusMin();
+  return period;
+}
+void BiasRepresentation::flushKernels() {
+  if(pending.size()==0) return;
+  // Grid points are split in tiles that are assigned cyclically to the threads.
+  // Each thread goes through all the kernels of the chunk in order and only updates
+  // the points it owns, so that the result does not depend on the number of threads
+  const unsigned tile=256;
+  vector<double> period(getPeriods());
+  unsigned nt=OpenMP::getNumThreads();
+  // neighbors are computed once per kernel, splitting the kernels among threads
+  vector<vector<Grid::index_t> > neighbors(pending.size());
+  #pragma omp parallel for num_threads(nt) schedule(dynamic,16)
+  for(unsigned k=0; k<pending.size(); ++k) neighbors[k]=getKernelNeighbors(*pending[k]);
+  #pragma omp parallel for num_threads(nt) schedule(static,1)
+  for(unsigned it=0; it<nt; ++it) {
+    vector<double> der(ndim), xx(ndim);
+    for(unsigned k=0; k<pending.size(); ++k) {
+      for(unsigned i=0; i<neighbors[k].size(); ++i) {
+        Grid::index_t ineigh=neighbors[k][i];
+        if((ineigh/tile)%nt!=it) continue;
         BiasGrid_->getPoint(ineigh,xx);
-        // assign xx to a new vector of values
-        for(int j=0; j<ndim; ++j) {values[j]->set(xx[j]);}
-        double bias;
-        if(doInt_) bias=kk->evaluate(values,der,true,doInt_,lowI_,uppI_);
-        else bias=kk->evaluate(values,der,true);
-        if(rescaledToBias) {
-          double f=(biasf.back()-1.)/(biasf.back());
-          bias*=f;
-          for(int j=0; j<ndim; ++j) {der[j]*=f;}
-        }
+        double bias=evaluateKernel(*pending[k],pendingBiasf[k],xx,period,der);
         BiasGrid_->addValueAndDerivatives(ineigh,bias,der);
       }
-    } else {
-      unsigned stride=mycomm.Get_size();
-      unsigned rank=mycomm.Get_rank();
-      vector<double> allder(ndim*neighbors.size(),0.0);
-      vector<double> allbias(neighbors.size(),0.0);
-      vector<double> tmpder(ndim);
-      for(unsigned i=rank; i<neighbors.size(); i+=stride) {
-        Grid::index_t ineigh=neighbors[i];
-        BiasGrid_->getPoint(ineigh,xx);
-        for(int j=0; j<ndim; ++j) {values[j]->set(xx[j]);}
-        if(doInt_) allbias[i]=kk->evaluate(values,der,true,doInt_,lowI_,uppI_);
-        else allbias[i]=kk->evaluate(values,der,true);
-        if(rescaledToBias) {
-          double f=(biasf.back()-1.)/(biasf.back());
-          allbias[i]*=f;
-          for(int j=0; j<ndim; ++j) {tmpder[j]*=f;}
-        }
-        // this solution with the temporary vector is rather bad, probably better to take
-        // a pointer of double as it was in old gaussian
-        for(int j=0; j<ndim; ++j) { allder[ndim*i+j]=tmpder[j]; tmpder[j]=0.;}
-      }
-      mycomm.Sum(allbias);
-      mycomm.Sum(allder);
-      for(unsigned i=0; i<neighbors.size(); ++i) {
-        Grid::index_t ineigh=neighbors[i];
-        for(int j=0; j<ndim; ++j) {der[j]=allder[ndim*i+j];}
-        BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
-      }
     }
   }
-  hills.emplace_back(std::move(kk));
+  pending.clear();
+  pendingBiasf.clear();
+}
+void BiasRepresentation::depositKernel(const KernelFunctions & kk, double bf) {
+  vector<Grid::index_t> neighbors=getKernelNeighbors(kk);
+  vector<double> der(ndim);
+  vector<double> xx(ndim);
+  vector<double> period(getPeriods());
+  unsigned stride=mycomm.Get_size();
+  unsigned rank=mycomm.Get_rank();
+  vector<double> allder(ndim*neighbors.size(),0.0);
+  vector<double> allbias(neighbors.size(),0.0);
+  for(unsigned i=rank; i<neighbors.size(); i+=stride) {
+    Grid::index_t ineigh=neighbors[i];
+    BiasGrid_->getPoint(ineigh,xx);
+    allbias[i]=evaluateKernel(kk,bf,xx,period,der);
+    for(int j=0; j<ndim; ++j) allder[ndim*i+j]=der[j];
+  }
+  mycomm.Sum(allbias);
+  mycomm.Sum(allder);
+  for(unsigned i=0; i<neighbors.size(); ++i) {
+    Grid::index_t ineigh=neighbors[i];
+    for(int j=0; j<ndim; ++j) {der[j]=allder[ndim*i+j];}
+    BiasGrid_->addValueAndDerivatives(ineigh,allbias[i],der);
+  }
 }
 int BiasRepresentation::getNumberOfKernels() {
-  return hills.size();
+  return nkernels;
 }
 Grid* BiasRepresentation::getGridPtr() {
   plumed_massert(hasgrid,"if you want the grid pointer then you should have defined a grid before");
+  flushKernels();
   return BiasGrid_.get();
 }
+void BiasRepresentation::updateMinMaxBin(const KernelFunctions & kk) {
+  if(vmin_.size()==0) {
+    vmin_.assign(ndim,10.e20);
+    vmax_.assign(ndim,-10.e20);
+    binsize_.assign(ndim,10.e20);
+  }
+  int ndiv=10; // adjustable parameter: division per support
+  vector<double> ss,cc;
+  if(histosigma.size()!=0) {
+    ss=histosigma;
+  } else {
+    ss=kk.getContinuousSupport();
+  }
+  cc=kk.getCenter();
+  for(int j=0; j<ndim; j++) {
+    double dmin=cc[j]-ss[j];
+    double dmax=cc[j]+ss[j];
+    double ddiv=ss[j]/double(ndiv);
+    if(dmin<vmin_[j])vmin_[j]=dmin;
+    if(dmax>vmax_[j])vmax_[j]=dmax;
+    if(ddiv<binsize_[j])binsize_[j]=ddiv;
+  }
+}
 void BiasRepresentation::getMinMaxBin(vector<double> &vmin, vector<double> &vmax, vector<unsigned> &vbin) {
-  vector<double> ss,cc,binsize;
   vmin.clear(); vmin.resize(ndim,10.e20);
   vmax.clear(); vmax.resize(ndim,-10.e20);
   vbin.clear(); vbin.resize(ndim);
-  binsize.clear(); binsize.resize(ndim,10.e20);
-  int ndiv=10; // adjustable parameter: division per support
-  for(unsigned i=0; i<hills.size(); i++) {
-    if(histosigma.size()!=0) {
-      ss=histosigma;
-    } else {
-      ss=hills[i]->getContinuousSupport();
-    }
-    cc=hills[i]->getCenter();
-    for(int j=0; j<ndim; j++) {
-      double dmin=cc[j]-ss[j];
-      double dmax=cc[j]+ss[j];
-      double ddiv=ss[j]/double(ndiv);
-      if(dmin<vmin[j])vmin[j]=dmin;
-      if(dmax>vmax[j])vmax[j]=dmax;
-      if(ddiv<binsize[j])binsize[j]=ddiv;
-    }
+  vector<double> binsize(ndim,10.e20);
+  if(vmin_.size()!=0) {
+    vmin=vmin_; vmax=vmax_; binsize=binsize_;
   }
   for(int j=0; j<ndim; j++) {
     // reset to periodicity
@@ -259,7 +299,10 @@ void BiasRepresentation::getMinMaxBin(vector<double> &vmin, vector<double> &vmax
   }
 }
 void BiasRepresentation::clear() {
-  hills.clear();
+  nkernels=0;
+  pending.clear();
+  pendingBiasf.clear();
+  vmin_.clear(); vmax_.clear(); binsize_.clear();
   // clear the grid
   if(hasgrid) {
     BiasGrid_->clear();
@@ -23,13 +23,13 @@
 #define __PLUMED_tools_BiasRepresentation_h
 
 #include "Exception.h"
+#include "Grid.h"
 #include <memory>
 #include <vector>
 
 namespace PLMD {
 
 class Value;
-class Grid;
 class IFile;
 class KernelFunctions;
 class Communicator;
@@ -86,6 +86,20 @@ public:
   /// clear the representation (grid included)
   void clear();
 private:
+  /// get the grid points on which a kernel has to be evaluated
+  std::vector<Grid::index_t> getKernelNeighbors(const KernelFunctions & kk);
+  /// evaluate a kernel on a grid point, rescaling it if needed
+  double evaluateKernel(const KernelFunctions & kk, double bf, const std::vector<double> & xx, const std::vector<double> & period, std::vector<double> & der);
+  /// get the period of each variable (zero if not periodic)
+  std::vector<double> getPeriods();
+  /// add a kernel to the grid, sharing the grid points among processes
+  void depositKernel(const KernelFunctions & kk, double bf);
+  /// add the kernels that have been read and not yet added to the grid
+  void flushKernels();
+  /// update the extent of the kernels read so far
+  void updateMinMaxBin(const KernelFunctions & kk);
+  /// number of kernels that are read before adding them to the grid
+  static const unsigned chunksize=1024;
   int ndim;
   bool hasgrid;
   bool rescaledToBias;
@@ -94,8 +108,12 @@ private:
   double uppI_;
   std::vector<Value*> values;
   std::vector<std::string> names;
-  std::vector<std::unique_ptr<KernelFunctions>> hills;
-  std::vector<double> biasf;
+  int nkernels;
+  std::vector<std::unique_ptr<KernelFunctions>> pending;
+  std::vector<double> pendingBiasf;
+  std::vector<double> vmin_;
+  std::vector<double> vmax_;
+  std::vector<double> binsize_;
   std::vector<double> histosigma;
   Communicator& mycomm;
   std::unique_ptr<Grid> BiasGrid_;
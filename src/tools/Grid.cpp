@@ -380,32 +380,12 @@ void Grid::addKernel( const KernelFunctions& kernel ) {
   plumed_dbg_assert( kernel.ndim()==dimension_ );
   std::vector<unsigned> nneighb=kernel.getSupport( dx_ );
   std::vector<index_t> neighbors=getNeighbors( kernel.getCenter(), nneighb );
-  std::vector<double> xx( dimension_ );
-  std::vector<std::unique_ptr<Value>> vv( dimension_ );
-  std::string str_min, str_max;
-  for(unsigned i=0; i<dimension_; ++i) {
-    vv[i].reset(new Value());
-    if( pbc_[i] ) {
-      Tools::convert(min_[i],str_min);
-      Tools::convert(max_[i],str_max);
-      vv[i]->setDomain( str_min, str_max );
-    } else {
-      vv[i]->setNotPeriodic();
-    }
-  }
-
-// vv_ptr contains plain pointers obtained from vv.
-// this is the simplest way to replace a unique_ptr here.
-// perhaps the interface of kernel.evaluate() should be changed
-// in order to accept a std::vector<std::unique_ptr<Value>>
-  auto vv_ptr=Tools::unique2raw(vv);
-
-  std::vector<double> der( dimension_ );
+  std::vector<double> xx( dimension_ ), der( dimension_ ), period( dimension_, 0.0 );
+  for(unsigned i=0; i<dimension_; ++i) if( pbc_[i] ) period[i]=max_[i]-min_[i];
   for(unsigned i=0; i<neighbors.size(); ++i) {
     index_t ineigh=neighbors[i];
     getPoint( ineigh, xx );
-    for(unsigned j=0; j<dimension_; ++j) vv[j]->set(xx[j]);
-    double newval = kernel.evaluate( vv_ptr, der, usederiv_ );
+    double newval = kernel.evaluate( xx.data(), period.data(), der.data(), usederiv_ );
     if( usederiv_ ) addValueAndDerivatives( ineigh, newval, der );
     else addValue( ineigh, newval );
   }
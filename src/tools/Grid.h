@@ -216,6 +216,10 @@ public:
   void writeCubeFile(OFile&, const double& lunit);
 
   virtual ~Grid() {}
+/// return a copy of the grid (of the same type)
+  virtual std::unique_ptr<Grid> clone() const {
+    return std::unique_ptr<Grid>(new Grid(*this));
+  }
 
 /// project a high dimensional grid onto a low dimensional one: this should be changed at some time
 /// to enable many types of weighting
@@ -278,6 +282,10 @@ public:
 /// dump grid on file
   void writeToFile(OFile&);
 
+  std::unique_ptr<Grid> clone() const {
+    return std::unique_ptr<Grid>(new SparseGrid(*this));
+  }
+
   virtual ~SparseGrid() {}
 };
 }
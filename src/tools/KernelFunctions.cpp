@@ -26,6 +26,9 @@
 
 namespace PLMD {
 
+/// Kernels with up to this number of dimensions are evaluated without allocating memory
+static const unsigned kernelStackDim=8;
+
 //+PLUMEDOC INTERNAL kernelfunctions
 /*
 Functions that are used to construct histograms
@@ -130,7 +133,8 @@ KernelFunctions::KernelFunctions( const KernelFunctions* in ):
   ktype(in->ktype),
   center(in->center),
   width(in->width),
-  height(in->height)
+  height(in->height),
+  metric(in->metric)
 {
 }
 
@@ -156,9 +160,25 @@ void KernelFunctions::setData( const std::vector<double>& at, const std::vector<
   } else {
     plumed_merror(type+" is an invalid kernel type\n");
   }
+
+  // Store the full inverse metric so that it is not rebuilt on every evaluation
+  metric.resize(0);
+  if( dtype!=diagonal ) {
+    unsigned ncv=ndim(); metric.resize( ncv*ncv );
+    Matrix<double> mymatrix( getMatrix() );
+    for(unsigned i=0; i<ncv; ++i) for(unsigned j=0; j<ncv; ++j) metric[i*ncv+j]=mymatrix(i,j);
+  }
 }
 
 void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
+  std::vector<double> period( myvals.size(), 0.0 );
+  for(unsigned i=0; i<myvals.size(); ++i) {
+    if( myvals[i]->isPeriodic() ) period[i]=myvals[i]->getMaxMinusMin();
+  }
+  normalize( period );
+}
+
+void KernelFunctions::normalize( const std::vector<double>& period ) {
 
   double det=1.;
   unsigned ncv=ndim();
@@ -200,7 +220,7 @@ void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
   // Now calculate determinant for aperiodic variables
   unsigned naper=0;
   for(unsigned i=0; i<ncv; ++i) {
-    if( !myvals[i]->isPeriodic() ) naper++;
+    if( period[i]==0 ) naper++;
   }
   // Now construct sub matrix
   double volume=1;
@@ -208,10 +228,10 @@ void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
     unsigned isub=0;
     Matrix<double> mymatrix( getMatrix() ), mysub( naper, naper );
     for(unsigned i=0; i<ncv; ++i) {
-      if( myvals[i]->isPeriodic() ) continue;
+      if( period[i]>0 ) continue;
       unsigned jsub=0;
       for(unsigned j=0; j<ncv; ++j) {
-        if( myvals[j]->isPeriodic() ) continue;
+        if( period[j]>0 ) continue;
         mysub( isub, jsub ) = mymatrix( i, j ); jsub++;
       }
       isub++;
@@ -225,7 +245,7 @@ void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
   // Calculate volume of periodic variables
   unsigned nper=0;
   for(unsigned i=0; i<ncv; ++i) {
-    if( myvals[i]->isPeriodic() ) nper++;
+    if( period[i]>0 ) nper++;
   }
 
   // Now construct sub matrix
@@ -233,10 +253,10 @@ void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
     unsigned isub=0;
     Matrix<double> mymatrix( getMatrix() ),  mysub( nper, nper );
     for(unsigned i=0; i<ncv; ++i) {
-      if( !myvals[i]->isPeriodic() ) continue;
+      if( period[i]==0 ) continue;
       unsigned jsub=0;
       for(unsigned j=0; j<ncv; ++j) {
-        if( !myvals[j]->isPeriodic() ) continue;
+        if( period[j]==0 ) continue;
         mysub( isub, jsub ) = mymatrix( i, j ); jsub++;
       }
       isub++;
@@ -246,8 +266,8 @@ void KernelFunctions::normalize( const std::vector<Value*>& myvals ) {
     diagMat( mysub, eigval, eigvec );
     unsigned iper=0; volume=1;
     for(unsigned i=0; i<ncv; ++i) {
-      if( myvals[i]->isPeriodic() ) {
-        volume *= myvals[i]->getMaxMinusMin()*Tools::bessel0(eigval[iper])*std::exp(-eigval[iper]);
+      if( period[i]>0 ) {
+        volume *= period[i]*Tools::bessel0(eigval[iper])*std::exp(-eigval[iper]);
         iper++;
       }
     }
@@ -299,61 +319,115 @@ std::vector<unsigned> KernelFunctions::getSupport( const std::vector<double>& dx
 
 double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<double>& derivatives, bool usederiv, bool doInt, double lowI_, double uppI_) const {
   plumed_dbg_assert( pos.size()==ndim() && derivatives.size()==ndim() );
-#ifndef NDEBUG
-  if( usederiv ) plumed_massert( ktype!=uniform, "step function can not be differentiated" );
-#endif
   if(doInt) {
     plumed_dbg_assert(center.size()==1);
     if(pos[0]->get()<lowI_) pos[0]->set(lowI_);
     if(pos[0]->get()>uppI_) pos[0]->set(uppI_);
   }
+  const unsigned ncv=ndim();
+  double stack[2*kernelStackDim]; std::vector<double> heap;
+  double* xx=stack;
+  if( ncv>kernelStackDim ) { heap.resize(2*ncv); xx=heap.data(); }
+  double* period=xx+ncv;
+  for(unsigned i=0; i<ncv; ++i) {
+    xx[i]=pos[i]->get();
+    period[i]=( pos[i]->isPeriodic() ? pos[i]->getMaxMinusMin() : 0.0 );
+  }
+  return evaluate( xx, period, derivatives.data(), usederiv, doInt, lowI_, uppI_ );
+}
+
+template<unsigned N>
+double KernelFunctions::getSquaredDistance( const double* pos, const double* period, double* derivatives ) const {
+  const unsigned ncv=( N>0 ? N : ndim() );
   double r2=0;
   if(dtype==diagonal) {
-    for(unsigned i=0; i<ndim(); ++i) {
-      derivatives[i]=-pos[i]->difference( center[i] ) / width[i];
+    for(unsigned i=0; i<ncv; ++i) {
+      double dp=center[i]-pos[i];
+      if( period[i]>0 ) dp=Tools::pbc( dp*(1.0/period[i]) )*period[i];
+      derivatives[i]=-dp / width[i];
       r2+=derivatives[i]*derivatives[i];
       derivatives[i] /= width[i];
     }
-  } else if(dtype==multi) {
-    Matrix<double> mymatrix( getMatrix() );
-    for(unsigned i=0; i<mymatrix.nrows(); ++i) {
+  } else {
+    const double* mymatrix=metric.data();
+    for(unsigned i=0; i<ncv; ++i) {
       double dp_i, dp_j; derivatives[i]=0;
-      dp_i=-pos[i]->difference( center[i] );
-      for(unsigned j=0; j<mymatrix.ncols(); ++j) {
+      dp_i=center[i]-pos[i];
+      if( period[i]>0 ) dp_i=Tools::pbc( dp_i*(1.0/period[i]) )*period[i];
+      dp_i=-dp_i;
+      for(unsigned j=0; j<ncv; ++j) {
         if(i==j) dp_j=dp_i;
-        else dp_j=-pos[j]->difference( center[j] );
-
-        derivatives[i]+=mymatrix(i,j)*dp_j;
-        r2+=dp_i*dp_j*mymatrix(i,j);
+        else {
+          dp_j=center[j]-pos[j];
+          if( period[j]>0 ) dp_j=Tools::pbc( dp_j*(1.0/period[j]) )*period[j];
+          dp_j=-dp_j;
+        }
+        derivatives[i]+=mymatrix[i*ncv+j]*dp_j;
+        r2+=dp_i*dp_j*mymatrix[i*ncv+j];
       }
     }
-  } else if(dtype==vonmises) {
-    std::vector<double> costmp( ndim() ), sintmp( ndim() ), sinout( ndim(), 0.0 );
-    for(unsigned i=0; i<ndim(); ++i) {
-      if( pos[i]->isPeriodic() ) {
-        sintmp[i]=sin( 2.*pi*(pos[i]->get() - center[i])/pos[i]->getMaxMinusMin() );
-        costmp[i]=cos( 2.*pi*(pos[i]->get() - center[i])/pos[i]->getMaxMinusMin() );
-      } else {
-        sintmp[i]=pos[i]->get() - center[i];
-        costmp[i]=1.0;
-      }
+  }
+  return r2;
+}
+
+double KernelFunctions::getVonMisesDistance( const double* pos, const double* period, double* derivatives ) const {
+  const unsigned ncv=ndim(); const double* mymatrix=metric.data();
+  double stack[3*kernelStackDim]; std::vector<double> heap;
+  double* costmp=stack;
+  if( ncv>kernelStackDim ) { heap.resize(3*ncv); costmp=heap.data(); }
+  double* sintmp=costmp+ncv; double* sinout=sintmp+ncv;
+  for(unsigned i=0; i<ncv; ++i) sinout[i]=0.0;
+  for(unsigned i=0; i<ncv; ++i) {
+    if( period[i]>0 ) {
+      sintmp[i]=sin( 2.*pi*(pos[i] - center[i])/period[i] );
+      costmp[i]=cos( 2.*pi*(pos[i] - center[i])/period[i] );
+    } else {
+      sintmp[i]=pos[i] - center[i];
+      costmp[i]=1.0;
     }
+  }
 
-    Matrix<double> mymatrix( getMatrix() );
-    for(unsigned i=0; i<mymatrix.nrows(); ++i) {
-      derivatives[i]=0;
-      if( pos[i]->isPeriodic() ) {
-        r2+=2*( 1 - costmp[i] )*mymatrix(i,i);
-      } else {
-        r2+=sintmp[i]*sintmp[i]*mymatrix(i,i);
-      }
-      for(unsigned j=0; j<mymatrix.ncols(); ++j) {
-        if( i!=j ) sinout[i]+=mymatrix(i,j)*sintmp[j];
-      }
-      derivatives[i] = mymatrix(i,i)*sintmp[i] + sinout[i]*costmp[i];
-      if( pos[i]->isPeriodic() ) derivatives[i] *= (2*pi/pos[i]->getMaxMinusMin());
+  double r2=0;
+  for(unsigned i=0; i<ncv; ++i) {
+    derivatives[i]=0;
+    if( period[i]>0 ) {
+      r2+=2*( 1 - costmp[i] )*mymatrix[i*ncv+i];
+    } else {
+      r2+=sintmp[i]*sintmp[i]*mymatrix[i*ncv+i];
+    }
+    for(unsigned j=0; j<ncv; ++j) {
+      if( i!=j ) sinout[i]+=mymatrix[i*ncv+j]*sintmp[j];
+    }
+    derivatives[i] = mymatrix[i*ncv+i]*sintmp[i] + sinout[i]*costmp[i];
+    if( period[i]>0 ) derivatives[i] *= (2*pi/period[i]);
+  }
+  for(unsigned i=0; i<ncv; ++i) r2+=sintmp[i]*sinout[i];
+  return r2;
+}
+
+double KernelFunctions::evaluate( const double* pos, const double* period, double* derivatives, bool usederiv, bool doInt, double lowI_, double uppI_) const {
+#ifndef NDEBUG
+  if( usederiv ) plumed_massert( ktype!=uniform, "step function can not be differentiated" );
+#endif
+  double xx;
+  if(doInt) {
+    plumed_dbg_assert(center.size()==1);
+    xx=pos[0];
+    if(xx<lowI_) xx=lowI_;
+    if(xx>uppI_) xx=uppI_;
+    pos=&xx;
+  }
+  double r2;
+  if(dtype==vonmises) {
+    r2=getVonMisesDistance( pos, period, derivatives );
+  } else {
+    // Low dimensional kernels are by far the most common so the loops are unrolled for them
+    switch( ndim() ) {
+    case 1: r2=getSquaredDistance<1>( pos, period, derivatives ); break;
+    case 2: r2=getSquaredDistance<2>( pos, period, derivatives ); break;
+    case 3: r2=getSquaredDistance<3>( pos, period, derivatives ); break;
+    default: r2=getSquaredDistance<0>( pos, period, derivatives );
     }
-    for(unsigned i=0; i<sinout.size(); ++i) r2+=sintmp[i]*sinout[i];
   }
   double kderiv, kval;
   if(ktype==gaussian || ktype==truncatedgaussian) {
@@ -378,7 +452,7 @@ double KernelFunctions::evaluate( const std::vector<Value*>& pos, std::vector<do
   }
   for(unsigned i=0; i<ndim(); ++i) derivatives[i]*=kderiv;
   if(doInt) {
-    if((pos[0]->get() <= lowI_ || pos[0]->get() >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
+    if((pos[0] <= lowI_ || pos[0] >= uppI_) && usederiv ) for(unsigned i=0; i<ndim(); ++i)derivatives[i]=0;
   }
   return kval;
 }
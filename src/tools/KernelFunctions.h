@@ -41,28 +41,43 @@ private:
   std::vector<double> width;
 /// The height of the kernel
   double height;
+/// The full inverse metric stored row by row (multivariate and von Mises kernels only)
+  std::vector<double> metric;
 /// Used to set all the data in the kernel during construction - avoids double coding as this has two constructors
   void setData( const std::vector<double>& at, const std::vector<double>& sig, const std::string& type, const std::string& mtype, const double& w );
 /// Convert the width into matrix form
   Matrix<double> getMatrix() const;
+/// Compute the squared (metric) distance from the center and its derivatives for diagonal and multivariate kernels.
+/// N is the dimensionality if known at compile time and zero otherwise.
+  template<unsigned N>
+  double getSquaredDistance( const double* pos, const double* period, double* derivatives ) const ;
+/// Compute the squared distance from the center and its derivatives for von Mises kernels
+  double getVonMisesDistance( const double* pos, const double* period, double* derivatives ) const ;
 public:
   explicit KernelFunctions( const std::string& input );
   KernelFunctions( const std::vector<double>& at, const std::vector<double>& sig, const std::string& type, const std::string& mtype, const double& w );
   explicit KernelFunctions( const KernelFunctions* in );
 /// Normalise the function and scale the height accordingly
   void normalize( const std::vector<Value*>& myvals );
+/// Normalise the function given the period of each variable (zero for variables that are not periodic)
+  void normalize( const std::vector<double>& period );
 /// Get the dimensionality of the kernel
   unsigned ndim() const;
 /// Get the cutoff for a kernel
   double getCutoff( const double& width ) const ;
 /// Get the position of the center
   std::vector<double> getCenter() const;
+/// Move the center of the kernel to a new position
+  void setCenter( const double* at );
 /// Get the support
   std::vector<unsigned> getSupport( const std::vector<double>& dx ) const;
 /// get it in continuous form
   std::vector<double> getContinuousSupport( ) const;
 /// Evaluate the kernel function with constant intervals
   double evaluate( const std::vector<Value*>& pos, std::vector<double>& derivatives, bool usederiv=true, bool doInt=false, double lowI_=-1, double uppI_=-1 ) const;
+/// Evaluate the kernel function at the point pos.  period[i] is the length of the domain of
+/// the ith variable if it is periodic and zero otherwise.  derivatives must have room for ndim() numbers.
+  double evaluate( const double* pos, const double* period, double* derivatives, bool usederiv=true, bool doInt=false, double lowI_=-1, double uppI_=-1 ) const;
 /// Read a kernel function from a file
   static std::unique_ptr<KernelFunctions> read( IFile* ifile, const bool& cholesky, const std::vector<std::string>& valnames );
 };
@@ -79,6 +94,11 @@ Matrix<double> KernelFunctions::getMatrix() const {
   return mymatrix;
 }
 
+inline
+void KernelFunctions::setCenter( const double* at ) {
+  for(unsigned i=0; i<center.size(); ++i) center[i]=at[i];
+}
+
 inline
 unsigned KernelFunctions::ndim() const {
   return center.size();
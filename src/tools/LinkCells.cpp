@@ -20,13 +20,12 @@
    along with plumed.  If not, see <http://www.gnu.org/licenses/>.
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 #include "LinkCells.h"
-#include "Communicator.h"
 #include "Tools.h"
+#include "OpenMP.h"
 
 namespace PLMD {
 
-LinkCells::LinkCells( Communicator& cc ) :
-  comm(cc),
+LinkCells::LinkCells() :
   cutoffwasset(false),
   link_cutoff(0.0),
   ncells(3),
@@ -50,11 +49,6 @@ void LinkCells::buildCellLists( const std::vector<Vector>& pos, const std::vecto
   // Setup the pbc object by copying it from action
   mypbc.setBox( pbc.getBox() );
 
-  // Setup the lists
-  if( pos.size()!=allcells.size() ) {
-    allcells.resize( pos.size() ); lcell_lists.resize( pos.size() );
-  }
-
   {
 // This is the reciprocal lattice
 // notice that reciprocal.getRow(0) is a vector that is orthogonal to b and c
@@ -69,25 +63,19 @@ void LinkCells::buildCellLists( const std::vector<Vector>& pos, const std::vecto
   }
   // Setup the strides
   nstride[0]=1; nstride[1]=ncells[0]; nstride[2]=ncells[0]*ncells[1];
-
-  // Setup the storage for link cells
   unsigned ncellstot=ncells[0]*ncells[1]*ncells[2];
-  if( lcell_tots.size()!=ncellstot ) {
-    lcell_tots.resize( ncellstot ); lcell_starts.resize( ncellstot );
-  }
-  // Clear nlcells
-  for(unsigned i=0; i<ncellstot; ++i) lcell_tots[i]=0;
-  // Clear allcells
-  allcells.assign( allcells.size(), 0 );
-
-  // Find out what cell everyone is in
-  unsigned rank=comm.Get_rank(), size=comm.Get_size();
-  for(unsigned i=rank; i<pos.size(); i+=size) {
-    allcells[i]=findCell( pos[i] );
-    lcell_tots[allcells[i]]++;
+
+  // Find out what cell everyone is in.  Positions are replicated on all the nodes
+  // so every node does this for all the atoms and no communication is needed
+  if( allcells.size()!=pos.size() ) {
+    allcells.resize( pos.size() ); lcell_lists.resize( pos.size() );
   }
-  // And gather all this information on every node
-  comm.Sum( allcells ); comm.Sum( lcell_tots );
+  #pragma omp parallel for num_threads(OpenMP::getGoodNumThreads(allcells))
+  for(unsigned i=0; i<pos.size(); ++i) allcells[i]=findCell( pos[i] );
+
+  // Setup the storage for link cells
+  lcell_tots.assign( ncellstot, 0 ); lcell_starts.resize( ncellstot );
+  for(unsigned i=0; i<pos.size(); ++i) lcell_tots[allcells[i]]++;
 
   // Now prepare the link cell lists
   unsigned tot=0;
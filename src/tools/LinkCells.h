@@ -28,14 +28,10 @@
 
 namespace PLMD {
 
-class Communicator;
-
 /// \ingroup TOOLBOX
 /// A class for doing link cells
 class LinkCells {
 private:
-/// Symbolic link to plumed communicator
-  Communicator & comm;
 /// Check that the link cells were set up correctly
   bool cutoffwasset;
 /// The cutoff to use for the sizes of the cells
@@ -56,7 +52,7 @@ private:
   std::vector<unsigned> lcell_lists;
 public:
 ///
-  explicit LinkCells( Communicator& comm );
+  LinkCells();
 /// Have the link cells been enabled
   bool enabled() const ;
 /// Set the value of the cutoff
@@ -65,7 +61,7 @@ public:
   double getCutoff() const ;
 /// Get the total number of link cells
   unsigned getNumberOfCells() const ;
-/// Build the link cell lists
+/// Build the link cell lists. Positions must be the same on all the processes.
   void buildCellLists( const std::vector<Vector>& pos, const std::vector<unsigned>& indices, const Pbc& pbc );
 /// Take three indices and return the index of the corresponding cell
   unsigned convertIndicesToIndex( const unsigned& nx, const unsigned& ny, const unsigned& nz ) const ;
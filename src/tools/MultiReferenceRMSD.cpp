@@ -0,0 +1,153 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "MultiReferenceRMSD.h"
+#include "RMSD.h"
+#include "Exception.h"
+
+namespace PLMD {
+
+MultiReferenceRMSD::MultiReferenceRMSD():
+  natoms(0),
+  nframes(0)
+{
+}
+
+bool MultiReferenceRMSD::compatible( std::vector<RMSD>& rmsds ) {
+  if( rmsds.size()==0 ) return false;
+  std::vector<double> align( rmsds[0].getAlign() );
+  for(unsigned i=0; i<rmsds.size(); ++i) {
+    if( rmsds[i].getMethod()!="OPTIMAL" ) return false;
+    if( rmsds[i].getAlign()!=align || rmsds[i].getDisplace()!=align ) return false;
+  }
+  return true;
+}
+
+void MultiReferenceRMSD::set( std::vector<RMSD>& rmsds ) {
+  plumed_massert( compatible( rmsds ), "reference frames cannot be used in MultiReferenceRMSD" );
+  nframes=rmsds.size(); align=rmsds[0].getAlign(); natoms=align.size();
+  packedref.resize( 3*natoms*nframes ); rr11.resize( nframes );
+  for(unsigned i=0; i<nframes; ++i) {
+    std::vector<Vector> ref( rmsds[i].getReference() ); plumed_assert( ref.size()==natoms );
+    // The reference is stored with its center removed
+    Vector cr; for(unsigned iat=0; iat<natoms; ++iat) cr+=align[iat]*ref[iat];
+    rr11[i]=0;
+    for(unsigned iat=0; iat<natoms; ++iat) {
+      Vector r=ref[iat]-cr; rr11[i]+=align[iat]*modulo2(r);
+      for(unsigned k=0; k<3; ++k) packedref[3*(iat*nframes+i)+k]=r[k];
+    }
+  }
+}
+
+double MultiReferenceRMSD::getRotation( const Tensor& rr01, Tensor& rotation ) {
+// the quaternion matrix (see RMSDCoreData::doCoreCalc)
+  Tensor4d m;
+  m[0][0]=2.0*(-rr01[0][0]-rr01[1][1]-rr01[2][2]);
+  m[1][1]=2.0*(-rr01[0][0]+rr01[1][1]+rr01[2][2]);
+  m[2][2]=2.0*(+rr01[0][0]-rr01[1][1]+rr01[2][2]);
+  m[3][3]=2.0*(+rr01[0][0]+rr01[1][1]-rr01[2][2]);
+  m[0][1]=2.0*(-rr01[1][2]+rr01[2][1]);
+  m[0][2]=2.0*(+rr01[0][2]-rr01[2][0]);
+  m[0][3]=2.0*(-rr01[0][1]+rr01[1][0]);
+  m[1][2]=2.0*(-rr01[0][1]-rr01[1][0]);
+  m[1][3]=2.0*(-rr01[0][2]-rr01[2][0]);
+  m[2][3]=2.0*(-rr01[1][2]-rr01[2][1]);
+  m[1][0] = m[0][1];
+  m[2][0] = m[0][2];
+  m[2][1] = m[1][2];
+  m[3][0] = m[0][3];
+  m[3][1] = m[1][3];
+  m[3][2] = m[2][3];
+
+// only the lowest eigenpair is required here
+  VectorGeneric<1> eigenvals; TensorGeneric<1,4> eigenvecs;
+  RMSD::diagQuaternionMatrix(m, eigenvals, eigenvecs );
+  Vector4d q(eigenvecs[0][0],eigenvecs[0][1],eigenvecs[0][2],eigenvecs[0][3]);
+
+// This is the rotation matrix that brings reference to positions
+  rotation[0][0]=q[0]*q[0]+q[1]*q[1]-q[2]*q[2]-q[3]*q[3];
+  rotation[1][1]=q[0]*q[0]-q[1]*q[1]+q[2]*q[2]-q[3]*q[3];
+  rotation[2][2]=q[0]*q[0]-q[1]*q[1]-q[2]*q[2]+q[3]*q[3];
+  rotation[0][1]=2*(+q[0]*q[3]+q[1]*q[2]);
+  rotation[0][2]=2*(-q[0]*q[2]+q[1]*q[3]);
+  rotation[1][2]=2*(+q[0]*q[1]+q[2]*q[3]);
+  rotation[1][0]=2*(-q[0]*q[3]+q[1]*q[2]);
+  rotation[2][0]=2*(+q[0]*q[2]+q[1]*q[3]);
+  rotation[2][1]=2*(-q[0]*q[1]+q[2]*q[3]);
+  return eigenvals[0];
+}
+
+void MultiReferenceRMSD::calculateRotations( const std::vector<Vector>& positions, const std::vector<unsigned>& frames, Vector& center,
+    std::vector<double>& msd, std::vector<Tensor>& rotations ) const {
+  plumed_dbg_assert( positions.size()==natoms );
+  const unsigned nb=frames.size(); msd.resize( nb ); rotations.resize( nb );
+  if( nb==0 ) return;
+
+// the center of the positions is computed once for all the frames
+  center.zero(); for(unsigned iat=0; iat<natoms; ++iat) center+=align[iat]*positions[iat];
+
+// check if the frames are a contiguous block so that the inner loop can run over contiguous memory
+  bool contiguous=true;
+  for(unsigned k=1; k<nb; ++k) { if( frames[k]!=frames[0]+k ) { contiguous=false; break; } }
+
+// correlation matrices for all the frames.  Element a*3*nb+3*k+b is element a,b of the matrix for frame k
+  std::vector<double> rr01( 9*nb, 0.0 ); double rr00=0;
+  for(unsigned iat=0; iat<natoms; ++iat) {
+    Vector p=positions[iat]-center; rr00+=align[iat]*modulo2(p);
+    Vector wp=align[iat]*p;
+    if( contiguous ) {
+      const double* ref=&packedref[3*(iat*nframes+frames[0])];
+      for(unsigned a=0; a<3; ++a) {
+        double* out=&rr01[3*a*nb]; const double w=wp[a];
+        #pragma omp simd
+        for(unsigned kb=0; kb<3*nb; ++kb) out[kb]+=w*ref[kb];
+      }
+    } else {
+      for(unsigned k=0; k<nb; ++k) {
+        const double* ref=&packedref[3*(iat*nframes+frames[k])];
+        for(unsigned a=0; a<3; ++a) for(unsigned b=0; b<3; ++b) rr01[3*a*nb+3*k+b]+=wp[a]*ref[b];
+      }
+    }
+  }
+
+// and the eigenproblems for all the frames
+  for(unsigned k=0; k<nb; ++k) {
+    Tensor t;
+    for(unsigned a=0; a<3; ++a) for(unsigned b=0; b<3; ++b) t[a][b]=rr01[3*a*nb+3*k+b];
+    msd[k]=getRotation( t, rotations[k] ) + rr00 + rr11[frames[k]];
+  }
+}
+
+double MultiReferenceRMSD::calculateDerivatives( const std::vector<Vector>& positions, const Vector& center, const unsigned& iframe,
+    const Tensor& rotation, std::vector<Vector>& derivatives ) const {
+  plumed_dbg_assert( positions.size()==natoms && iframe<nframes );
+  derivatives.resize( natoms ); double dist=0;
+// As the alignment and displacement weights are equal there is no need for the derivatives of the rotation and shift
+// and the MSD is recomputed from the distances as is done in the safe version of RMSD::calculate
+  for(unsigned iat=0; iat<natoms; ++iat) {
+    const double* ref=&packedref[3*(iat*nframes+iframe)];
+    Vector d=positions[iat]-center-matmul(rotation,Vector(ref[0],ref[1],ref[2]));
+    dist+=align[iat]*modulo2(d); derivatives[iat]=2*align[iat]*d;
+  }
+  return dist;
+}
+
+}
@@ -0,0 +1,94 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_MultiReferenceRMSD_h
+#define __PLUMED_tools_MultiReferenceRMSD_h
+
+#include "Vector.h"
+#include "Tensor.h"
+#include <vector>
+
+namespace PLMD {
+
+class RMSD;
+
+/**
+\ingroup TOOLBOX
+A class for calculating the optimal alignment MSD between one set of positions and many reference frames
+
+Calculating the MSD from a set of reference frames by calling RMSD::calculate for each of them is
+wasteful as the center of the positions is recomputed and the full set of eigenvectors of the quaternion
+matrix (and the derivatives of the rotation) are computed for every frame.  This class stores all the
+reference frames in a single packed array in which the coordinates of each atom in all the frames are contiguous.
+The correlation matrices between the positions and all the frames can thus be computed with a single
+loop over the atoms in which the inner loop is over frames and is vectorized.  The calculation is then
+split in two parts.  calculateRotations() computes the optimal rotations and an estimate of the MSD from the eigenvalue
+of the quaternion matrix for a batch of frames.  calculateDerivatives() then computes the MSD and its derivatives
+with respect to the positions for one frame.  The user can thus avoid computing the derivatives for frames that
+give negligible contributions (e.g. in path collective variables).
+
+This class can only be used when all the frames have the same alignment and displacement weights and when
+these two sets of weights are the same.  Use the static method compatible() to check.
+
+\verbatim
+MultiReferenceRMSD multi; multi.set( rmsds );
+std::vector<unsigned> frames(rmsds.size()); for(unsigned i=0;i<frames.size();++i) frames[i]=i;
+std::vector<double> msd; std::vector<Tensor> rot; Vector center;
+multi.calculateRotations( pos, frames, center, msd, rot );
+for(unsigned i=0;i<frames.size();++i) msd[i]=multi.calculateDerivatives( pos, center, frames[i], rot[i], der );
+\endverbatim
+*/
+
+class MultiReferenceRMSD {
+private:
+/// The number of atoms and the number of frames
+  unsigned natoms, nframes;
+/// The alignment weights (normalized so that they sum to one)
+  std::vector<double> align;
+/// The centered reference positions.  Element (iat*nframes+iframe)*3+k is component k of atom iat in frame iframe
+  std::vector<double> packedref;
+/// The second moments of the reference frames
+  std::vector<double> rr11;
+/// Get the rotation and the lowest eigenvalue of the quaternion matrix from the correlation matrix
+  static double getRotation( const Tensor& rr01, Tensor& rotation );
+public:
+  MultiReferenceRMSD();
+/// Check whether a set of RMSD objects can be computed using this class
+  static bool compatible( std::vector<RMSD>& rmsds );
+/// Set the reference frames from a set of RMSD objects
+  void set( std::vector<RMSD>& rmsds );
+/// Get the number of reference frames
+  unsigned getNumberOfReferences() const ;
+/// Get the center of the positions together with the rotations and the estimated MSD from the eigenvalue for each frame in the list
+  void calculateRotations( const std::vector<Vector>& positions, const std::vector<unsigned>& frames, Vector& center,
+                           std::vector<double>& msd, std::vector<Tensor>& rotations ) const ;
+/// Calculate the MSD from one frame and its derivatives with respect to the positions given the rotation computed by calculateRotations
+  double calculateDerivatives( const std::vector<Vector>& positions, const Vector& center, const unsigned& iframe,
+                               const Tensor& rotation, std::vector<Vector>& derivatives ) const ;
+};
+
+inline
+unsigned MultiReferenceRMSD::getNumberOfReferences() const {
+  return nframes;
+}
+
+}
+#endif
@@ -97,18 +97,22 @@ void NeighborList::update(const vector<Vector>& positions) {
   const double d2=distance_*distance_;
 // check if positions array has the correct length
   plumed_assert(positions.size()==fullatomlist_.size());
-  for(unsigned int i=0; i<nallpairs_; ++i) {
-    pair<unsigned,unsigned> index=getIndexPair(i);
-    unsigned index0=index.first;
-    unsigned index1=index.second;
-    Vector distance;
-    if(do_pbc_) {
-      distance=pbc_->distance(positions[index0],positions[index1]);
-    } else {
-      distance=delta(positions[index0],positions[index1]);
+// distances are computed in blocks, so that PBC are applied to a whole batch
+  const unsigned nb=64;
+  double dx[nb],dy[nb],dz[nb];
+  pair<unsigned,unsigned> index[nb];
+  for(unsigned int ib=0; ib<nallpairs_; ib+=nb) {
+    const unsigned m=(nallpairs_-ib<nb?nallpairs_-ib:nb);
+    for(unsigned k=0; k<m; ++k) {
+      index[k]=getIndexPair(ib+k);
+      Vector distance=delta(positions[index[k].first],positions[index[k].second]);
+      dx[k]=distance[0]; dy[k]=distance[1]; dz[k]=distance[2];
+    }
+    if(do_pbc_) pbc_->apply(dx,dy,dz,m);
+    for(unsigned k=0; k<m; ++k) {
+      double value=dx[k]*dx[k]+dy[k]*dy[k]+dz[k]*dz[k];
+      if(value<=d2) {neighbors_.push_back(index[k]);}
     }
-    double value=modulo2(distance);
-    if(value<=d2) {neighbors_.push_back(index);}
   }
   setRequestList();
 }
@@ -70,6 +70,14 @@ unsigned OpenMP::getThreadNum() {
 #endif
 }
 
+unsigned OpenMP::getTeamSize() {
+#if defined(_OPENMP)
+  return omp_get_num_threads();
+#else
+  return 1;
+#endif
+}
+
 
 
 }
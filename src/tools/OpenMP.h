@@ -39,6 +39,9 @@ public:
 /// Returns a unique thread identification number within the current team
   static unsigned getThreadNum();
 
+/// Returns the number of threads in the current team
+  static unsigned getTeamSize();
+
 /// get cacheline size
   static unsigned getCachelineSize();
 
@@ -0,0 +1,80 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_PackedSymmetricMatrix_h
+#define __PLUMED_tools_PackedSymmetricMatrix_h
+
+#include <vector>
+#include <cstddef>
+#include "Exception.h"
+
+namespace PLMD {
+
+/**
+\ingroup TOOLBOX
+Storage for a symmetric matrix in which only the upper triangle (diagonal included) is kept.
+
+The elements are stored row by row in a single contiguous array so that a matrix
+of size N requires N(N+1)/2 elements rather than N^2.  The template parameter allows
+one to store the elements in single precision when memory is the limiting factor.
+The underlying array can be passed directly to Communicator::Sum so that blocks of the
+matrix computed on different ranks can be merged.
+*/
+
+template <typename T>
+class PackedSymmetricMatrix {
+private:
+/// The size of the matrix
+  unsigned n;
+/// The upper triangle of the matrix stored row by row
+  std::vector<T> data;
+public:
+  PackedSymmetricMatrix() : n(0) {}
+  explicit PackedSymmetricMatrix( const unsigned& nn ) : n(nn), data( getPackedSize(nn) ) {}
+/// Return the number of elements required to store a matrix of size nn
+  static std::size_t getPackedSize( const unsigned& nn ) { return static_cast<std::size_t>(nn)*(nn+1)/2; }
+/// Resize the matrix
+  void resize( const unsigned& nn ) { n=nn; data.resize( getPackedSize(nn) ); }
+/// Get the size of the matrix
+  unsigned size() const { return n; }
+/// Get the index of element i,j in the packed array
+  std::size_t index( const unsigned& i, const unsigned& j ) const ;
+/// Get an element of the matrix
+  T operator()( const unsigned& i, const unsigned& j ) const { return data[index(i,j)]; }
+/// Get a reference to an element of the matrix
+  T& operator()( const unsigned& i, const unsigned& j ) { return data[index(i,j)]; }
+/// Set all the elements of the matrix equal to a value
+  PackedSymmetricMatrix<T>& operator=( const T& v ) { for(unsigned i=0; i<data.size(); ++i) data[i]=v; return *this; }
+/// Get the underlying packed array
+  std::vector<T>& getVector() { return data; }
+  const std::vector<T>& getVector() const { return data; }
+};
+
+template <typename T>
+inline
+std::size_t PackedSymmetricMatrix<T>::index( const unsigned& i, const unsigned& j ) const {
+  plumed_dbg_assert( i<n && j<n );
+  const std::size_t ii=( i<j ? i : j ), jj=( i<j ? j : i );
+  return ii*(2*static_cast<std::size_t>(n)-ii-1)/2 + jj;
+}
+
+}
+#endif
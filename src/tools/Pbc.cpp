@@ -155,25 +155,109 @@ double Pbc::distance( const bool pbc, const Vector& v1, const Vector& v2 ) const
   else { return ( delta(v1,v2) ).modulo(); }
 }
 
-void Pbc::apply(std::vector<Vector>& dlist, unsigned max_index) const {
-  if (max_index==0) max_index=dlist.size();
-  if(type==unset) {
-  } else if(type==orthorombic) {
+/// Size of the blocks in which batched PBC are processed.
+/// Temporary buffers of this size are kept on the stack.
+static const unsigned pbcBatchSize=64;
+
+template<>
+void Pbc::applyBatch<Pbc::unset>(double*,double*,double*,unsigned)const {
+}
+
+template<>
+void Pbc::applyBatch<Pbc::orthorombic>(double*dx,double*dy,double*dz,unsigned n)const {
 #ifdef __PLUMED_PBC_WHILE
-    for(unsigned k=0; k<max_index; ++k) {
-      while(dlist[k][0]>hdiag[0])   dlist[k][0]-=diag[0];
-      while(dlist[k][0]<=mdiag[0])  dlist[k][0]+=diag[0];
-      while(dlist[k][1]>hdiag[1])   dlist[k][1]-=diag[1];
-      while(dlist[k][1]<=mdiag[1])  dlist[k][1]+=diag[1];
-      while(dlist[k][2]>hdiag[2])   dlist[k][2]-=diag[2];
-      while(dlist[k][2]<=mdiag[2])  dlist[k][2]+=diag[2];
-    }
+  for(unsigned k=0; k<n; ++k) {
+    while(dx[k]>hdiag[0])   dx[k]-=diag[0];
+    while(dx[k]<=mdiag[0])  dx[k]+=diag[0];
+    while(dy[k]>hdiag[1])   dy[k]-=diag[1];
+    while(dy[k]<=mdiag[1])  dy[k]+=diag[1];
+    while(dz[k]>hdiag[2])   dz[k]-=diag[2];
+    while(dz[k]<=mdiag[2])  dz[k]+=diag[2];
+  }
 #else
-    for(unsigned k=0; k<max_index; ++k) for(int i=0; i<3; i++) dlist[k][i]=Tools::pbc(dlist[k][i]*invBox(i,i))*box(i,i);
+  const double b0=box(0,0),b1=box(1,1),b2=box(2,2);
+  const double i0=invBox(0,0),i1=invBox(1,1),i2=invBox(2,2);
+  #pragma omp simd
+  for(unsigned k=0; k<n; ++k) {
+    dx[k]=Tools::pbc(dx[k]*i0)*b0;
+    dy[k]=Tools::pbc(dy[k]*i1)*b1;
+    dz[k]=Tools::pbc(dz[k]*i2)*b2;
+  }
 #endif
-  } else if(type==generic) {
-    for(unsigned k=0; k<max_index; ++k) dlist[k]=distance(Vector(0.0,0.0,0.0),dlist[k]);
-  } else plumed_merror("unknown pbc type");
+}
+
+template<>
+void Pbc::applyBatch<Pbc::generic>(double*dx,double*dy,double*dz,unsigned n)const {
+  const double r00=reduced(0,0),r01=reduced(0,1),r02=reduced(0,2);
+  const double r10=reduced(1,0),r11=reduced(1,1),r12=reduced(1,2);
+  const double r20=reduced(2,0),r21=reduced(2,1),r22=reduced(2,2);
+  const double i00=invReduced(0,0),i01=invReduced(0,1),i02=invReduced(0,2);
+  const double i10=invReduced(1,0),i11=invReduced(1,1),i12=invReduced(1,2);
+  const double i20=invReduced(2,0),i21=invReduced(2,1),i22=invReduced(2,2);
+// scaled coordinates of the current block
+  double sx[pbcBatchSize],sy[pbcBatchSize],sz[pbcBatchSize];
+  for(unsigned k0=0; k0<n; k0+=pbcBatchSize) {
+    const unsigned m=(n-k0<pbcBatchSize?n-k0:pbcBatchSize);
+    double*x=dx+k0;
+    double*y=dy+k0;
+    double*z=dz+k0;
+// first pass: bring to -0.5,+0.5 region in scaled coordinates (same as in distance())
+    #pragma omp simd
+    for(unsigned k=0; k<m; ++k) {
+      const double s0=Tools::pbc(x[k]*i00+y[k]*i10+z[k]*i20);
+      const double s1=Tools::pbc(x[k]*i01+y[k]*i11+z[k]*i21);
+      const double s2=Tools::pbc(x[k]*i02+y[k]*i12+z[k]*i22);
+      x[k]=s0*r00+s1*r10+s2*r20;
+      y[k]=s0*r01+s1*r11+s2*r21;
+      z[k]=s0*r02+s1*r12+s2*r22;
+      sx[k]=s0; sy[k]=s1; sz[k]=s2;
+    }
+// second pass: attempt shifts only for the vectors that might need them
+    for(unsigned k=0; k<m; ++k) {
+      if(std::fabs(sx[k])+std::fabs(sy[k])+std::fabs(sz[k])<=0.5) continue;
+      const std::vector<Vector> & myshifts(shifts[(sx[k]>0?1:0)][(sy[k]>0?1:0)][(sz[k]>0?1:0)]);
+      Vector d(x[k],y[k],z[k]);
+      Vector best(d);
+      double lbest(modulo2(best));
+      for(unsigned i=0; i<myshifts.size(); i++) {
+        Vector trial=d+myshifts[i];
+        double ltrial=modulo2(trial);
+        if(ltrial<lbest) {
+          lbest=ltrial;
+          best=trial;
+        }
+      }
+      x[k]=best[0]; y[k]=best[1]; z[k]=best[2];
+    }
+  }
+}
+
+void Pbc::apply(double*dx,double*dy,double*dz,unsigned n) const {
+  if(type==unset) applyBatch<unset>(dx,dy,dz,n);
+  else if(type==orthorombic) applyBatch<orthorombic>(dx,dy,dz,n);
+  else if(type==generic) applyBatch<generic>(dx,dy,dz,n);
+  else plumed_merror("unknown pbc type");
+}
+
+void Pbc::apply(Vector*dlist,unsigned n) const {
+  if(type==unset) return;
+  double dx[pbcBatchSize],dy[pbcBatchSize],dz[pbcBatchSize];
+  for(unsigned k0=0; k0<n; k0+=pbcBatchSize) {
+    const unsigned m=(n-k0<pbcBatchSize?n-k0:pbcBatchSize);
+    Vector*d=dlist+k0;
+    for(unsigned k=0; k<m; ++k) {
+      dx[k]=d[k][0]; dy[k]=d[k][1]; dz[k]=d[k][2];
+    }
+    apply(dx,dy,dz,m);
+    for(unsigned k=0; k<m; ++k) {
+      d[k][0]=dx[k]; d[k][1]=dy[k]; d[k][2]=dz[k];
+    }
+  }
+}
+
+void Pbc::apply(std::vector<Vector>& dlist, unsigned max_index) const {
+  if (max_index==0) max_index=dlist.size();
+  if(max_index>0) apply(&dlist[0],max_index);
 }
 
 Vector Pbc::distance(const Vector&v1,const Vector&v2,int*nshifts)const {
@@ -36,8 +36,10 @@ This class is useful to apply periodic boundary conditions on interatomic
 distances. It stores privately information about reduced lattice vectors
 */
 class Pbc {
+/// Possible types of box
+  enum Type {unset,orthorombic,generic};
 /// Type of box
-  enum {unset,orthorombic,generic} type;
+  Type type;
 /// Box
   Tensor box;
 /// Inverse box
@@ -62,6 +64,11 @@ class Pbc {
 /// depending on the sign of the scaled coordinates representing
 /// a distance vector.
   void buildShifts(std::vector<Vector> shifts[2][2][2])const;
+/// Minimal image of n distance vectors stored as separate arrays of
+/// x, y and z components. The box type is a template argument, so that
+/// the inner loops do not branch on it and can be vectorized.
+  template<Type T>
+  void applyBatch(double*dx,double*dy,double*dz,unsigned n)const;
 public:
 /// Constructor
   Pbc();
@@ -74,6 +81,13 @@ public:
   Vector distance(const Vector&,const Vector&,int*nshifts)const;
 /// Apply PBC to a set of positions or distance vectors
   void apply(std::vector<Vector>&dlist, unsigned max_index=0) const;
+/// Apply PBC to n distance vectors stored contiguously
+  void apply(Vector*dlist, unsigned n) const;
+/// Apply PBC to n distance vectors stored as separate arrays of
+/// x, y and z components (structure of arrays).
+/// The result is the same as calling distance() on each vector,
+/// but the box type is checked only once for the whole batch.
+  void apply(double*dx, double*dy, double*dz, unsigned n) const;
 /// Set the lattice vectors.
 /// b[i][j] is the j-th component of the i-th vector
   void setBox(const Tensor&b);
@@ -24,11 +24,73 @@
 #include "Log.h"
 #include "Exception.h"
 #include <cmath>
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
 #include "Tools.h"
 using namespace std;
 namespace PLMD {
 
+namespace {
+/// Derivatives of the quaternion matrix with respect to the correlation matrix rr01.
+/// They are constant, so they are only built once.
+struct QuaternionMatrixDerivatives {
+  Tensor dm_drr01[4][4];
+  QuaternionMatrixDerivatives() {
+    dm_drr01[0][0] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,-1.0);
+    dm_drr01[1][1] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,+1.0);
+    dm_drr01[2][2] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,+1.0);
+    dm_drr01[3][3] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,-1.0);
+    dm_drr01[0][1] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,+1.0, 0.0);
+    dm_drr01[0][2] = 2.0*Tensor( 0.0, 0.0,+1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
+    dm_drr01[0][3] = 2.0*Tensor( 0.0,-1.0, 0.0, +1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
+    dm_drr01[1][2] = 2.0*Tensor( 0.0,-1.0, 0.0, -1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
+    dm_drr01[1][3] = 2.0*Tensor( 0.0, 0.0,-1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
+    dm_drr01[2][3] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,-1.0, 0.0);
+    dm_drr01[1][0] = dm_drr01[0][1];
+    dm_drr01[2][0] = dm_drr01[0][2];
+    dm_drr01[2][1] = dm_drr01[1][2];
+    dm_drr01[3][0] = dm_drr01[0][3];
+    dm_drr01[3][1] = dm_drr01[1][3];
+    dm_drr01[3][2] = dm_drr01[2][3];
+  }
+};
+
+const QuaternionMatrixDerivatives & getQuaternionMatrixDerivatives() {
+  static QuaternionMatrixDerivatives d;
+  return d;
+}
+
+/// Solver requested with the environment variable PLUMED_RMSD_SOLVER
+bool getUseLapackFromEnvironment() {
+  if(std::getenv("PLUMED_RMSD_SOLVER")) {
+    std::string solver=std::getenv("PLUMED_RMSD_SOLVER");
+    if(solver=="LAPACK") return true;
+    else if(solver=="JACOBI") return false;
+    else plumed_merror("PLUMED_RMSD_SOLVER should be either LAPACK or JACOBI, found "+solver);
+  }
+  return false;
+}
+
+/// Solver set with RMSD::setUseLapack(): -1 means not set, 0 Jacobi, 1 LAPACK
+std::atomic<int> & getForcedSolver() {
+  static std::atomic<int> forced(-1);
+  return forced;
+}
+}
+
+void RMSD::setUseLapack(bool l) {
+  getForcedSolver()=(l?1:0);
+}
+
+bool RMSD::getUseLapack() {
+// thread-safe initialization, the environment is only read once
+  static const bool use_lapack=getUseLapackFromEnvironment();
+  const int forced=getForcedSolver();
+  if(forced>=0) return forced==1;
+  return use_lapack;
+}
+
 RMSD::RMSD() : alignmentMethod(SIMPLE),reference_center_is_calculated(false),reference_center_is_removed(false),positions_center_is_calculated(false),positions_center_is_removed(false) {}
 
 ///
@@ -463,25 +525,7 @@ double RMSD::optimalAlignment(const  std::vector<double>  & align,
   m[3][1] = m[1][3];
   m[3][2] = m[2][3];
 
-  Tensor dm_drr01[4][4];
-  if(!alEqDis) {
-    dm_drr01[0][0] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,-1.0);
-    dm_drr01[1][1] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,+1.0);
-    dm_drr01[2][2] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,+1.0);
-    dm_drr01[3][3] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,-1.0);
-    dm_drr01[0][1] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,+1.0, 0.0);
-    dm_drr01[0][2] = 2.0*Tensor( 0.0, 0.0,+1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
-    dm_drr01[0][3] = 2.0*Tensor( 0.0,-1.0, 0.0, +1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
-    dm_drr01[1][2] = 2.0*Tensor( 0.0,-1.0, 0.0, -1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
-    dm_drr01[1][3] = 2.0*Tensor( 0.0, 0.0,-1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
-    dm_drr01[2][3] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,-1.0, 0.0);
-    dm_drr01[1][0] = dm_drr01[0][1];
-    dm_drr01[2][0] = dm_drr01[0][2];
-    dm_drr01[2][1] = dm_drr01[1][2];
-    dm_drr01[3][0] = dm_drr01[0][3];
-    dm_drr01[3][1] = dm_drr01[1][3];
-    dm_drr01[3][2] = dm_drr01[2][3];
-  }
+  const Tensor (&dm_drr01)[4][4]=getQuaternionMatrixDerivatives().dm_drr01;
 
   double dist=0.0;
   Vector4d q;
@@ -490,7 +534,7 @@ double RMSD::optimalAlignment(const  std::vector<double>  & align,
   if(!alEqDis) {
     Vector4d eigenvals;
     Tensor4d eigenvecs;
-    diagMatSym(m, eigenvals, eigenvecs );
+    diagQuaternionMatrix(m, eigenvals, eigenvecs );
     dist=eigenvals[0]+rr00+rr11;
     q=Vector4d(eigenvecs[0][0],eigenvecs[0][1],eigenvecs[0][2],eigenvecs[0][3]);
     double dq_dm[4][4][4];
@@ -511,7 +555,7 @@ double RMSD::optimalAlignment(const  std::vector<double>  & align,
   } else {
     VectorGeneric<1> eigenvals;
     TensorGeneric<1,4> eigenvecs;
-    diagMatSym(m, eigenvals, eigenvecs );
+    diagQuaternionMatrix(m, eigenvals, eigenvecs );
     dist=eigenvals[0]+rr00+rr11;
     q=Vector4d(eigenvecs[0][0],eigenvecs[0][1],eigenvecs[0][2],eigenvecs[0][3]);
   }
@@ -1000,32 +1044,14 @@ void RMSDCoreData::doCoreCalc(bool safe,bool alEqDis, bool only_rotation) {
   m[3][2] = m[2][3];
 
 
-  Tensor dm_drr01[4][4];
-  if(!alEqDis or !retrieve_only_rotation) {
-    dm_drr01[0][0] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,-1.0);
-    dm_drr01[1][1] = 2.0*Tensor(-1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,+1.0);
-    dm_drr01[2][2] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,-1.0, 0.0,  0.0, 0.0,+1.0);
-    dm_drr01[3][3] = 2.0*Tensor(+1.0, 0.0, 0.0,  0.0,+1.0, 0.0,  0.0, 0.0,-1.0);
-    dm_drr01[0][1] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,+1.0, 0.0);
-    dm_drr01[0][2] = 2.0*Tensor( 0.0, 0.0,+1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
-    dm_drr01[0][3] = 2.0*Tensor( 0.0,-1.0, 0.0, +1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
-    dm_drr01[1][2] = 2.0*Tensor( 0.0,-1.0, 0.0, -1.0, 0.0, 0.0,  0.0, 0.0, 0.0);
-    dm_drr01[1][3] = 2.0*Tensor( 0.0, 0.0,-1.0,  0.0, 0.0, 0.0, -1.0, 0.0, 0.0);
-    dm_drr01[2][3] = 2.0*Tensor( 0.0, 0.0, 0.0,  0.0, 0.0,-1.0,  0.0,-1.0, 0.0);
-    dm_drr01[1][0] = dm_drr01[0][1];
-    dm_drr01[2][0] = dm_drr01[0][2];
-    dm_drr01[2][1] = dm_drr01[1][2];
-    dm_drr01[3][0] = dm_drr01[0][3];
-    dm_drr01[3][1] = dm_drr01[1][3];
-    dm_drr01[3][2] = dm_drr01[2][3];
-  }
+  const Tensor (&dm_drr01)[4][4]=getQuaternionMatrixDerivatives().dm_drr01;
 
 
   Vector4d q;
 
   Tensor dq_drr01[4];
   if(!alEqDis or !only_rotation) {
-    diagMatSym(m, eigenvals, eigenvecs );
+    RMSD::diagQuaternionMatrix(m, eigenvals, eigenvecs );
     q=Vector4d(eigenvecs[0][0],eigenvecs[0][1],eigenvecs[0][2],eigenvecs[0][3]);
     double dq_dm[4][4][4];
     for(unsigned i=0; i<4; i++) for(unsigned j=0; j<4; j++) for(unsigned k=0; k<4; k++) {
@@ -1045,7 +1071,7 @@ void RMSDCoreData::doCoreCalc(bool safe,bool alEqDis, bool only_rotation) {
   } else {
     TensorGeneric<1,4> here_eigenvecs;
     VectorGeneric<1> here_eigenvals;
-    diagMatSym(m, here_eigenvals, here_eigenvecs );
+    RMSD::diagQuaternionMatrix(m, here_eigenvals, here_eigenvecs );
     for(unsigned i=0; i<4; i++) eigenvecs[0][i]=here_eigenvecs[0][i];
     eigenvals[0]=here_eigenvals[0];
     q=Vector4d(eigenvecs[0][0],eigenvecs[0][1],eigenvecs[0][2],eigenvecs[0][3]);
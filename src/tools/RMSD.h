@@ -255,6 +255,16 @@ public:
     t[2][0]=drotdpos[2][0][i][a]; t[2][1]=drotdpos[2][1][i][a]; t[2][2]=drotdpos[2][2][i][a];
     return t;
   };
+/// select the solver for the 4x4 quaternion eigenproblem: LAPACK if true, fixed-size Jacobi otherwise.
+/// The default is Jacobi and can be changed with the environment variable PLUMED_RMSD_SOLVER=LAPACK
+  static void setUseLapack(bool);
+  static bool getUseLapack();
+/// lowest m eigenpairs of the quaternion matrix, computed with the selected solver
+  template<unsigned m>
+  static void diagQuaternionMatrix(const Tensor4d&mat,VectorGeneric<m>&evals,TensorGeneric<m,4>&evec) {
+    if(getUseLapack()) diagMatSym(mat,evals,evec);
+    else diagMatSymJacobi(mat,evals,evec);
+  }
 };
 
 /// this is a class which is needed to share information across the various non-threadsafe routines
@@ -21,18 +21,59 @@
 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
 
 #include "Stopwatch.h"
+#include "StopwatchTrace.h"
 #include "Exception.h"
 #include "Log.h"
 
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <vector>
 #include <algorithm>
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 using namespace std;
 
 namespace PLMD {
 
+/// Histograms of the cycles use 8 logarithmically spaced bins for each power of two,
+/// so that percentiles are obtained with a relative error below 7%
+static const unsigned histogramSubBins=8;
+static const unsigned histogramBins=histogramSubBins*61;
+
+/// Bin of the histogram where a duration in ns is accumulated
+static unsigned histogramBin(long long ns) {
+  if(ns<(long long)histogramSubBins) return ns>0?ns:0;
+  unsigned e=0;
+  while((ns>>e)>=(long long)(2*histogramSubBins)) e++;
+// here ns>>e is in [histogramSubBins,2*histogramSubBins)
+  return std::min<unsigned>((e+1)*histogramSubBins+(ns>>e)-histogramSubBins,histogramBins-1);
+}
+
+/// Central value of a bin of the histogram, in ns
+static double histogramValue(unsigned bin) {
+  if(bin<histogramSubBins) return bin;
+  unsigned e=bin/histogramSubBins-1;
+  double lower=double((bin%histogramSubBins+histogramSubBins)*(1LL<<e));
+  return lower+0.5*(1LL<<e);
+}
+
+/// Value below which a fraction p of the cycles falls
+static double histogramPercentile(const std::vector<unsigned>&histogram,unsigned cycles,double p) {
+  unsigned long long cumulative=0;
+  for(unsigned i=0; i<histogram.size(); i++) {
+    cumulative+=histogram[i];
+    if(cumulative>=p*cycles) return histogramValue(i);
+  }
+  return 0.0;
+}
+
 // this is needed for friend operators
 std::ostream& operator<<(std::ostream&os,const Stopwatch&sw) {
   return sw.log(os);
@@ -48,6 +89,93 @@ Stopwatch::~Stopwatch() {
     }
     *mylog << *this;
   }
+  closeCounters();
+}
+
+void Stopwatch::updateInstrumented() {
+  instrumented=histograms || counterFd[0]>=0 || trace;
+}
+
+void Stopwatch::enableHistograms(bool on) {
+  histograms=on;
+  updateInstrumented();
+}
+
+bool Stopwatch::enableCounters(bool on) {
+  closeCounters();
+  if(on) {
+#ifdef __linux__
+    const unsigned long long config[3]= {PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,PERF_COUNT_HW_CACHE_MISSES};
+    for(unsigned i=0; i<counterFd.size(); i++) {
+      perf_event_attr pe;
+      std::memset(&pe,0,sizeof(pe));
+      pe.type=PERF_TYPE_HARDWARE;
+      pe.size=sizeof(pe);
+      pe.config=config[i];
+      pe.disabled=(i==0);
+      pe.exclude_kernel=1;
+      pe.exclude_hv=1;
+      pe.read_format=PERF_FORMAT_GROUP;
+      counterFd[i]=syscall(__NR_perf_event_open,&pe,0,-1,counterFd[0],0);
+      if(counterFd[i]<0) {
+        closeCounters();
+        break;
+      }
+    }
+    if(counterFd[0]>=0) {
+      ioctl(counterFd[0],PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+      ioctl(counterFd[0],PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+    }
+#endif
+  }
+  updateInstrumented();
+  return on==(counterFd[0]>=0);
+}
+
+void Stopwatch::closeCounters() {
+#ifdef __linux__
+  for(auto & fd : counterFd) {
+    if(fd>=0) close(fd);
+    fd=-1;
+  }
+#endif
+  updateInstrumented();
+}
+
+void Stopwatch::readCounters(std::array<long long,3>&values)const {
+#ifdef __linux__
+  struct {
+    unsigned long long nr;
+    unsigned long long values[3];
+  } data;
+  if(read(counterFd[0],&data,sizeof(data))==(ssize_t)sizeof(data)) {
+    for(unsigned i=0; i<values.size(); i++) values[i]=data.values[i];
+  }
+#endif
+}
+
+void Stopwatch::setTrace(const std::shared_ptr<StopwatchTrace>&t,const std::string&prefix) {
+  trace=t;
+  tracePrefix=prefix;
+  updateInstrumented();
+}
+
+void Stopwatch::instrumentStart(Watch&w) {
+  if(counterFd[0]>=0) readCounters(w.countersStart);
+}
+
+void Stopwatch::instrumentPause(Watch&w,long long duration) {
+  if(counterFd[0]>=0) {
+    std::array<long long,3> now(w.countersStart);
+    readCounters(now);
+    for(unsigned i=0; i<now.size(); i++) w.counters[i]+=now[i]-w.countersStart[i];
+  }
+  if(trace && w.name->length()>0) trace->add(tracePrefix,*w.name,w.lastStart,duration);
+}
+
+void Stopwatch::instrumentStop(Watch&w,long long lap) {
+  if(w.histogram.empty()) w.histogram.assign(histogramBins,0);
+  w.histogram[histogramBin(lap)]++;
 }
 
 std::ostream& Stopwatch::log(std::ostream&os)const {
@@ -69,6 +197,37 @@ std::ostream& Stopwatch::log(std::ostream&os)const {
     std::sprintf(buffer,"%12u %12.6f %12.6f %12.6f %12.6f\n", t.cycles, frac*t.total, frac*t.total/t.cycles, frac*t.min,frac*t.max);
     os<<buffer;
   }
+
+  if(histograms) {
+    os<<"\n";
+    for(unsigned i=0; i<40; i++) os<<" ";
+    os<<"      Cycles       Median          P90          P99\n";
+    for(const auto & name : names) {
+      const Watch&t(watches.find(name)->second);
+      if(t.histogram.empty()) continue;
+      os<<name;
+      for(unsigned i=name.length(); i<40; i++) os<<" ";
+      std::sprintf(buffer,"%12u %12.6f %12.6f %12.6f\n", t.cycles,
+                   frac*histogramPercentile(t.histogram,t.cycles,0.5),
+                   frac*histogramPercentile(t.histogram,t.cycles,0.9),
+                   frac*histogramPercentile(t.histogram,t.cycles,0.99));
+      os<<buffer;
+    }
+  }
+
+  if(counterFd[0]>=0) {
+    os<<"\n";
+    for(unsigned i=0; i<40; i++) os<<" ";
+    os<<"          CPU-cycles        Instructions      IPC        Cache-misses\n";
+    for(const auto & name : names) {
+      const Watch&t(watches.find(name)->second);
+      os<<name;
+      for(unsigned i=name.length(); i<40; i++) os<<" ";
+      std::sprintf(buffer,"%20lld %19lld %8.3f %19lld\n", t.counters[0], t.counters[1],
+                   (t.counters[0]>0?double(t.counters[1])/t.counters[0]:0.0), t.counters[2]);
+      os<<buffer;
+    }
+  }
   return os;
 }
 
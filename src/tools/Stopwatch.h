@@ -27,6 +27,9 @@
 #include <unordered_map>
 #include <iosfwd>
 #include <chrono>
+#include <array>
+#include <memory>
+#include <vector>
 
 namespace PLMD {
 
@@ -161,9 +164,23 @@ Finally, notice that in order to write the timers on an output file when the
 Stopwatch is destroyed, one can store a reference to a PLMD::Log by passing it
 to the Stopwatch constructor.
 This will make sure timers are written also in case of a premature end.
+
+Averages can hide jitter. For this reason three optional kinds of
+instrumentation are available, all of them switched off by default:
+- enableHistograms() keeps a histogram of the duration of the cycles of each watch
+  so that the median, 90th and 99th percentiles are also logged;
+- enableCounters() reads hardware counters (cycles, instructions and cache misses)
+  through perf_event (Linux only) every time a watch is started or paused, and logs their
+  totals per watch. Counters refer to the thread that starts the watch;
+- setTrace() writes every started/paused interval on a StopwatchTrace that can
+  be visualized as a time line.
+
+When none of them is active the cost of a start/pause is unchanged, apart from
+a single test on a flag.
 */
 
 class Log;
+class StopwatchTrace;
 
 class Stopwatch {
 /// Simple function returning an empty string.
@@ -224,6 +241,16 @@ public:
     enum class State {started, stopped, paused};
 /// keep track of state
     State state = State::stopped;
+/// Stopwatch containing this watch, needed for the optional instrumentation
+    Stopwatch* owner = nullptr;
+/// Name of this watch, pointing to the key stored in the Stopwatch
+    const std::string* name = nullptr;
+/// Hardware counters accumulated so far
+    std::array<long long,3> counters {{0,0,0}};
+/// Hardware counters when the watch was started
+    std::array<long long,3> countersStart {{0,0,0}};
+/// Histogram of the duration of the cycles, only allocated if histograms are enabled
+    std::vector<unsigned> histogram;
 /// Allows access to internal data
     friend class Stopwatch;
   public:
@@ -245,6 +272,33 @@ private:
 /// If set, the stopwatch is logged in its destructor.
   Log*mylog=nullptr;
 
+/// True if any instrumentation (histograms, counters, trace) is active.
+/// This is the only thing checked when starting and pausing watches
+  bool instrumented=false;
+/// True if histograms of the cycles are collected
+  bool histograms=false;
+/// File descriptors of the perf_event counters, the first is the group leader
+  std::array<int,3> counterFd {{-1,-1,-1}};
+/// Trace where intervals are written
+  std::shared_ptr<StopwatchTrace> trace;
+/// Prefix added to the names of the watches in the trace
+  std::string tracePrefix;
+
+/// Get a watch, creating it if needed
+  Watch& getWatch(const std::string&name);
+/// Update instrumented flag
+  void updateInstrumented();
+/// Read the hardware counters
+  void readCounters(std::array<long long,3>&)const;
+/// Called when a watch which is not running is started
+  void instrumentStart(Watch&);
+/// Called when a watch is paused, duration is the length of the interval in ns
+  void instrumentPause(Watch&,long long duration);
+/// Called when a cycle of a watch is completed, lap is its duration in ns
+  void instrumentStop(Watch&,long long lap);
+/// Close hardware counters
+  void closeCounters();
+
 /// List of watches.
 /// Each watch is labeled with a string.
   std::unordered_map<std::string,Watch> watches;
@@ -262,6 +316,25 @@ public:
   Stopwatch(Log&log): mylog(&log) {}
 // Destructor.
   ~Stopwatch();
+/// Stopwatch cannot be copied, since watches point back to it
+  Stopwatch(const Stopwatch&) = delete;
+/// Stopwatch cannot be copied, since watches point back to it
+  Stopwatch& operator=(const Stopwatch&) = delete;
+/// Switch on/off histograms of the duration of the cycles of each watch
+  void enableHistograms(bool);
+/// Switch on/off hardware counters.
+/// Returns false if counters cannot be used on this system, in which case
+/// they stay switched off
+  bool enableCounters(bool);
+/// Write all the intervals on a trace.
+/// prefix is prepended to the name of the watches, and can be used to distinguish
+/// different Stopwatch objects writing on the same trace. The unnamed watch is not traced.
+/// Pass a null pointer to stop tracing
+  void setTrace(const std::shared_ptr<StopwatchTrace>&,const std::string&prefix=emptyString());
+/// Get the trace set with setTrace()
+  const std::shared_ptr<StopwatchTrace>& getTrace()const {
+    return trace;
+  }
 /// Start timer named "name"
   Stopwatch& start(const std::string&name=emptyString());
 /// Stop timer named "name"
@@ -298,32 +371,42 @@ Stopwatch::Handler::~Handler() {
   }
 }
 
+inline
+Stopwatch::Watch& Stopwatch::getWatch(const std::string & name) {
+  Watch & w(watches[name]);
+  if(!w.owner) {
+    w.owner=this;
+    w.name=&watches.find(name)->first;
+  }
+  return w;
+}
+
 inline
 Stopwatch& Stopwatch::start(const std::string & name) {
-  watches[name].start();
+  getWatch(name).start();
   return *this;
 }
 
 inline
 Stopwatch& Stopwatch::stop(const std::string & name) {
-  watches[name].stop();
+  getWatch(name).stop();
   return *this;
 }
 
 inline
 Stopwatch& Stopwatch::pause(const std::string & name) {
-  watches[name].pause();
+  getWatch(name).pause();
   return *this;
 }
 
 inline
 Stopwatch::Handler Stopwatch::startStop(const std::string&name) {
-  return watches[name].startStop();
+  return getWatch(name).startStop();
 }
 
 inline
 Stopwatch::Handler Stopwatch::startPause(const std::string&name) {
-  return watches[name].startPause();
+  return getWatch(name).startPause();
 }
 
 inline
@@ -353,6 +436,7 @@ Stopwatch::Handler & Stopwatch::Handler::operator=(Handler && handler) noexcept
 inline
 Stopwatch::Watch & Stopwatch::Watch::start() {
   state=State::started;
+  if(running==0 && owner && owner->instrumented) owner->instrumentStart(*this);
   running++;
   lastStart=std::chrono::high_resolution_clock::now();
   return *this;
@@ -366,6 +450,7 @@ Stopwatch::Watch & Stopwatch::Watch::stop() {
   total+=lap;
   if(lap>max)max=lap;
   if(min>lap || cycles==1)min=lap;
+  if(owner && owner->histograms) owner->instrumentStop(*this,lap);
   lap=0;
   return *this;
 }
@@ -383,6 +468,7 @@ Stopwatch::Watch & Stopwatch::Watch::pause() {
   if(running!=0) return *this;
   auto t=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now()-lastStart);
   lap+=t.count();
+  if(owner && owner->instrumented) owner->instrumentPause(*this,t.count());
   return *this;
 }
 
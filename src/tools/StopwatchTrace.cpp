@@ -0,0 +1,71 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#include "StopwatchTrace.h"
+#include "core/PlumedMain.h"
+
+#include <cstdio>
+
+namespace PLMD {
+
+/// Escape characters that are not allowed in a JSON string
+static std::string jsonEscape(const std::string&s) {
+  std::string r;
+  for(const auto c : s) {
+    if(c=='"' || c=='\\') r+='\\';
+    r+=c;
+  }
+  return r;
+}
+
+StopwatchTrace::StopwatchTrace():
+  origin(std::chrono::high_resolution_clock::now())
+{
+}
+
+StopwatchTrace::~StopwatchTrace() {
+  if(ofile.isOpen()) ofile<<"]}\n";
+}
+
+StopwatchTrace& StopwatchTrace::link(PlumedMain&plumed) {
+  ofile.link(plumed);
+  return *this;
+}
+
+StopwatchTrace& StopwatchTrace::open(const std::string&path) {
+  ofile.open(path);
+  ofile<<"{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+  ofile<<"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"PLUMED\"}}\n";
+  nevents=1;
+  return *this;
+}
+
+void StopwatchTrace::add(const std::string&prefix,const std::string&name,
+                         const std::chrono::time_point<std::chrono::high_resolution_clock>&start,long long duration) {
+  if(!ofile.isOpen()) return;
+  const double ts=std::chrono::duration_cast<std::chrono::nanoseconds>(start-origin).count()/1000.0;
+  char buffer[128];
+  std::snprintf(buffer,sizeof(buffer),"\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}\n",ts,duration/1000.0);
+  ofile<<(nevents>0?",":"")<<"{\"name\":\""<<jsonEscape(prefix+name)<<buffer;
+  nevents++;
+}
+
+}
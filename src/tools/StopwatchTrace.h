@@ -0,0 +1,76 @@
+/* +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
+   Copyright (c) 2019 The plumed team
+   (see the PEOPLE file at the root of the distribution for a list of names)
+
+   See http://www.plumed.org for more information.
+
+   This file is part of plumed, version 2.
+
+   plumed is free software: you can redistribute it and/or modify
+   it under the terms of the GNU Lesser General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   plumed is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU Lesser General Public License for more details.
+
+   You should have received a copy of the GNU Lesser General Public License
+   along with plumed.  If not, see <http://www.gnu.org/licenses/>.
++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++ */
+#ifndef __PLUMED_tools_StopwatchTrace_h
+#define __PLUMED_tools_StopwatchTrace_h
+
+#include "OFile.h"
+#include <chrono>
+#include <string>
+
+namespace PLMD {
+
+class PlumedMain;
+
+/**
+\ingroup TOOLBOX
+Trace of the intervals measured by one or more Stopwatch objects.
+
+Every time a watch of a Stopwatch connected with Stopwatch::setTrace()
+is paused or stopped, the interval since it was started is written on
+a file in the Chrome trace event format. The file can be opened with
+chrome://tracing or with the Perfetto UI (https://ui.perfetto.dev), where
+the nested intervals are shown as a flame graph on a time line. This allows
+individual slow steps to be seen, which are hidden in the averages
+reported by Stopwatch.
+
+Events are written as soon as they are produced, so that memory usage does
+not grow with the length of the simulation.
+
+\verbatim
+auto trace=std::make_shared<StopwatchTrace>();
+trace->link(plumed).open("trace.json");
+sw.setTrace(trace);
+\endverbatim
+*/
+class StopwatchTrace {
+/// Output file
+  OFile ofile;
+/// Origin of the time axis
+  std::chrono::time_point<std::chrono::high_resolution_clock> origin;
+/// Number of events written so far
+  unsigned long nevents=0;
+public:
+  StopwatchTrace();
+/// Closes the list of events so that the file is valid JSON
+  ~StopwatchTrace();
+/// Link the output file to a PlumedMain object, so that suffixes and backups are handled
+  StopwatchTrace& link(PlumedMain&);
+/// Open the output file and write the header
+  StopwatchTrace& open(const std::string&path);
+/// Write an interval named prefix+name that began at start and lasted duration ns
+  void add(const std::string&prefix,const std::string&name,
+           const std::chrono::time_point<std::chrono::high_resolution_clock>&start,long long duration);
+};
+
+}
+
+#endif
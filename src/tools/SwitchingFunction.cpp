@@ -25,6 +25,8 @@
 #include "OpenMP.h"
 #include <vector>
 #include <limits>
+#include <algorithm>
+#include <cmath>
 
 #define PI 3.14159265358979323846
 
@@ -169,6 +171,17 @@ removed in the future. Similarly, the STRETCH keyword is still allowed but has n
 Notice that switching functions defined with the simplified syntax are never stretched
 for backward compatibility. This might change in the future.
 
+When D_MAX is given, any of the switching functions above can also be tabulated with the TABLE
+keyword, which sets the number of intervals of the table:
+\verbatim
+KEYWORD={CUSTOM FUNC=1/(1+x2^3) R_0=0.3 D_MAX=1.0 TABLE=2000}
+\endverbatim
+The function is then interpolated with cubic Hermite polynomials in \f$r^2\f$ between 0 and \f$d_{max}^2\f$,
+so that value and derivative are obtained with a single lookup and no square root.
+This is useful for CUSTOM functions and for RATIONAL functions with large exponents,
+which are otherwise expensive to compute.
+The largest errors of the table on the function and on its derivative are reported in the log.
+
 */
 //+ENDPLUMEDOC
 
@@ -180,6 +193,7 @@ void SwitchingFunction::registerKeywords( Keywords& keys ) {
   keys.add("compulsory","MM","0","the value of m in the switching function (only needed for TYPE=RATIONAL); 0 implies 2*NN");
   keys.add("compulsory","A","the value of a in the switching funciton (only needed for TYPE=SMAP)");
   keys.add("compulsory","B","the value of b in the switching funciton (only needed for TYPE=SMAP)");
+  keys.add("optional","TABLE","the number of intervals used to tabulate the switching function (requires D_MAX)");
 }
 
 void SwitchingFunction::set(const std::string & definition,std::string& errormsg) {
@@ -197,6 +211,7 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
   dmax_2=std::numeric_limits<double>::max();
   stretch=1.0;
   shift=0.0;
+  table.clear();
   init=true;
 
   bool present;
@@ -213,6 +228,10 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
   bool dontstretch=false;
   Tools::parseFlag(data,"NOSTRETCH",dontstretch); // this is ignored now
   if(dontstretch) dostretch=false;
+  unsigned ntable=0;
+  present=Tools::findKeyword(data,"TABLE");
+  if(present && !Tools::parse(data,"TABLE",ntable)) errormsg="could not parse TABLE";
+  if(ntable>0 && dmax==std::numeric_limits<double>::max()) errormsg="TABLE requires D_MAX";
   double r0;
   if(name=="CUBIC") {
     r0 = dmax - d0;
@@ -314,6 +333,49 @@ void SwitchingFunction::set(const std::string & definition,std::string& errormsg
   }
   plumed_assert(!(leptonx2 && d0!=0.0)) << "You cannot use lepton x2 optimization with d0!=0.0 (d0=" << d0 <<")\n"
                                         << "Please rewrite your function using x as a variable";
+  if(ntable>0 && errormsg.empty()) setupTable(ntable);
+}
+
+void SwitchingFunction::setupTable(unsigned n) {
+  plumed_massert(dmax_2<std::numeric_limits<double>::max(),"a finite D_MAX is needed to tabulate a switching function");
+  plumed_massert(n>0,"a table needs at least one interval");
+  table.clear();
+  const double dx=dmax_2/n;
+// exact values at the knots, derivatives with respect to the squared distance
+  std::vector<double> f(n+1),df(n+1);
+  for(unsigned i=0; i<=n; i++) {
+    double dfunc;
+    f[i]=calculateSqr(i*dx,dfunc);
+    df[i]=0.5*dfunc;
+  }
+// cubic Hermite polynomial on each interval, in powers of the reduced coordinate t in [0,1]
+  std::vector<double> coeff(4*n);
+  for(unsigned i=0; i<n; i++) {
+    const double m0=dx*df[i];
+    const double m1=dx*df[i+1];
+    coeff[4*i]=f[i];
+    coeff[4*i+1]=m0;
+    coeff[4*i+2]=3.0*(f[i+1]-f[i])-2.0*m0-m1;
+    coeff[4*i+3]=2.0*(f[i]-f[i+1])+m0+m1;
+  }
+// exact values inside each interval, to estimate the errors of the table
+  std::vector<double> points(3*n),exact(3*n),exact_deriv(3*n);
+  for(unsigned i=0; i<points.size(); i++) {
+    points[i]=(i/3+0.25*(i%3+1))*dx;
+    exact[i]=calculateSqr(points[i],exact_deriv[i]);
+  }
+  table.swap(coeff);
+  table_n=n;
+  table_invdx=1.0/dx;
+// derivatives are compared as ds/dr
+  table_error=0.0;
+  table_error_deriv=0.0;
+  for(unsigned i=0; i<points.size(); i++) {
+    double dfunc;
+    const double value=calculateSqr(points[i],dfunc);
+    table_error=std::max(table_error,std::fabs(value-exact[i]));
+    table_error_deriv=std::max(table_error_deriv,std::fabs(dfunc-exact_deriv[i])*std::sqrt(points[i]));
+  }
 }
 
 std::string SwitchingFunction::description() const {
@@ -353,6 +415,10 @@ std::string SwitchingFunction::description() const {
     ostr<<" func="<<lepton_func;
 
   }
+  if(!table.empty()) {
+    ostr<<" tabulated with "<<table_n<<" intervals up to dmax="<<dmax
+        <<" (max error "<<table_error<<" on the function and "<<table_error_deriv<<" on its derivative)";
+  }
   return ostr.str();
 }
 
@@ -382,7 +448,20 @@ double SwitchingFunction::do_rational(double rdist,double&dfunc,int nn,int mm)co
 }
 
 double SwitchingFunction::calculateSqr(double distance2,double&dfunc)const {
-  if(fastrational) {
+  if(!table.empty()) {
+    if(distance2>=dmax_2) {
+      dfunc=0.0;
+      return 0.0;
+    }
+    const double s=distance2*table_invdx;
+    unsigned i=static_cast<unsigned>(s);
+// rounding might give the last knot
+    if(i>=table_n) i=table_n-1;
+    const double t=s-i;
+    const double* c=&table[4*i];
+    dfunc=2.0*table_invdx*(c[1]+t*(2.0*c[2]+t*3.0*c[3]));
+    return c[0]+t*(c[1]+t*(c[2]+t*c[3]));
+  } else if(fastrational) {
     if(distance2>dmax_2) {
       dfunc=0.0;
       return 0.0;
@@ -427,7 +506,8 @@ double SwitchingFunction::calculate(double distance,double&dfunc)const {
   }
 // in this case, the lepton object stores only the calculateSqr function
 // so we have to implement calculate in terms of calculateSqr
-  if(leptonx2) {
+// (same for tabulated functions, whose table is in the squared distance)
+  if(leptonx2 || !table.empty()) {
     return calculateSqr(distance*distance,dfunc);
   }
   const double rdist = (distance-d0)*invr0;
@@ -502,6 +582,7 @@ double SwitchingFunction::calculate(double distance,double&dfunc)const {
 void SwitchingFunction::set(int nn,int mm,double r0,double d0) {
   init=true;
   type=rational;
+  table.clear();
   if(mm==0) mm=2*nn;
   this->nn=nn;
   this->mm=mm;
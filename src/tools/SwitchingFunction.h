@@ -87,6 +87,18 @@ class SwitchingFunction {
   bool fastrational=false;
 /// Set to true if lepton only uses x2
   bool leptonx2=false;
+/// Coefficients of the cubic polynomials used in tabulated mode.
+/// Four coefficients per interval in the squared distance, empty if not tabulated
+  std::vector<double> table;
+/// Number of intervals of the table
+  unsigned table_n=0;
+/// Inverse of the width of the intervals of the table
+  double table_invdx=0.0;
+/// Largest errors of the table on the function and on its derivative
+  double table_error=0.0;
+  double table_error_deriv=0.0;
+/// Build a cubic Hermite table in the squared distance with n intervals up to dmax
+  void setupTable(unsigned n);
 public:
   static void registerKeywords( Keywords& keys );
 /// Set a "rational" switching function.
@@ -110,6 +122,10 @@ public:
 /// The advantage is that in some case the expensive square root can be avoided
 /// (namely for rational functions, if nn and mm are even and d0 is zero)
   double calculateSqr(double distance2,double&dfunc)const;
+/// Returns true if the function is evaluated from a table
+  bool isTabulated() const {
+    return !table.empty();
+  }
 /// Returns d0
   double get_d0() const;
 /// Returns r0
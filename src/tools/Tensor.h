@@ -28,6 +28,8 @@
 #include "Exception.h"
 
 #include <array>
+#include <cmath>
+#include <utility>
 
 namespace PLMD {
 
@@ -561,6 +563,61 @@ void diagMatSym(const TensorGeneric<n,n>&mat,VectorGeneric<m>&evals,TensorGeneri
   }
 }
 
+/// Same as diagMatSym, but using cyclic Jacobi rotations instead of LAPACK.
+/// Meant for very small matrices (e.g. the 4x4 quaternion matrix in RMSD)
+/// where the overhead of dsyevr dominates. Eigenvalues are sorted in ascending
+/// order and eigenvectors follow the same phase convention as diagMatSym.
+template<unsigned n,unsigned m>
+void diagMatSymJacobi(const TensorGeneric<n,n>&mat,VectorGeneric<m>&evals,TensorGeneric<m,n>&evec) {
+  static_assert(m<=n,"cannot compute more eigenvalues than the matrix size");
+  TensorGeneric<n,n> a(mat);
+  // v(k,i) is the i-th component of the k-th eigenvector
+  TensorGeneric<n,n> v(TensorGeneric<n,n>::identity());
+  double norm=0.0;
+  for(unsigned i=0; i<n; i++) for(unsigned j=0; j<n; j++) norm+=a(i,j)*a(i,j);
+  for(unsigned sweep=0; sweep<64; sweep++) {
+    double off=0.0;
+    for(unsigned i=0; i<n; i++) for(unsigned j=i+1; j<n; j++) off+=a(i,j)*a(i,j);
+    if(off<=1e-32*norm) break;
+    for(unsigned p=0; p<n; p++) for(unsigned q=p+1; q<n; q++) {
+        if(a(p,q)==0.0) continue;
+        // rotation angle chosen so that a(p,q) becomes zero (Numerical Recipes, sec 11.1)
+        double theta=(a(q,q)-a(p,p))/(2.0*a(p,q));
+        double t=1.0/(std::fabs(theta)+std::sqrt(theta*theta+1.0));
+        if(theta<0.0) t=-t;
+        double c=1.0/std::sqrt(t*t+1.0), s=t*c;
+        for(unsigned k=0; k<n; k++) {
+          double akp=a(k,p), akq=a(k,q);
+          a(k,p)=c*akp-s*akq; a(k,q)=s*akp+c*akq;
+        }
+        for(unsigned k=0; k<n; k++) {
+          double apk=a(p,k), aqk=a(q,k);
+          a(p,k)=c*apk-s*aqk; a(q,k)=s*apk+c*aqk;
+        }
+        for(unsigned k=0; k<n; k++) {
+          double vpk=v(p,k), vqk=v(q,k);
+          v(p,k)=c*vpk-s*vqk; v(q,k)=s*vpk+c*vqk;
+        }
+      }
+  }
+  // selection sort of the eigenpairs, only the lowest m are needed
+  std::array<unsigned,n> order;
+  for(unsigned i=0; i<n; i++) order[i]=i;
+  for(unsigned i=0; i<m; i++) {
+    unsigned jmin=i;
+    for(unsigned j=i+1; j<n; j++) if(a(order[j],order[j])<a(order[jmin],order[jmin])) jmin=j;
+    std::swap(order[i],order[jmin]);
+    evals[i]=a(order[i],order[i]);
+    for(unsigned j=0; j<n; j++) evec(i,j)=v(order[i],j);
+  }
+  // same phase convention as diagMatSym
+  for(unsigned i=0; i<m; ++i) {
+    unsigned j=0;
+    for(j=0; j<n; j++) if(evec(i,j)*evec(i,j)>1e-14) break;
+    if(j<n) if(evec(i,j)<0.0) for(j=0; j<n; j++) evec(i,j)*=-1;
+  }
+}
+
 
 }
 
@@ -30,6 +30,7 @@
 #include "StoreDataVessel.h"
 #include "tools/OpenMP.h"
 #include "tools/Stopwatch.h"
+#include "core/PlumedMain.h"
 
 using namespace std;
 namespace PLMD {
@@ -266,10 +267,14 @@ void ActionWithVessel::runAllTasks() {
   unsigned rank=comm.Get_rank();
   if(serial) { stride=1; rank=0; }
 
+  // The different parts are also timed when a trace of the timers is written
+  if(!stopwatch.getTrace() && plumed.getStopwatch().getTrace()) stopwatch.setTrace(plumed.getStopwatch().getTrace(),getLabel()+" ");
+  const bool timing=timers || stopwatch.getTrace();
+
   // Make sure jobs are done
-  if(timers) stopwatch.start("1 Prepare Tasks");
+  if(timing) stopwatch.start("1 Prepare Tasks");
   doJobsRequiredBeforeTaskList();
-  if(timers) stopwatch.stop("1 Prepare Tasks");
+  if(timing) stopwatch.stop("1 Prepare Tasks");
 
   // Get number of threads for OpenMP
   unsigned nt=OpenMP::getNumThreads();
@@ -282,13 +287,20 @@ void ActionWithVessel::runAllTasks() {
   // Switch off calculation of derivatives in main loop
   if( dertime_can_be_off ) dertime=false;
 
-  if(timers) stopwatch.start("2 Loop over tasks");
+  // Get the per thread storage
+  setupMultiValuePool( nt );
+  if( nt>1 && omp_buffers.size()<nt ) omp_buffers.resize( nt );
+
+  if(timing) stopwatch.start("2 Loop over tasks");
   #pragma omp parallel num_threads(nt)
   {
-    std::vector<double> omp_buffer;
-    if( nt>1 ) omp_buffer.resize( bufsize, 0.0 );
-    MultiValue myvals( getNumberOfQuantities(), getNumberOfDerivatives() );
-    MultiValue bvals( getNumberOfQuantities(), getNumberOfDerivatives() );
+    // OpenMP can give fewer threads than requested, so only the buffers of this team are used
+    const unsigned nteam=OpenMP::getTeamSize();
+    unsigned tn=OpenMP::getThreadNum();
+    if( nteam>1 ) omp_buffers[tn].assign( bufsize, 0.0 );
+    std::vector<double>& omp_buffer=( nteam>1 ? omp_buffers[tn] : buffer );
+    MultiValue& myvals=*myvals_pool[tn];
+    MultiValue& bvals=*bvals_pool[tn];
     myvals.clearAll(); bvals.clearAll();
 
     #pragma omp for nowait schedule(dynamic)
@@ -308,23 +320,27 @@ void ActionWithVessel::runAllTasks() {
       // Now calculate all the functions
       // If the contribution of this quantity is very small at neighbour list time ignore it
       // untill next neighbour list time
-      if( nt>1 ) {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
-      } else {
-        calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, buffer, der_list );
-      }
+      calculateAllVessels( indexOfTaskInFullList[i], myvals, bvals, omp_buffer, der_list );
 
       // Clear the value
       myvals.clearAll();
     }
-    #pragma omp critical
-    if(nt>1) for(unsigned i=0; i<bufsize; ++i) buffer[i]+=omp_buffer[i];
+    // Reduce the thread buffers: each thread sums a different stripe of the buffer
+    if( nteam>1 ) {
+      #pragma omp barrier
+      #pragma omp for schedule(static)
+      for(unsigned i=0; i<bufsize; ++i) {
+        double sum=0.0;
+        for(unsigned j=0; j<nteam; ++j) sum+=omp_buffers[j][i];
+        buffer[i]=sum;
+      }
+    }
   }
-  if(timers) stopwatch.stop("2 Loop over tasks");
+  if(timing) stopwatch.stop("2 Loop over tasks");
   // Turn back on derivative calculation
   dertime=true;
 
-  if(timers) stopwatch.start("3 MPI gather");
+  if(timing) stopwatch.start("3 MPI gather");
   // MPI Gather everything
   if( !serial && buffer.size()>0 ) comm.Sum( buffer );
   // MPI Gather index stores
@@ -333,11 +349,25 @@ void ActionWithVessel::runAllTasks() {
   }
   // Update the elements that are makign contributions to the sum here
   // this causes problems if we do it in prepare
-  if(timers) stopwatch.stop("3 MPI gather");
+  if(timing) stopwatch.stop("3 MPI gather");
 
-  if(timers) stopwatch.start("4 Finishing computations");
+  if(timing) stopwatch.start("4 Finishing computations");
   finishComputations( buffer );
-  if(timers) stopwatch.stop("4 Finishing computations");
+  if(timing) stopwatch.stop("4 Finishing computations");
+}
+
+void ActionWithVessel::setupMultiValuePool( const unsigned& nt ) {
+  unsigned nquants=getNumberOfQuantities(), nder=getNumberOfDerivatives();
+  for(unsigned i=0; i<myvals_pool.size(); ++i) {
+    // objects are rebuilt rather than resized, so that no stale derivatives are kept
+    if( myvals_pool[i]->getNumberOfValues()!=nquants || myvals_pool[i]->getNumberOfDerivatives()!=nder ) {
+      myvals_pool[i].reset( new MultiValue( nquants, nder ) ); bvals_pool[i].reset( new MultiValue( nquants, nder ) );
+    }
+  }
+  while( myvals_pool.size()<nt ) {
+    myvals_pool.emplace_back( new MultiValue( nquants, nder ) );
+    bvals_pool.emplace_back( new MultiValue( nquants, nder ) );
+  }
 }
 
 void ActionWithVessel::transformBridgedDerivatives( const unsigned& current, MultiValue& invals, MultiValue& outvals ) const {
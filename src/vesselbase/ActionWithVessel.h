@@ -28,6 +28,7 @@
 #include "tools/DynamicList.h"
 #include "tools/MultiValue.h"
 #include <vector>
+#include <algorithm>
 #include "tools/ForwardDecl.h"
 
 namespace PLMD {
@@ -85,6 +86,12 @@ private:
   std::vector<unsigned> der_list;
 /// The buffer that we use (we keep a copy here to avoid resizing)
   std::vector<double> buffer;
+/// The buffers used by each OpenMP thread (we keep a copy here to avoid resizing)
+  std::vector<std::vector<double> > omp_buffers;
+/// The MultiValue objects used by each OpenMP thread (we keep them here to avoid reconstructing them at every step)
+  std::vector<std::unique_ptr<MultiValue> > myvals_pool, bvals_pool;
+/// Make sure there are MultiValue objects of the right size for nt threads
+  void setupMultiValuePool( const unsigned& nt );
 /// Do we want to output information on the timings of different parts of the calculation
   bool timers;
   ForwardDecl<Stopwatch> stopwatch_fwd;
@@ -280,9 +287,9 @@ inline
 unsigned ActionWithVessel::getPositionInCurrentTaskList( const unsigned& myind ) const {
   if( nactive_tasks==fullTaskList.size() ) return myind;
 
-  for(unsigned i=0; i<nactive_tasks; ++i) {
-    if( myind==indexOfTaskInFullList[i] ) return i;
-  }
+  // The active tasks are stored in the order they appear in the full list so we can use a binary search
+  std::vector<unsigned>::const_iterator it=std::lower_bound( indexOfTaskInFullList.begin(), indexOfTaskInFullList.begin()+nactive_tasks, myind );
+  if( it!=indexOfTaskInFullList.begin()+nactive_tasks && *it==myind ) return it - indexOfTaskInFullList.begin();
   plumed_merror("requested task is not active");
 }
 
@@ -591,6 +591,26 @@ typedef struct {
   void (*handler)(void*,int,const char*,const void*);
 } plumed_nothrow_handler;
 
+/**
+  \brief Per-step data passed with a single call.
+
+  Used as `plumed_cmd(p,"setStepData",&data)`. It is equivalent to calling
+  "setStepLong" followed by "setBox", "setPositions", "setMasses", "setCharges",
+  "setForces", "setVirial" and "setEnergy", skipping those whose pointer is NULL.
+  Pointers should refer to reals of the precision set with "setRealPrecision".
+  Available as of API version 7.
+*/
+typedef struct {
+  long int step;
+  const void* box;
+  const void* positions;
+  const void* masses;
+  const void* charges;
+  void* forces;
+  void* virial;
+  const void* energy;
+} plumed_step_data;
+
 /** \relates plumed
     \brief Constructor
 